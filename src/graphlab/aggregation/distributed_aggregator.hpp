@@ -923,6 +923,42 @@ namespace graphlab {
     }
 
 
+    /**
+     * Saves the state of the periodic schedule. Each key is stored
+     * together with the number of seconds remaining until it is next
+     * triggered so that the schedule can be restored by load_schedule()
+     * in a later run of the engine.
+     */
+    void save_schedule(oarchive& oarc) const {
+      float curtime = timer::approx_time_seconds() - start_time;
+      std::vector<std::pair<std::string, float> > remaining;
+      // the first element of the heap is unused
+      for (size_t i = 1;i < schedule.values().size(); ++i) {
+        remaining.push_back(std::make_pair(schedule.values()[i].first,
+                                          -schedule.values()[i].second - curtime));
+      }
+      oarc << remaining;
+    }
+
+    /**
+     * Restores a schedule previously stored with save_schedule().
+     * Must be called after start(). Keys which are not registered
+     * as periodic aggregators in this run are ignored.
+     */
+    void load_schedule(iarchive& iarc) {
+      std::vector<std::pair<std::string, float> > remaining;
+      iarc >> remaining;
+      float curtime = timer::approx_time_seconds() - start_time;
+      schedule_lock.lock();
+      for (size_t i = 0;i < remaining.size(); ++i) {
+        if (aggregate_period.count(remaining[i].first) == 0) continue;
+        float next_time = curtime + std::max(remaining[i].second, 0.0f);
+        schedule.push_or_update(remaining[i].first, -next_time);
+      }
+      schedule_lock.unlock();
+    }
+
+
     std::set<std::string> get_all_periodic_keys() const {
       typename std::map<std::string, float>::const_iterator iter =
                                                     aggregate_period.begin();
@@ -28,6 +28,7 @@
 
 #include <deque>
 #include <boost/bind.hpp>
+#include <boost/type_traits/is_pod.hpp>
 
 #include <graphlab/scheduler/ischeduler.hpp>
 #include <graphlab/scheduler/scheduler_factory.hpp>
@@ -49,6 +50,7 @@
 #include <graphlab/parallel/fiber_group.hpp>
 #include <graphlab/parallel/fiber_control.hpp>
 #include <graphlab/rpc/fiber_async_consensus.hpp>
+#include <graphlab/rpc/fiber_buffered_exchange.hpp>
 #include <graphlab/aggregation/distributed_aggregator.hpp>
 #include <graphlab/parallel/fiber_remote_request.hpp>
 #include <graphlab/macros_def.hpp>
@@ -63,10 +65,10 @@ namespace graphlab {
    *
    * \brief The asynchronous consistent engine executed vertex programs
    * asynchronously and can ensure mutual exclusion such that adjacent vertices
-   * are never executed simultaneously. The default mode is "factorized"
+   * are never executed simultaneously. The default mode is "edge"
    * consistency in which only individual gathers/applys/
    * scatters are guaranteed to be consistent, but this can be strengthened to
-   * provide full mutual exclusion.
+   * provide full mutual exclusion, or weakened to "vertex" consistency.
    *
    *
    * \tparam VertexProgram
@@ -194,10 +196,22 @@ namespace graphlab {
    * run for. The actual runtime may be marginally greater as the engine
    * waits for all threads and processes to flush all active tasks before
    * returning.
-   * \li \b factorized (default: true) Set to true to weaken the consistency
-   * model to factorized consistency where only individual gather/apply/scatter
-   * calls are guaranteed to be locally consistent. Can produce massive
-   * increases in throughput at a consistency penalty.
+   * \li \b consistency (default: edge) The consistency model.
+   *   - \c full : adjacent vertices never run at the same time. The
+   *     locks are acquired with the Chandy-Misra algorithm.
+   *   - \c edge : factorized consistency, where only individual
+   *     gather/apply/scatter calls on an edge are guaranteed to be locally
+   *     consistent. Can produce massive increases in throughput at a
+   *     consistency penalty.
+   *   - \c vertex : only one program runs on a vertex at a time. The
+   *     mirrors receive the new vertex data lazily in batches, so gathers
+   *     and scatters may see stale neighbors. When the vertex and edge
+   *     data are POD, gathers and scatters also take no locks and may read
+   *     neighbors while they are being written; otherwise each edge is
+   *     still locked as in edge consistency. Only for programs which
+   *     tolerate stale neighbor reads, such as PageRank.
+   * \li \b factorized (default: true) Same as consistency=edge when true,
+   * and consistency=full when false.
    * \li \b nfibers (default: 10000) Number of fibers to use
    * \li \b stacksize (default: 16384) Stacksize of each fiber.
    */
@@ -396,8 +410,47 @@ namespace graphlab {
     /// Defaults to (-1), defines a timeout
     size_t timed_termination;
  
-    /// engine option. Sets to true if factorized consistency is used
-    bool factorized_consistency;
+    /// The consistency models of the consistency engine option
+    enum consistency_type {
+      VERTEX_CONSISTENCY,
+      EDGE_CONSISTENCY,
+      FULL_CONSISTENCY
+    };
+
+    /// engine option. The consistency model
+    consistency_type consistency;
+
+    /// False when gathers and scatters read and write the edges without
+    /// locking them. Only under vertex consistency with POD data, since a
+    /// racy read of any other type is undefined.
+    bool lock_edges;
+
+    /**
+     * The version of the data of each vertex. Incremented by the master
+     * on every apply under vertex consistency, and used by the mirrors
+     * to drop updates which arrive after a newer one.
+     */
+    std::vector<size_t> vertex_versions;
+
+    /// The new data of a vertex a master sends to its mirrors to scatter
+    /// under vertex consistency
+    struct mirror_scatter_type {
+      vertex_id_type vid;
+      size_t version;
+      vertex_program_type vprog;
+      vertex_data_type vdata;
+      void save(oarchive& oarc) const {
+        oarc << vid << version << vprog << vdata;
+      }
+      void load(iarchive& iarc) {
+        iarc >> vid >> version >> vprog >> vdata;
+      }
+    };
+    typedef fiber_buffered_exchange<mirror_scatter_type> mirror_exchange_type;
+
+    /// Batches the scatters sent to the mirrors under vertex consistency,
+    /// NULL otherwise
+    mirror_exchange_type* mirror_exchange;
 
     bool endgame_mode;
 
@@ -446,7 +499,9 @@ namespace graphlab {
       nfibers = 10000;
       stacksize = 16384;
       use_cache = false;
-      factorized_consistency = true;
+      consistency = EDGE_CONSISTENCY;
+      lock_edges = true;
+      mirror_exchange = NULL;
       track_task_time = false;
       timed_termination = (size_t)(-1);
       termination_reason = execution_status::UNSET;
@@ -481,9 +536,23 @@ namespace graphlab {
           if (rmi.procid() == 0)
             logstream(LOG_EMPH) << "Engine Option: timeout = " << timed_termination << std::endl;
         } else if (opt == "factorized") {
-          opts.get_engine_args().get_option("factorized", factorized_consistency);
+          bool factorized = true;
+          opts.get_engine_args().get_option("factorized", factorized);
+          consistency = factorized ? EDGE_CONSISTENCY : FULL_CONSISTENCY;
+          if (rmi.procid() == 0)
+            logstream(LOG_EMPH) << "Engine Option: factorized = " << factorized << std::endl;
+        } else if (opt == "consistency") {
+          std::string model;
+          opts.get_engine_args().get_option("consistency", model);
+          if (model == "vertex") consistency = VERTEX_CONSISTENCY;
+          else if (model == "edge") consistency = EDGE_CONSISTENCY;
+          else if (model == "full") consistency = FULL_CONSISTENCY;
+          else {
+            logstream(LOG_FATAL) << "Invalid consistency model: " << model
+                                 << ". Expected vertex, edge or full" << std::endl;
+          }
           if (rmi.procid() == 0)
-            logstream(LOG_EMPH) << "Engine Option: factorized = " << factorized_consistency << std::endl;
+            logstream(LOG_EMPH) << "Engine Option: consistency = " << model << std::endl;
         } else if (opt == "nfibers") {
           opts.get_engine_args().get_option("nfibers", nfibers);
           if (rmi.procid() == 0)
@@ -517,7 +586,7 @@ namespace graphlab {
       rmi.barrier();
 
       // create initial fork arrangement based on the alternate vid mapping
-      if (factorized_consistency == false) {
+      if (consistency == FULL_CONSISTENCY) {
         cmlocks = new distributed_chandy_misra<graph_type>(rmi.dc(), graph,
                                                     boost::bind(&engine_type::lock_ready, this, _1));
                                                     
@@ -528,6 +597,21 @@ namespace graphlab {
 
       // construct the termination consensus object
       consensus = new fiber_async_consensus(rmi.dc(), nfibers);
+
+      // the received scatters must wake up the fibers waiting for
+      // termination to run them
+      if (consistency == VERTEX_CONSISTENCY) {
+        lock_edges = !(boost::is_pod<vertex_data_type>::value &&
+                       boost::is_pod<edge_data_type>::value);
+        if (lock_edges && rmi.procid() == 0) {
+          logstream(LOG_WARNING) << "Vertex consistency still locks the edges "
+                                 << "since the vertex or edge data is not POD"
+                                 << std::endl;
+        }
+        mirror_exchange = new mirror_exchange_type(rmi.dc());
+        mirror_exchange->set_recv_callback(
+            boost::bind(&fiber_async_consensus::cancel, consensus));
+      }
     }
 
     /**
@@ -543,6 +627,9 @@ namespace graphlab {
       scheduler_ptr->set_num_vertices(graph.num_local_vertices());
       messages.resize(graph.num_local_vertices());
       vertexlocks.resize(graph.num_local_vertices());
+      if (consistency == VERTEX_CONSISTENCY) {
+        vertex_versions.resize(graph.num_local_vertices(), 0);
+      }
       program_running.resize(graph.num_local_vertices());
       hasnext.resize(graph.num_local_vertices());
       if (use_cache) {
@@ -550,7 +637,7 @@ namespace graphlab {
         has_cache.resize(graph.num_local_vertices());
         has_cache.clear();
       }
-      if (!factorized_consistency) {
+      if (consistency == FULL_CONSISTENCY) {
         cm_handles.resize(graph.num_local_vertices());
       }
       rmi.barrier();
@@ -560,6 +647,7 @@ namespace graphlab {
 
   public:
     ~async_consistent_engine() {
+      delete mirror_exchange;
       delete consensus;
       delete cmlocks;
       delete scheduler_ptr;
@@ -801,6 +889,25 @@ namespace graphlab {
       }
     }
 
+    /**
+     * \internal
+     * Called by one thread on every machine when the fibers terminate,
+     * and before they are first launched. Starts the next round held
+     * back by the scheduler (see start_next_scheduler_round()), and
+     * returns false if there is none or if any machine was stopped.
+     */
+    bool start_next_round() {
+      if (!start_next_scheduler_round(rmi, *scheduler_ptr,
+              termination_reason != execution_status::RUNNING)) {
+        return false;
+      }
+      consensus->reset();
+      endgame_mode = false;
+      rmi.dc().set_fast_track_requests(false);
+      rmi.barrier();
+      return true;
+    }
+
     void set_endgame_mode() {
         if (!endgame_mode) logstream(LOG_EMPH) << "Endgame mode\n";
         endgame_mode = true;
@@ -824,10 +931,14 @@ namespace graphlab {
       fiber_control::yield();
       logstream(LOG_DEBUG) << rmi.procid() << "-" << threadid << ": " << "Termination Attempt " << std::endl;
       has_sched_msg = false;
+      // the scatters buffered by this worker must be on their way
+      if (mirror_exchange != NULL) mirror_exchange->partial_flush();
       consensus->begin_done_critical_section(threadid);
       sched_status::status_enum stat = 
           get_next_sched_task(threadid, sched_lvid, msg);
-      if (stat == sched_status::EMPTY || force_stop) {
+      const bool has_mirror_scatters = 
+          mirror_exchange != NULL && !mirror_exchange->empty();
+      if ((stat == sched_status::EMPTY && !has_mirror_scatters) || force_stop) {
         logstream(LOG_DEBUG) << rmi.procid() << "-" << threadid <<  ": "
                              << "\tTermination Double Checked" << std::endl;
 
@@ -850,7 +961,7 @@ namespace graphlab {
         logstream(LOG_DEBUG) << rmi.procid() << "-" << threadid <<  ": "
                              << "\tCancelled by Scheduler Task" << std::endl;
         consensus->cancel_critical_section(threadid);
-        has_sched_msg = true;
+        has_sched_msg = stat != sched_status::EMPTY;
         return false;
       }
     } // end of try to quit
@@ -871,6 +982,19 @@ namespace graphlab {
     }
 
 
+    /// Locks both ends of an edge, unless lock_edges is false
+    inline void lock_edge(lvid_type a, lvid_type b) {
+      if (!lock_edges) return;
+      vertexlocks[std::min(a,b)].lock();
+      vertexlocks[std::max(a,b)].lock();
+    }
+
+    inline void unlock_edge(lvid_type a, lvid_type b) {
+      if (!lock_edges) return;
+      vertexlocks[a].unlock();
+      vertexlocks[b].unlock();
+    }
+
     conditional_gather_type perform_gather(vertex_id_type vid,
                                vertex_program_type& vprog_) {
       vertex_program_type vprog = vprog_;
@@ -891,11 +1015,9 @@ namespace graphlab {
         foreach(local_edge_type local_edge, local_vertex.in_edges()) {
           edge_type edge(local_edge);
           lvid_type a = edge.source().local_id(), b = edge.target().local_id();
-          vertexlocks[std::min(a,b)].lock();
-          vertexlocks[std::max(a,b)].lock();
+          lock_edge(a, b);
           accum += vprog.gather(context, vertex, edge);
-          vertexlocks[a].unlock();
-          vertexlocks[b].unlock();
+          unlock_edge(a, b);
         }
       } 
       // do out edges
@@ -903,11 +1025,9 @@ namespace graphlab {
         foreach(local_edge_type local_edge, local_vertex.out_edges()) {
           edge_type edge(local_edge);
           lvid_type a = edge.source().local_id(), b = edge.target().local_id();
-          vertexlocks[std::min(a,b)].lock();
-          vertexlocks[std::max(a,b)].lock();
+          lock_edge(a, b);
           accum += vprog.gather(context, vertex, edge);
-          vertexlocks[a].unlock();
-          vertexlocks[b].unlock();
+          unlock_edge(a, b);
         }
       } 
       if (use_cache) {
@@ -927,27 +1047,23 @@ namespace graphlab {
         foreach(local_edge_type local_edge, local_vertex.in_edges()) {
           edge_type edge(local_edge);
           lvid_type a = edge.source().local_id(), b = edge.target().local_id();
-          vertexlocks[std::min(a,b)].lock();
-          vertexlocks[std::max(a,b)].lock();
+          lock_edge(a, b);
           vprog.scatter(context, vertex, edge);
-          vertexlocks[a].unlock();
-          vertexlocks[b].unlock();
+          unlock_edge(a, b);
         }
       } 
       if(scatter_dir == OUT_EDGES || scatter_dir == ALL_EDGES) {
         foreach(local_edge_type local_edge, local_vertex.out_edges()) {
           edge_type edge(local_edge);
           lvid_type a = edge.source().local_id(), b = edge.target().local_id();
-          vertexlocks[std::min(a,b)].lock();
-          vertexlocks[std::max(a,b)].lock();
+          lock_edge(a, b);
           vprog.scatter(context, vertex, edge);
-          vertexlocks[a].unlock();
-          vertexlocks[b].unlock();
+          unlock_edge(a, b);
         }
       } 
 
       // release locks
-      if (!factorized_consistency) {
+      if (consistency == FULL_CONSISTENCY) {
         cmlocks->philosopher_stops_eating_per_replica(lvid);
       }
     }
@@ -965,6 +1081,35 @@ namespace graphlab {
     }
 
 
+    /**
+     * \internal
+     * Runs the scatters the masters sent to the mirrors on this machine
+     * under vertex consistency.
+     */
+    void receive_mirror_scatters() {
+      if (mirror_exchange->empty()) return;
+      typename mirror_exchange_type::recv_buffer_type buffers;
+      while (mirror_exchange->recv(buffers)) {
+        for (size_t i = 0; i < buffers.size(); ++i) {
+          foreach(mirror_scatter_type& update, buffers[i].buffer) {
+            lvid_type lvid = graph.local_vid(update.vid);
+            // the batches of a master may be received out of order.
+            // Never overwrite newer data, but still scatter so that
+            // no signal is lost.
+            vertexlocks[lvid].lock();
+            if (update.version > vertex_versions[lvid]) {
+              vertex_versions[lvid] = update.version;
+              graph.l_vertex(lvid).data() = update.vdata;
+            }
+            vertexlocks[lvid].unlock();
+            vertex_program_type vprog = update.vprog;
+            perform_scatter_local(lvid, vprog);
+          }
+        }
+      }
+    }
+
+
     // make sure I am the only person running.
     // if returns false, the message has been dropped into the message array.
     // quit
@@ -1030,7 +1175,10 @@ namespace graphlab {
       /**************************************************************************/
       /*                             Acquire Locks                              */
       /**************************************************************************/
-      if (!factorized_consistency) {
+      // a vertex with no mirrors whose neighbors are idle takes its
+      // forks at once
+      if (consistency == FULL_CONSISTENCY &&
+          !cmlocks->try_make_philosopher_eat(lvid)) {
         // begin lock acquisition
         cm_handles[lvid] = new vertex_fiber_cm_handle;
         cm_handles[lvid]->philosopher_ready = false;
@@ -1079,8 +1227,10 @@ namespace graphlab {
      /**************************************************************************/
      /*                              apply phase                               */
      /**************************************************************************/
+     size_t version = 0;
      vertexlocks[lvid].lock();
      vprog.apply(context, vertex, gather_result.value);      
+     if (mirror_exchange != NULL) version = ++vertex_versions[lvid];
      vertexlocks[lvid].unlock();
 
 
@@ -1099,14 +1249,26 @@ namespace graphlab {
      }*/
 
      std::vector<request_future<void> > scatter_futures;
-     foreach(procid_t mirror, local_vertex.mirrors()) {
-       scatter_futures.push_back(
-           object_fiber_remote_request(rmi, 
-                                       mirror, 
-                                       &async_consistent_engine::perform_scatter, 
-                                       vid,
-                                       vprog,
-                                       local_vertex.data()));
+     if (mirror_exchange != NULL) {
+       // under vertex consistency the mirrors catch up lazily
+       mirror_scatter_type update;
+       update.vid = vid;
+       update.version = version;
+       update.vprog = vprog;
+       update.vdata = local_vertex.data();
+       foreach(procid_t mirror, local_vertex.mirrors()) {
+         mirror_exchange->send(mirror, update);
+       }
+     } else {
+       foreach(procid_t mirror, local_vertex.mirrors()) {
+         scatter_futures.push_back(
+             object_fiber_remote_request(rmi, 
+                                         mirror, 
+                                         &async_consistent_engine::perform_scatter, 
+                                         vid,
+                                         vprog,
+                                         local_vertex.data()));
+       }
      }
      perform_scatter_local(lvid, vprog);
      for(size_t i = 0;i < scatter_futures.size(); ++i) 
@@ -1117,7 +1279,7 @@ namespace graphlab {
       /************************************************************************/
       // the scatter is used to release the chandy misra
       // here I cleanup
-      if (!factorized_consistency) {
+      if (consistency == FULL_CONSISTENCY) {
         delete cm_handles[lvid];
         cm_handles[lvid] = NULL;
       }
@@ -1142,8 +1304,18 @@ namespace graphlab {
 
       message_type msg;
       float last_aggregator_check = timer::approx_time_seconds();
+      float last_mirror_flush = last_aggregator_check;
       timer ti; ti.start();
       while(1) {
+        if (mirror_exchange != NULL) {
+          receive_mirror_scatters();
+          // send the buffered scatters at least every tick
+          if (timer::approx_time_seconds() != last_mirror_flush) {
+            last_mirror_flush = timer::approx_time_seconds();
+            mirror_exchange->partial_flush();
+          }
+        }
+
         if (timer::approx_time_seconds() != last_aggregator_check && !endgame_mode) {
           last_aggregator_check = timer::approx_time_seconds();
           std::string key = aggregator.tick_asynchronous();
@@ -1240,11 +1412,15 @@ namespace graphlab {
       thrgroup.set_stacksize(stacksize);
         
       size_t effncpus = std::min(ncpus, fiber_control::get_instance().num_workers());
-      for (size_t i = 0; i < nfibers ; ++i) {
-        thrgroup.launch(boost::bind(&engine_type::thread_start, this, i), 
-                        i % effncpus);
-      }
-      thrgroup.join();
+      // run the rounds held back by the scheduler one after the other
+      start_next_round();
+      do {
+        for (size_t i = 0; i < nfibers ; ++i) {
+          thrgroup.launch(boost::bind(&engine_type::thread_start, this, i), 
+                          i % effncpus);
+        }
+        thrgroup.join();
+      } while (start_next_round());
       aggregator.stop();
       // if termination reason was not changed, then it must be depletion
       if (termination_reason == execution_status::RUNNING) {
@@ -688,6 +688,9 @@ class distributed_chandy_misra {
 
     // now forks are dirty
     foreach(local_edge_type edge, lvertex.in_edges()) {
+      // placing a request needs my lock, so if there is none the fork
+      // stays and the neighbor need not be locked
+      if (!(forkset[edge.id()] & REQUEST_0)) continue;
       try_acquire_edge_with_backoff(edge.target().id(), edge.source().id());
       lvid_type other = edge.source().id();
       if (philosopherset[p_id].state == THINKING) {
@@ -710,6 +713,7 @@ class distributed_chandy_misra {
     }
 
     foreach(local_edge_type edge, lvertex.out_edges()) {
+      if (!(forkset[edge.id()] & REQUEST_1)) continue;
       try_acquire_edge_with_backoff(edge.source().id(), edge.target().id());
       lvid_type other = edge.target().id();
       if (philosopherset[p_id].state == THINKING) {
@@ -770,6 +774,73 @@ class distributed_chandy_misra {
     philosopherset[p_id].counter = graph.l_vertex(p_id).num_mirrors() + 1;
   }
   
+  /**
+   * Fast path for a philosopher with no mirrors, which must be
+   * THINKING. The forks held by THINKING neighbors are taken with
+   * try_lock only, so no lock is waited on and no message is sent. If
+   * that gets all the forks, the philosopher goes straight to EATING
+   * without calling the callback and true is returned. Otherwise the
+   * philosopher stays THINKING, keeping the forks it took dirty so that
+   * the neighbors may take them back, and make_philosopher_hungry()
+   * must be called instead.
+   */
+  bool try_make_philosopher_eat(lvid_type p_id) {
+    local_vertex_type lvertex(graph.l_vertex(p_id));
+    if (lvertex.num_mirrors() > 0) return false;
+    philosopherset[p_id].lock.lock();
+    bool ready = true;
+    foreach(local_edge_type edge, lvertex.in_edges()) {
+      if (!try_take_fork_locked(edge.id(), p_id, edge.source().id(),
+                                OWNER_TARGET)) {
+        ready = false;
+        break;
+      }
+    }
+    if (ready) {
+      foreach(local_edge_type edge, lvertex.out_edges()) {
+        if (!try_take_fork_locked(edge.id(), p_id, edge.target().id(),
+                                  OWNER_SOURCE)) {
+          ready = false;
+          break;
+        }
+      }
+    }
+    if (ready) {
+      // a new lock ID voids cancellations aimed at the previous one
+      philosopherset[p_id].lockid = !philosopherset[p_id].lockid;
+      philosopherset[p_id].state = EATING;
+      philosopherset[p_id].counter = 0;
+      philosopherset[p_id].cancellation_sent = false;
+    }
+    philosopherset[p_id].lock.unlock();
+    return ready;
+  }
+
+  /**
+   * Takes the fork of an edge for self, which is its owner side and
+   * whose lock is held, from the neighbor other if other is THINKING
+   * and its lock is free. Returns true if self then owns the fork. An
+   * owned fork the neighbor requested counts as not owned, so that the
+   * fast path does not starve the neighbor.
+   */
+  inline bool try_take_fork_locked(size_t forkid, lvid_type self,
+                                   lvid_type other, unsigned char owner) {
+    if (fork_owner(forkid) == owner) {
+      return !(forkset[forkid] & request_bit(!owner));
+    }
+    if (!philosopherset[other].lock.try_lock()) return false;
+    bool taken = false;
+    // a THINKING philosopher gives away its dirty forks on request
+    if (philosopherset[other].state == THINKING && fork_dirty(forkid)) {
+      forkset[forkid] = owner | DIRTY_BIT;
+      philosopherset[other].forks_acquired--;
+      philosopherset[self].forks_acquired++;
+      taken = true;
+    }
+    philosopherset[other].lock.unlock();
+    return taken;
+  }
+
   void make_philosopher_hungry(lvid_type p_id) {
     local_vertex_type lvertex(graph.l_vertex(p_id));    
 //    ASSERT_EQ(rec.get_owner(), rmi.procid());
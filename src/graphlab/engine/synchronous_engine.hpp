@@ -44,6 +44,7 @@
 #include <graphlab/parallel/fiber_barrier.hpp>
 #include <graphlab/util/tracepoint.hpp>
 #include <graphlab/util/memory_info.hpp>
+#include <graphlab/util/frontier_bitset.hpp>
 
 #include <graphlab/rpc/dc_dist_object.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
@@ -188,17 +189,64 @@ namespace graphlab {
    * or update (\ref icontext::post_delta) the cache values of
    * neighboring vertices during the scatter phase.
    *
+   * \li <b>adaptive_cache</b>: (default: false) Implies use_cache.
+   * The engine tracks, for each vertex, how many consecutive cached
+   * gathers were invalidated (\ref icontext::clear_gather_cache) before
+   * they could be reused. Caching is disabled for vertices whose cache is
+   * invalidated \b cache_disable_threshold times in a row, releasing
+   * their cache entry.
+   *
+   * \li <b>cache_disable_threshold</b>: (default: 3) The number of
+   * consecutive invalidations after which adaptive caching gives up on a
+   * vertex. Must be between 1 and 255.
+   *
+   * When caching is enabled the number of cache hits, misses and
+   * invalidations is reported through the event log (and therefore the
+   * metrics server) and summarized at the end of start().
+   *
+   * \li <b>direction_optimizing</b>: (default: false) Enables
+   * frontier adaptive push/pull execution for push style vertex
+   * programs which implement \ref ivertex_program::pull_edges. While
+   * the frontier (the vertices which scatter after apply) is small the
+   * engine runs normally and updates are pushed through scatter and
+   * messages. Once the edges adjacent to the frontier exceed
+   * |E| / \b pull_alpha the scatter is skipped and the next super-steps
+   * run every vertex, gathering over
+   * \ref ivertex_program::pull_edges instead. The engine switches back
+   * to pushing once fewer than |V| / \b push_beta vertices scatter.
+   *
+   * \li <b>pull_alpha</b>: (default: 20) See direction_optimizing.
+   *
+   * \li <b>push_beta</b>: (default: 24) See direction_optimizing.
+   *
+   * \li <b>sparse_frontier_threshold</b>: (default: 1/64) While fewer
+   * than this fraction of the local vertices are signaled or active,
+   * the engine keeps a list of them and each minor-step only visits
+   * the listed vertices instead of scanning the whole active bitset.
+   * Setting it to 0 always scans the bitset.
+   *
    * \li \b snapshot_interval If set to a positive value, a snapshot
    * is taken every this number of iterations. If set to 0, a snapshot
    * is taken before the first iteration. If set to a negative value,
    * no snapshots are taken. Defaults to -1. A snapshot is a binary
-   * dump of the graph.
+   * dump of the graph (in the format of
+   * \ref graphlab::distributed_graph::save_binary) together with the
+   * engine state: the pending messages, the gather cache, the iteration
+   * counter and the schedule of the periodic aggregators. The snapshot is
+   * serialized in memory at the end of the super-step and written to disk
+   * in the background while computation continues.
    *
    * \li \b snapshot_path If snapshot_interval is set to a value >=0,
    * this option must be specified and should contain a target basename
    * for the snapshot. The path including folder and file prefix in
    * which the snapshots should be saved.
    *
+   * \li \b resume_from If set, the engine restores the graph and the
+   * engine state from the snapshot with this basename on start() and
+   * continues execution from the iteration at which the snapshot was
+   * taken. The snapshot must have been taken with the same number of
+   * machines and the same vertex program.
+   *
    * \see graphlab::omni_engine
    * \see graphlab::async_consistent_engine
    * \see graphlab::semi_synchronous_engine
@@ -373,6 +421,56 @@ namespace graphlab {
     */
     bool use_cache;
 
+    /**
+     * \brief When set, caching is disabled for vertices whose cached
+     * gather is repeatedly invalidated before it is reused.
+     */
+    bool adaptive_cache;
+
+    /**
+     * \brief The number of consecutive invalidations after which
+     * adaptive caching is disabled for a vertex.
+     */
+    size_t cache_disable_threshold;
+
+    /**
+     * \brief Enables switching between push (scatter) and pull
+     * (gather over \ref ivertex_program::pull_edges) super-steps
+     * depending on the size of the frontier.
+     */
+    bool direction_optimizing;
+
+    /**
+     * \brief Switch to pull when the frontier is adjacent to more than
+     * num_edges / pull_alpha edges.
+     */
+    double pull_alpha;
+
+    /**
+     * \brief Switch back to push when fewer than num_vertices / push_beta
+     * vertices are in the frontier.
+     */
+    double push_beta;
+
+    /**
+     * \brief The fraction of active vertices below which the engine
+     * iterates over lists of the active vertices rather than over
+     * their bitsets.
+     */
+    double sparse_frontier_threshold;
+
+    /**
+     * \brief True if the current super-step is a pull super-step in
+     * which all vertices gather over their pull edges.
+     */
+    bool pull_superstep;
+
+    /**
+     * \brief The number of vertices (masters) which scatter in the
+     * current super-step and the number of edges they scatter over.
+     */
+    atomic<size_t> frontier_vertices, frontier_edges;
+
     /**
      * \brief A snapshot is taken every this number of iterations.
      * If snapshot_interval == 0, a snapshot is only taken before the first
@@ -383,6 +481,17 @@ namespace graphlab {
     /// \brief The target base name the snapshot is saved in.
     std::string snapshot_path;
 
+    /**
+     * \brief The base name of a snapshot to restore on the next call
+     * to start(). Empty if the engine is not resuming.
+     */
+    std::string resume_path;
+
+    /**
+     * \brief The background thread writing out the last snapshot.
+     */
+    thread_group snapshot_writer;
+
     /**
      * \brief A counter that tracks the current iteration number since
      * start was last invoked.
@@ -443,7 +552,7 @@ namespace graphlab {
     /**
      * \brief Bit indicating whether a message is present for each vertex.
      */
-    dense_bitset has_message;
+    frontier_bitset has_message;
 
 
     /**
@@ -485,11 +594,30 @@ namespace graphlab {
      */
     dense_bitset has_cache;
 
+    /**
+     * \brief The number of consecutive cached gathers of each vertex
+     * which were invalidated before being reused. Only allocated with
+     * adaptive caching, and modified while holding the vertex lock.
+     */
+    std::vector<unsigned char> cache_invalidations;
+
+    /**
+     * \brief A bit indicating that adaptive caching has given up on
+     * caching the gather of that vertex.
+     */
+    dense_bitset cache_disabled;
+
+    /**
+     * \brief Counters of gathers served from the cache, gathers that
+     * had to be recomputed and cache entries that were invalidated.
+     */
+    atomic<size_t> num_cache_hits, num_cache_misses, num_cache_invalidations;
+
     /**
      * \brief A bit (for master vertices) indicating if that vertex is active
      * (received a message on this iteration).
      */
-    dense_bitset active_superstep;
+    frontier_bitset active_superstep;
 
     /**
      * \brief  The number of local vertices (masters) that are active on this
@@ -501,7 +629,7 @@ namespace graphlab {
      * \brief A bit indicating (for all vertices) whether to
      * participate in the current minor-step (gather or scatter).
      */
-    dense_bitset active_minorstep;
+    frontier_bitset active_minorstep;
 
     /**
      * \brief A counter measuring the number of applys that have been completed
@@ -591,6 +719,9 @@ namespace graphlab {
     DECLARE_EVENT(EVENT_GATHERS);
     DECLARE_EVENT(EVENT_SCATTERS);
     DECLARE_EVENT(EVENT_ACTIVE_CPUS);
+    DECLARE_EVENT(EVENT_CACHE_HITS);
+    DECLARE_EVENT(EVENT_CACHE_MISSES);
+    DECLARE_EVENT(EVENT_CACHE_INVALIDATIONS);
   public:
 
     /**
@@ -876,6 +1007,28 @@ namespace graphlab {
      */
     void execute_scatters(size_t thread_id);
 
+    /**
+     * \brief Clear the vertex programs of all vertices which were
+     * going to scatter. Used in place of execute_scatters when the
+     * direction optimizing engine switches to pull.
+     *
+     * @param thread_id the thread to run this as which determines
+     * which vertices to process.
+     */
+    void skip_scatters(size_t thread_id);
+
+    /**
+     * \brief Returns the edges to gather over in the current
+     * super-step: the pull edges on a pull super-step and the gather
+     * edges otherwise.
+     */
+    edge_dir_type gather_direction(icontext_type& context,
+                                   const vertex_program_type& vprog,
+                                   const vertex_type& vertex) const {
+      return pull_superstep ? vprog.pull_edges(context, vertex) :
+                              vprog.gather_edges(context, vertex);
+    }
+
     // Data Synchronization ===================================================
     /**
      * \brief Send the vertex program for the local vertex id to all
@@ -951,6 +1104,53 @@ namespace graphlab {
      */
     void recv_messages();
 
+    // Snapshots ==============================================================
+    /**
+     * \brief Take a snapshot of the graph and the engine state.
+     *
+     * The graph and the engine state are serialized into memory and
+     * then written to disk by a background thread. Any previous snapshot
+     * still being written is completed first. Must be called on all
+     * machines simultaneously between super-steps.
+     */
+    void save_snapshot();
+
+    /**
+     * \brief Restore the graph and the engine state from the snapshot
+     * with the given basename. Must be called on all machines
+     * simultaneously after the aggregator has been started.
+     *
+     * @return true on success and false if the snapshot cannot be read.
+     */
+    bool load_snapshot(const std::string& prefix);
+
+    /**
+     * \brief Serialize the engine state which is not recoverable from
+     * the graph.
+     */
+    void save_engine_state(oarchive& oarc) const;
+
+    /**
+     * \brief Deserialize the engine state previously saved with
+     * save_engine_state().
+     */
+    void load_engine_state(iarchive& iarc);
+
+    /**
+     * \brief Compress and write a serialized buffer to a file, taking
+     * ownership of the buffer. Called by the background writer.
+     */
+    static void write_snapshot_file(std::string fname, char* buf, size_t len);
+
+    /**
+     * \brief Write the graph and the engine state files of a snapshot.
+     * This is the entry point of the background writer.
+     */
+    static void write_snapshot_files(std::string graph_fname,
+                                     char* graph_buf, size_t graph_len,
+                                     std::string engine_fname,
+                                     char* engine_buf, size_t engine_len);
+
 
   }; // end of class synchronous engine
 
@@ -1017,6 +1217,13 @@ namespace graphlab {
     std::vector<std::string> keys = opts.get_engine_args().get_option_keys();
     per_thread_compute_time.resize(opts.get_ncpus());
     use_cache = false;
+    direction_optimizing = false;
+    pull_alpha = 20;
+    push_beta = 24;
+    sparse_frontier_threshold = 1.0 / 64;
+    pull_superstep = false;
+    adaptive_cache = false;
+    cache_disable_threshold = 3;
     foreach(std::string opt, keys) {
       if (opt == "max_iterations") {
         opts.get_engine_args().get_option("max_iterations", max_iterations);
@@ -1033,6 +1240,39 @@ namespace graphlab {
         if (rmi.procid() == 0)
           logstream(LOG_EMPH) << "Engine Option: use_cache = "
             << use_cache << std::endl;
+      } else if (opt == "adaptive_cache") {
+        opts.get_engine_args().get_option("adaptive_cache", adaptive_cache);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: adaptive_cache = "
+            << adaptive_cache << std::endl;
+      } else if (opt == "cache_disable_threshold") {
+        opts.get_engine_args().get_option("cache_disable_threshold",
+                                          cache_disable_threshold);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: cache_disable_threshold = "
+            << cache_disable_threshold << std::endl;
+      } else if (opt == "direction_optimizing") {
+        opts.get_engine_args().get_option("direction_optimizing",
+                                          direction_optimizing);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: direction_optimizing = "
+            << direction_optimizing << std::endl;
+      } else if (opt == "pull_alpha") {
+        opts.get_engine_args().get_option("pull_alpha", pull_alpha);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: pull_alpha = "
+            << pull_alpha << std::endl;
+      } else if (opt == "push_beta") {
+        opts.get_engine_args().get_option("push_beta", push_beta);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: push_beta = "
+            << push_beta << std::endl;
+      } else if (opt == "sparse_frontier_threshold") {
+        opts.get_engine_args().get_option("sparse_frontier_threshold",
+                                          sparse_frontier_threshold);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: sparse_frontier_threshold = "
+            << sparse_frontier_threshold << std::endl;
       } else if (opt == "snapshot_interval") {
         opts.get_engine_args().get_option("snapshot_interval", snapshot_interval);
         if (rmi.procid() == 0)
@@ -1043,6 +1283,11 @@ namespace graphlab {
         if (rmi.procid() == 0)
           logstream(LOG_EMPH) << "Engine Option: snapshot_path = "
             << snapshot_path << std::endl;
+      } else if (opt == "resume_from") {
+        opts.get_engine_args().get_option("resume_from", resume_path);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: resume_from = "
+            << resume_path << std::endl;
       } else if (opt == "sched_allv") {
         opts.get_engine_args().get_option("sched_allv", sched_allv);
         if (rmi.procid() == 0)
@@ -1053,6 +1298,23 @@ namespace graphlab {
       }
     }
 
+    if (adaptive_cache) use_cache = true;
+    if (pull_alpha <= 0 || push_beta <= 0) {
+      logstream(LOG_FATAL)
+        << "pull_alpha and push_beta must be positive" << std::endl;
+    }
+    if (sparse_frontier_threshold < 0 || sparse_frontier_threshold > 1) {
+      logstream(LOG_FATAL)
+        << "sparse_frontier_threshold must be between 0 and 1" << std::endl;
+    }
+    has_message.set_density_threshold(sparse_frontier_threshold);
+    active_superstep.set_density_threshold(sparse_frontier_threshold);
+    active_minorstep.set_density_threshold(sparse_frontier_threshold);
+    if (cache_disable_threshold < 1 || cache_disable_threshold > 255) {
+      logstream(LOG_FATAL)
+        << "cache_disable_threshold must be between 1 and 255" << std::endl;
+    }
+
     if (snapshot_interval >= 0 && snapshot_path.length() == 0) {
       logstream(LOG_FATAL)
         << "Snapshot interval specified, but no snapshot path" << std::endl;
@@ -1062,6 +1324,10 @@ namespace graphlab {
     ADD_CUMULATIVE_EVENT(EVENT_GATHERS , "Gathers", "Calls");
     ADD_CUMULATIVE_EVENT(EVENT_SCATTERS , "Scatters", "Calls");
     ADD_INSTANTANEOUS_EVENT(EVENT_ACTIVE_CPUS, "Active Threads", "Threads");
+    ADD_CUMULATIVE_EVENT(EVENT_CACHE_HITS, "Gather Cache Hits", "Gathers");
+    ADD_CUMULATIVE_EVENT(EVENT_CACHE_MISSES, "Gather Cache Misses", "Gathers");
+    ADD_CUMULATIVE_EVENT(EVENT_CACHE_INVALIDATIONS,
+                         "Gather Cache Invalidations", "Calls");
     graph.finalize();
     init();
   } // end of synchronous engine
@@ -1077,6 +1343,8 @@ namespace graphlab {
     has_message.clear();
     has_gather_accum.clear();
     has_cache.clear();
+    cache_disabled.clear();
+    std::fill(cache_invalidations.begin(), cache_invalidations.end(), 0);
     active_superstep.clear();
     active_minorstep.clear();
   }
@@ -1102,6 +1370,10 @@ namespace graphlab {
       gather_cache.resize(graph.num_local_vertices(), gather_type());
       has_cache.resize(graph.num_local_vertices());
     }
+    if (adaptive_cache) {
+      cache_invalidations.resize(graph.num_local_vertices(), 0);
+      cache_disabled.resize(graph.num_local_vertices());
+    }
     // Allocate bitset to track active vertices on each bitset.
     active_superstep.resize(graph.num_local_vertices());
     active_minorstep.resize(graph.num_local_vertices());
@@ -1236,8 +1508,16 @@ namespace graphlab {
     const lvid_type lvid = vertex.local_id();
     if(caching_enabled && has_cache.get(lvid)) {
       vlocks[lvid].lock();
-      gather_cache[lvid] = gather_type();
-      has_cache.clear_bit(lvid);
+      // test again since another thread may have cleared the cache
+      if (has_cache.clear_bit(lvid)) {
+        gather_cache[lvid] = gather_type();
+        ++num_cache_invalidations;
+        INCREMENT_EVENT(EVENT_CACHE_INVALIDATIONS, 1);
+        if (adaptive_cache &&
+            ++cache_invalidations[lvid] >= cache_disable_threshold) {
+          cache_disabled.set_bit(lvid);
+        }
+      }
       vlocks[lvid].unlock();
     }
   } // end of clear_gather_cache
@@ -1272,6 +1552,7 @@ namespace graphlab {
     if (vlocks.size() != graph.num_local_vertices())
       resize();
     completed_applys = 0;
+    num_cache_hits = 0; num_cache_misses = 0; num_cache_invalidations = 0;
     rmi.barrier();
 
     // Initialization code ==================================================
@@ -1281,6 +1562,7 @@ namespace graphlab {
     start_time = timer::approx_time_seconds();
     iteration_counter = 0;
     force_abort = false;
+    pull_superstep = false;
     execution_status::status_enum termination_reason =
       execution_status::UNSET;
     // if (perform_init_vtx_program) {
@@ -1290,8 +1572,17 @@ namespace graphlab {
     aggregator.start();
     rmi.barrier();
 
+    if (!resume_path.empty()) {
+      if (!load_snapshot(resume_path)) {
+        logstream(LOG_FATAL) << "Unable to resume from snapshot "
+                             << resume_path << std::endl;
+      }
+      // only resume once
+      resume_path.clear();
+    }
+
     if (snapshot_interval == 0) {
-      graph.save_binary(snapshot_path);
+      save_snapshot();
     }
 
     float last_print = -5;
@@ -1321,11 +1612,18 @@ namespace graphlab {
       // be set upon receiving messages
       active_superstep.clear(); active_minorstep.clear();
       has_gather_accum.clear();
+      // On a pull super-step every vertex runs, as if it was signaled
+      if (pull_superstep) {
+        for(lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+          if(graph.l_is_master(lvid)) has_message.set_bit(lvid);
+        }
+      }
       rmi.barrier();
 
       // Exchange Messages --------------------------------------------------
       // Exchange any messages in the local message vectors
       // if (rmi.procid() == 0) std::cout << "Exchange messages..." << std::endl;
+      has_message.begin_iteration();
       run_synchronous( &synchronous_engine::exchange_messages );
       /**
        * Post conditions:
@@ -1339,6 +1637,7 @@ namespace graphlab {
 
       // if (rmi.procid() == 0) std::cout << "Receive messages..." << std::endl;
       num_active_vertices = 0;
+      has_message.begin_iteration();
       run_synchronous( &synchronous_engine::receive_messages );
       if (sched_allv) {
         active_minorstep.fill();
@@ -1372,6 +1671,7 @@ namespace graphlab {
       // Execute the gather operation for all vertices that are active
       // in this minor-step (active-minorstep bit set).
       // if (rmi.procid() == 0) std::cout << "Gathering..." << std::endl;
+      active_minorstep.begin_iteration();
       run_synchronous( &synchronous_engine::execute_gathers );
       // Clear the minor step bit since only super-step vertices
       // (only master vertices are required to participate in the
@@ -1388,6 +1688,8 @@ namespace graphlab {
       // Execute Apply Operations -------------------------------------------
       // Run the apply function on all active vertices
       // if (rmi.procid() == 0) std::cout << "Applying..." << std::endl;
+      frontier_vertices = 0; frontier_edges = 0;
+      active_superstep.begin_iteration();
       run_synchronous( &synchronous_engine::execute_applys );
       /**
        * Post conditions:
@@ -1401,9 +1703,43 @@ namespace graphlab {
        */
 
 
+      // Choose the direction of the next super-step -----------------------
+      // The vertices which are about to scatter form the frontier.  If
+      // it is large the scatter is skipped and the next super-step
+      // pulls the updates through the pull edges instead.
+      bool next_pull_superstep = false;
+      if (direction_optimizing) {
+        size_t total_frontier_vertices = frontier_vertices;
+        size_t total_frontier_edges = frontier_edges;
+        rmi.all_reduce(total_frontier_vertices);
+        rmi.all_reduce(total_frontier_edges);
+        if (pull_superstep) {
+          next_pull_superstep = total_frontier_vertices > 0 &&
+              total_frontier_vertices >= graph.num_vertices() / push_beta;
+        } else {
+          next_pull_superstep =
+              total_frontier_edges > graph.num_edges() / pull_alpha;
+        }
+        if (rmi.procid() == 0 && next_pull_superstep != pull_superstep) {
+          logstream(LOG_INFO)
+            << "Switching to " << (next_pull_superstep ? "pull" : "push")
+            << " with a frontier of " << total_frontier_vertices
+            << " vertices and " << total_frontier_edges << " edges"
+            << std::endl;
+        }
+      }
+
       // Execute Scatter Operations -----------------------------------------
       // Execute each of the scatters on all minor-step active vertices.
-      run_synchronous( &synchronous_engine::execute_scatters );
+      if (next_pull_superstep) {
+        active_minorstep.begin_iteration();
+        run_synchronous( &synchronous_engine::skip_scatters );
+        active_minorstep.clear();
+      } else {
+        active_minorstep.begin_iteration();
+        run_synchronous( &synchronous_engine::execute_scatters );
+      }
+      pull_superstep = next_pull_superstep;
       /**
        * Post conditions:
        *   1) NONE
@@ -1416,9 +1752,11 @@ namespace graphlab {
       ++iteration_counter;
 
       if (snapshot_interval > 0 && iteration_counter % snapshot_interval == 0) {
-        graph.save_binary(snapshot_path);
+        save_snapshot();
       }
     }
+    // wait for the last snapshot to reach the disk
+    snapshot_writer.join();
 
     if (rmi.procid() == 0) {
       logstream(LOG_EMPH) << iteration_counter
@@ -1437,6 +1775,23 @@ namespace graphlab {
     rmi.all_reduce(global_completed);
     completed_applys = global_completed;
     rmi.cout() << "Updates: " << completed_applys.value << "\n";
+    if (use_cache) {
+      size_t global_hits = num_cache_hits;
+      size_t global_misses = num_cache_misses;
+      size_t global_invalidations = num_cache_invalidations;
+      rmi.all_reduce(global_hits);
+      rmi.all_reduce(global_misses);
+      rmi.all_reduce(global_invalidations);
+      rmi.cout() << "Gather cache hits: " << global_hits
+                 << " misses: " << global_misses
+                 << " invalidations: " << global_invalidations;
+      if (adaptive_cache) {
+        size_t global_disabled = cache_disabled.popcount();
+        rmi.all_reduce(global_disabled);
+        rmi.cout() << " disabled vertices: " << global_disabled;
+      }
+      rmi.cout() << "\n";
+    }
     if (rmi.procid() == 0) {
       logstream(LOG_INFO) << "Compute Balance: ";
       for (size_t i = 0;i < all_compute_time_vec.size(); ++i) {
@@ -1459,31 +1814,20 @@ namespace graphlab {
     context_type context(*this, graph);
     const size_t TRY_RECV_MOD = 100;
     size_t vcount = 0;
-    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
-    while (1) {
-      // increment by a word at a time
-      lvid_type lvid_block_start =
-                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
-      if (lvid_block_start >= graph.num_local_vertices()) break;
-      // get the bit field from has_message
-      size_t lvid_bit_block = has_message.containing_word(lvid_block_start);
-      if (lvid_bit_block == 0) continue;
-      // initialize a word sized bitfield
-      local_bitset.clear();
-      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
-      foreach(size_t lvid_block_offset, local_bitset) {
-        lvid_type lvid = lvid_block_start + lvid_block_offset;
-        if (lvid >= graph.num_local_vertices()) break;
-        // if the vertex is not local and has a message send the
-        // message and clear the bit
-        if(!graph.l_is_master(lvid)) {
-          sync_message(lvid, thread_id);
-          has_message.clear_bit(lvid);
-          // clear the message to save memory
-          messages[lvid] = message_type();
-        }
-        if(++vcount % TRY_RECV_MOD == 0) recv_messages();
+    frontier_bitset::parallel_iterator
+      active_iter(has_message, shared_lvid_counter);
+    size_t next_lvid;
+    while (active_iter.next(next_lvid)) {
+      const lvid_type lvid = next_lvid;
+      // if the vertex is not local and has a message send the
+      // message and clear the bit
+      if(!graph.l_is_master(lvid)) {
+        sync_message(lvid, thread_id);
+        has_message.clear_bit(lvid);
+        // clear the message to save memory
+        messages[lvid] = message_type();
       }
+      if(++vcount % TRY_RECV_MOD == 0) recv_messages();
     } // end of loop over vertices to send messages
     message_exchange.partial_flush();
     // Finish sending and receiving all messages
@@ -1502,46 +1846,33 @@ namespace graphlab {
     const size_t TRY_RECV_MOD = 100;
     size_t vcount = 0;
     size_t nactive_inc = 0;
-    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
-
-    while (1) {
-      // increment by a word at a time
-      lvid_type lvid_block_start =
-                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
-      if (lvid_block_start >= graph.num_local_vertices()) break;
-      // get the bit field from has_message
-      size_t lvid_bit_block = has_message.containing_word(lvid_block_start);
-      if (lvid_bit_block == 0) continue;
-      // initialize a word sized bitfield
-      local_bitset.clear();
-      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
-
-      foreach(size_t lvid_block_offset, local_bitset) {
-        lvid_type lvid = lvid_block_start + lvid_block_offset;
-        if (lvid >= graph.num_local_vertices()) break;
-
-        // if this is the master of lvid and we have a message
-        if(graph.l_is_master(lvid)) {
-          // The vertex becomes active for this superstep
-          active_superstep.set_bit(lvid);
-          ++nactive_inc;
-          // Pass the message to the vertex program
-          vertex_type vertex = vertex_type(graph.l_vertex(lvid));
-          vertex_programs[lvid].init(context, vertex, messages[lvid]);
-          // clear the message to save memory
-          messages[lvid] = message_type();
-          if (sched_allv) continue;
-          // Determine if the gather should be run
-          const vertex_program_type& const_vprog = vertex_programs[lvid];
-          const vertex_type const_vertex = vertex;
-          if(const_vprog.gather_edges(context, const_vertex) !=
-              graphlab::NO_EDGES) {
-            active_minorstep.set_bit(lvid);
-            sync_vertex_program(lvid, thread_id);
-          }
+    frontier_bitset::parallel_iterator
+      active_iter(has_message, shared_lvid_counter);
+    size_t next_lvid;
+    while (active_iter.next(next_lvid)) {
+      const lvid_type lvid = next_lvid;
+
+      // if this is the master of lvid and we have a message
+      if(graph.l_is_master(lvid)) {
+        // The vertex becomes active for this superstep
+        active_superstep.set_bit(lvid);
+        ++nactive_inc;
+        // Pass the message to the vertex program
+        vertex_type vertex = vertex_type(graph.l_vertex(lvid));
+        vertex_programs[lvid].init(context, vertex, messages[lvid]);
+        // clear the message to save memory
+        messages[lvid] = message_type();
+        if (sched_allv) continue;
+        // Determine if the gather should be run
+        const vertex_program_type& const_vprog = vertex_programs[lvid];
+        const vertex_type const_vertex = vertex;
+        if(gather_direction(context, const_vprog, const_vertex) !=
+            graphlab::NO_EDGES) {
+          active_minorstep.set_bit(lvid);
+          sync_vertex_program(lvid, thread_id);
         }
-        if(++vcount % TRY_RECV_MOD == 0) recv_vertex_programs();
       }
+      if(++vcount % TRY_RECV_MOD == 0) recv_vertex_programs();
     }
 
     num_active_vertices += nactive_inc;
@@ -1565,95 +1896,97 @@ namespace graphlab {
     context_type context(*this, graph);
     const size_t TRY_RECV_MOD = 1000;
     size_t vcount = 0;
-    const bool caching_enabled = !gather_cache.empty();
+    // the cache holds the gathers over the gather edges and is
+    // bypassed when pulling
+    const bool caching_enabled = !gather_cache.empty() && !pull_superstep;
+    size_t cache_hits = 0, cache_misses = 0;
     timer ti;
 
-    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
-
-    while (1) {
-      // increment by a word at a time
-      lvid_type lvid_block_start =
-                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
-      if (lvid_block_start >= graph.num_local_vertices()) break;
-      // get the bit field from has_message
-      size_t lvid_bit_block = active_minorstep.containing_word(lvid_block_start);
-      if (lvid_bit_block == 0) continue;
-      // initialize a word sized bitfield
-      local_bitset.clear();
-      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
-
-      foreach(size_t lvid_block_offset, local_bitset) {
-        lvid_type lvid = lvid_block_start + lvid_block_offset;
-        if (lvid >= graph.num_local_vertices()) break;
-
-        bool accum_is_set = false;
-        gather_type accum = gather_type();
-        // if caching is enabled and we have a cache entry then use
-        // that as the accum
-        if( caching_enabled && has_cache.get(lvid) ) {
-          accum = gather_cache[lvid];
-          accum_is_set = true;
-        } else {
-          // recompute the local contribution to the gather
-          const vertex_program_type& vprog = vertex_programs[lvid];
-          local_vertex_type local_vertex = graph.l_vertex(lvid);
-          const vertex_type vertex(local_vertex);
-          const edge_dir_type gather_dir = vprog.gather_edges(context, vertex);
-          // Loop over in edges
-          size_t edges_touched = 0;
-          vprog.pre_local_gather(accum);
-          if(gather_dir == IN_EDGES || gather_dir == ALL_EDGES) {
-            foreach(local_edge_type local_edge, local_vertex.in_edges()) {
-              edge_type edge(local_edge);
-              // elocks[local_edge.id()].lock();
-              if(accum_is_set) { // \todo hint likely
-                accum += vprog.gather(context, vertex, edge);
-              } else {
-                accum = vprog.gather(context, vertex, edge);
-                accum_is_set = true;
-              }
-              ++edges_touched;
-              // elocks[local_edge.id()].unlock();
+    frontier_bitset::parallel_iterator
+      active_iter(active_minorstep, shared_lvid_counter);
+    size_t next_lvid;
+    while (active_iter.next(next_lvid)) {
+      const lvid_type lvid = next_lvid;
+
+      bool accum_is_set = false;
+      gather_type accum = gather_type();
+      // if caching is enabled and we have a cache entry then use
+      // that as the accum
+      if( caching_enabled && has_cache.get(lvid) ) {
+        accum = gather_cache[lvid];
+        accum_is_set = true;
+        ++cache_hits;
+        // the cached value survived until it was used
+        if (adaptive_cache) cache_invalidations[lvid] = 0;
+      } else {
+        if (caching_enabled) ++cache_misses;
+        // recompute the local contribution to the gather
+        const vertex_program_type& vprog = vertex_programs[lvid];
+        local_vertex_type local_vertex = graph.l_vertex(lvid);
+        const vertex_type vertex(local_vertex);
+        const edge_dir_type gather_dir =
+          gather_direction(context, vprog, vertex);
+        // Loop over in edges
+        size_t edges_touched = 0;
+        vprog.pre_local_gather(accum);
+        if(gather_dir == IN_EDGES || gather_dir == ALL_EDGES) {
+          foreach(local_edge_type local_edge, local_vertex.in_edges()) {
+            edge_type edge(local_edge);
+            // elocks[local_edge.id()].lock();
+            if(accum_is_set) { // \todo hint likely
+              accum += vprog.gather(context, vertex, edge);
+            } else {
+              accum = vprog.gather(context, vertex, edge);
+              accum_is_set = true;
             }
-          } // end of if in_edges/all_edges
-            // Loop over out edges
-          if(gather_dir == OUT_EDGES || gather_dir == ALL_EDGES) {
-            foreach(local_edge_type local_edge, local_vertex.out_edges()) {
-              edge_type edge(local_edge);
-              // elocks[local_edge.id()].lock();
-              if(accum_is_set) { // \todo hint likely
-                accum += vprog.gather(context, vertex, edge);
-              } else {
-                accum = vprog.gather(context, vertex, edge);
-                accum_is_set = true;
-              }
-              // elocks[local_edge.id()].unlock();
-              ++edges_touched;
+            ++edges_touched;
+            // elocks[local_edge.id()].unlock();
+          }
+        } // end of if in_edges/all_edges
+          // Loop over out edges
+        if(gather_dir == OUT_EDGES || gather_dir == ALL_EDGES) {
+          foreach(local_edge_type local_edge, local_vertex.out_edges()) {
+            edge_type edge(local_edge);
+            // elocks[local_edge.id()].lock();
+            if(accum_is_set) { // \todo hint likely
+              accum += vprog.gather(context, vertex, edge);
+            } else {
+              accum = vprog.gather(context, vertex, edge);
+              accum_is_set = true;
             }
-            INCREMENT_EVENT(EVENT_GATHERS, edges_touched);
-          } // end of if out_edges/all_edges
-          vprog.post_local_gather(accum);
-          // If caching is enabled then save the accumulator to the
-          // cache for future iterations.  Note that it is possible
-          // that the accumulator was never set in which case we are
-          // effectively "zeroing out" the cache.
-          if(caching_enabled && accum_is_set) {
-            gather_cache[lvid] = accum; has_cache.set_bit(lvid);
-          } // end of if caching enabled
-        }
-        // If the accum contains a value for the local gather we put
-        // that estimate in the gather exchange.
-        if(accum_is_set) sync_gather(lvid, accum, thread_id);
-        if(!graph.l_is_master(lvid)) {
-          // if this is not the master clear the vertex program
-          vertex_programs[lvid] = vertex_program_type();
-        }
-
-        // try to recv gathers if there are any in the buffer
-        if(++vcount % TRY_RECV_MOD == 0) recv_gathers();
+            // elocks[local_edge.id()].unlock();
+            ++edges_touched;
+          }
+          INCREMENT_EVENT(EVENT_GATHERS, edges_touched);
+        } // end of if out_edges/all_edges
+        vprog.post_local_gather(accum);
+        // If caching is enabled then save the accumulator to the
+        // cache for future iterations.  Note that it is possible
+        // that the accumulator was never set in which case we are
+        // effectively "zeroing out" the cache.  Vertices for which
+        // adaptive caching has been disabled are never cached.
+        if(caching_enabled && accum_is_set &&
+           !(adaptive_cache && cache_disabled.get(lvid))) {
+          gather_cache[lvid] = accum; has_cache.set_bit(lvid);
+        } // end of if caching enabled
+      }
+      // If the accum contains a value for the local gather we put
+      // that estimate in the gather exchange.
+      if(accum_is_set) sync_gather(lvid, accum, thread_id);
+      if(!graph.l_is_master(lvid)) {
+        // if this is not the master clear the vertex program
+        vertex_programs[lvid] = vertex_program_type();
       }
+
+      // try to recv gathers if there are any in the buffer
+      if(++vcount % TRY_RECV_MOD == 0) recv_gathers();
     } // end of loop over vertices to compute gather accumulators
     per_thread_compute_time[thread_id] += ti.current_time();
+    if (caching_enabled) {
+      num_cache_hits += cache_hits; num_cache_misses += cache_misses;
+      INCREMENT_EVENT(EVENT_CACHE_HITS, cache_hits);
+      INCREMENT_EVENT(EVENT_CACHE_MISSES, cache_misses);
+    }
     gather_exchange.partial_flush();
       // Finish sending and receiving all gather operations
     thread_barrier.wait();
@@ -1669,56 +2002,55 @@ namespace graphlab {
     context_type context(*this, graph);
     const size_t TRY_RECV_MOD = 1000;
     size_t vcount = 0;
+    size_t nfrontier_vertices = 0, nfrontier_edges = 0;
     timer ti;
 
-    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset;  // allocate a word size = 64bits
-    while (1) {
-      // increment by a word at a time
-      lvid_type lvid_block_start =
-                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
-      if (lvid_block_start >= graph.num_local_vertices()) break;
-      // get the bit field from has_message
-      size_t lvid_bit_block = active_superstep.containing_word(lvid_block_start);
-      if (lvid_bit_block == 0) continue;
-      // initialize a word sized bitfield
-      local_bitset.clear();
-      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
-      foreach(size_t lvid_block_offset, local_bitset) {
-        lvid_type lvid = lvid_block_start + lvid_block_offset;
-        if (lvid >= graph.num_local_vertices()) break;
-
-        // Only master vertices can be active in a super-step
-        ASSERT_TRUE(graph.l_is_master(lvid));
-        vertex_type vertex(graph.l_vertex(lvid));
-        // Get the local accumulator.  Note that it is possible that
-        // the gather_accum was not set during the gather.
-        const gather_type& accum = gather_accum[lvid];
-        INCREMENT_EVENT(EVENT_APPLIES, 1);
-        vertex_programs[lvid].apply(context, vertex, accum);
-        // record an apply as a completed task
-        ++completed_applys;
-        // Clear the accumulator to save some memory
-        gather_accum[lvid] = gather_type();
-        // synchronize the changed vertex data with all mirrors
-        sync_vertex_data(lvid, thread_id);
-        // determine if a scatter operation is needed
-        const vertex_program_type& const_vprog = vertex_programs[lvid];
-        const vertex_type const_vertex = vertex;
-        if(const_vprog.scatter_edges(context, const_vertex) !=
-           graphlab::NO_EDGES) {
-          active_minorstep.set_bit(lvid);
-          sync_vertex_program(lvid, thread_id);
-        } else { // we are done so clear the vertex program
-          vertex_programs[lvid] = vertex_program_type();
-        }
-      // try to receive vertex data
-        if(++vcount % TRY_RECV_MOD == 0) {
-          recv_vertex_programs();
-          recv_vertex_data();
-        }
+    frontier_bitset::parallel_iterator
+      active_iter(active_superstep, shared_lvid_counter);
+    size_t next_lvid;
+    while (active_iter.next(next_lvid)) {
+      const lvid_type lvid = next_lvid;
+
+      // Only master vertices can be active in a super-step
+      ASSERT_TRUE(graph.l_is_master(lvid));
+      vertex_type vertex(graph.l_vertex(lvid));
+      // Get the local accumulator.  Note that it is possible that
+      // the gather_accum was not set during the gather.
+      const gather_type& accum = gather_accum[lvid];
+      INCREMENT_EVENT(EVENT_APPLIES, 1);
+      vertex_programs[lvid].apply(context, vertex, accum);
+      // record an apply as a completed task
+      ++completed_applys;
+      // Clear the accumulator to save some memory
+      gather_accum[lvid] = gather_type();
+      // synchronize the changed vertex data with all mirrors
+      sync_vertex_data(lvid, thread_id);
+      // determine if a scatter operation is needed
+      const vertex_program_type& const_vprog = vertex_programs[lvid];
+      const vertex_type const_vertex = vertex;
+      const edge_dir_type scatter_dir =
+        const_vprog.scatter_edges(context, const_vertex);
+      if(scatter_dir != graphlab::NO_EDGES) {
+        // the vertex is part of the frontier
+        ++nfrontier_vertices;
+        if(scatter_dir == IN_EDGES || scatter_dir == ALL_EDGES)
+          nfrontier_edges += const_vertex.num_in_edges();
+        if(scatter_dir == OUT_EDGES || scatter_dir == ALL_EDGES)
+          nfrontier_edges += const_vertex.num_out_edges();
+        active_minorstep.set_bit(lvid);
+        sync_vertex_program(lvid, thread_id);
+      } else { // we are done so clear the vertex program
+        vertex_programs[lvid] = vertex_program_type();
+      }
+    // try to receive vertex data
+      if(++vcount % TRY_RECV_MOD == 0) {
+        recv_vertex_programs();
+        recv_vertex_data();
       }
     } // end of loop over vertices to run apply
 
+    frontier_vertices += nfrontier_vertices;
+    frontier_edges += nfrontier_edges;
     per_thread_compute_time[thread_id] += ti.current_time();
     vprog_exchange.partial_flush();
     vdata_exchange.partial_flush();
@@ -1740,57 +2072,59 @@ namespace graphlab {
   execute_scatters(const size_t thread_id) {
     context_type context(*this, graph);
     timer ti;
-    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // allocate a word size = 64 bits
-    while (1) {
-      // increment by a word at a time
-      lvid_type lvid_block_start =
-                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
-      if (lvid_block_start >= graph.num_local_vertices()) break;
-      // get the bit field from has_message
-      size_t lvid_bit_block = active_minorstep.containing_word(lvid_block_start);
-      if (lvid_bit_block == 0) continue;
-      // initialize a word sized bitfield
-      local_bitset.clear();
-      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
-      foreach(size_t lvid_block_offset, local_bitset) {
-        lvid_type lvid = lvid_block_start + lvid_block_offset;
-        if (lvid >= graph.num_local_vertices()) break;
-
-        const vertex_program_type& vprog = vertex_programs[lvid];
-        local_vertex_type local_vertex = graph.l_vertex(lvid);
-        const vertex_type vertex(local_vertex);
-        const edge_dir_type scatter_dir = vprog.scatter_edges(context, vertex);
+    frontier_bitset::parallel_iterator
+      active_iter(active_minorstep, shared_lvid_counter);
+    size_t next_lvid;
+    while (active_iter.next(next_lvid)) {
+      const lvid_type lvid = next_lvid;
+
+      const vertex_program_type& vprog = vertex_programs[lvid];
+      local_vertex_type local_vertex = graph.l_vertex(lvid);
+      const vertex_type vertex(local_vertex);
+      const edge_dir_type scatter_dir = vprog.scatter_edges(context, vertex);
 				size_t edges_touched = 0;
-        // Loop over in edges
-        if(scatter_dir == IN_EDGES || scatter_dir == ALL_EDGES) {
-          foreach(local_edge_type local_edge, local_vertex.in_edges()) {
-            edge_type edge(local_edge);
-            // elocks[local_edge.id()].lock();
-            vprog.scatter(context, vertex, edge);
-            // elocks[local_edge.id()].unlock();
-          }
+      // Loop over in edges
+      if(scatter_dir == IN_EDGES || scatter_dir == ALL_EDGES) {
+        foreach(local_edge_type local_edge, local_vertex.in_edges()) {
+          edge_type edge(local_edge);
+          // elocks[local_edge.id()].lock();
+          vprog.scatter(context, vertex, edge);
+          // elocks[local_edge.id()].unlock();
+        }
 					++edges_touched;
-        } // end of if in_edges/all_edges
-        // Loop over out edges
-        if(scatter_dir == OUT_EDGES || scatter_dir == ALL_EDGES) {
-          foreach(local_edge_type local_edge, local_vertex.out_edges()) {
-            edge_type edge(local_edge);
-            // elocks[local_edge.id()].lock();
-            vprog.scatter(context, vertex, edge);
-            // elocks[local_edge.id()].unlock();
-          }
+      } // end of if in_edges/all_edges
+      // Loop over out edges
+      if(scatter_dir == OUT_EDGES || scatter_dir == ALL_EDGES) {
+        foreach(local_edge_type local_edge, local_vertex.out_edges()) {
+          edge_type edge(local_edge);
+          // elocks[local_edge.id()].lock();
+          vprog.scatter(context, vertex, edge);
+          // elocks[local_edge.id()].unlock();
+        }
 					++edges_touched;
-        } // end of if out_edges/all_edges
+      } // end of if out_edges/all_edges
 				INCREMENT_EVENT(EVENT_SCATTERS, edges_touched);
-        // Clear the vertex program
-        vertex_programs[lvid] = vertex_program_type();
-      } // end of if active on this minor step
+      // Clear the vertex program
+      vertex_programs[lvid] = vertex_program_type();
     } // end of loop over vertices to complete scatter operation
 
     per_thread_compute_time[thread_id] += ti.current_time();
   } // end of execute_scatters
 
 
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  skip_scatters(const size_t thread_id) {
+    frontier_bitset::parallel_iterator
+      active_iter(active_minorstep, shared_lvid_counter);
+    size_t next_lvid;
+    while (active_iter.next(next_lvid)) {
+      const lvid_type lvid = next_lvid;
+      vertex_programs[lvid] = vertex_program_type();
+    }
+  } // end of skip_scatters
+
+
 
   // Data Synchronization ===================================================
   template<typename VertexProgram>
@@ -1938,6 +2272,185 @@ namespace graphlab {
 
 
 
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::save_snapshot() {
+    // make sure all signals sent to remote machines have arrived
+    rmi.full_barrier();
+    // complete the previous snapshot before overwriting it
+    snapshot_writer.join();
+    timer ti;
+    const std::string suffix = tostr(rmi.procid()) + ".bin";
+    oarchive graph_arc;
+    graph_arc << graph;
+    oarchive engine_arc;
+    save_engine_state(engine_arc);
+    // the buffers are released by the background writer
+    snapshot_writer.launch(boost::bind(
+        &synchronous_engine::write_snapshot_files,
+        snapshot_path + suffix, graph_arc.buf, graph_arc.off,
+        snapshot_path + "engine_" + suffix, engine_arc.buf, engine_arc.off));
+    if (rmi.procid() == 0) {
+      logstream(LOG_EMPH) << "Snapshot of iteration " << iteration_counter
+                          << " serialized in " << ti.current_time()
+                          << "s, writing in background" << std::endl;
+    }
+  } // end of save_snapshot
+
+
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  write_snapshot_file(std::string fname, char* buf, size_t len) {
+    if(boost::starts_with(fname, "hdfs://")) {
+      graphlab::hdfs hdfs;
+      graphlab::hdfs::fstream out_file(hdfs, fname, true);
+      boost::iostreams::filtering_stream<boost::iostreams::output> fout;
+      fout.push(boost::iostreams::gzip_compressor());
+      fout.push(out_file);
+      fout.write(buf, len);
+      fout.pop();
+      fout.pop();
+      out_file.close();
+    } else {
+      // write to a temporary file and rename it so that a failure while
+      // writing never destroys the previous snapshot
+      const std::string tmpname = fname + ".tmp";
+      std::ofstream out_file(tmpname.c_str(),
+                             std::ios_base::out | std::ios_base::binary);
+      if (!out_file.good()) {
+        logstream(LOG_ERROR) << "Error opening snapshot file: "
+                             << tmpname << std::endl;
+        free(buf);
+        return;
+      }
+      boost::iostreams::filtering_stream<boost::iostreams::output> fout;
+      fout.push(boost::iostreams::gzip_compressor());
+      fout.push(out_file);
+      fout.write(buf, len);
+      fout.pop();
+      fout.pop();
+      out_file.close();
+      if (std::rename(tmpname.c_str(), fname.c_str()) != 0) {
+        logstream(LOG_ERROR) << "Error renaming snapshot file: "
+                             << tmpname << std::endl;
+      }
+    }
+    free(buf);
+  } // end of write_snapshot_file
+
+
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  write_snapshot_files(std::string graph_fname, char* graph_buf, size_t graph_len,
+                       std::string engine_fname, char* engine_buf, size_t engine_len) {
+    // the engine state is written last so that a snapshot with an
+    // engine state file always has a complete graph file.
+    write_snapshot_file(graph_fname, graph_buf, graph_len);
+    write_snapshot_file(engine_fname, engine_buf, engine_len);
+  } // end of write_snapshot_files
+
+
+  template<typename VertexProgram>
+  bool synchronous_engine<VertexProgram>::
+  load_snapshot(const std::string& prefix) {
+    // a machine which failed to load its graph still takes part in the
+    // collectives below
+    size_t failures = graph.load_binary(prefix) ? 0 : 1;
+    if (failures == 0) {
+      resize();
+      const std::string fname = prefix + "engine_" + tostr(rmi.procid()) + ".bin";
+      logstream(LOG_INFO) << "Load engine state from " << fname << std::endl;
+      if(boost::starts_with(fname, "hdfs://")) {
+        graphlab::hdfs hdfs;
+        graphlab::hdfs::fstream in_file(hdfs, fname);
+        boost::iostreams::filtering_stream<boost::iostreams::input> fin;
+        fin.push(boost::iostreams::gzip_decompressor());
+        fin.push(in_file);
+        if(!fin.good()) {
+          logstream(LOG_ERROR) << "Error opening file: " << fname << std::endl;
+          ++failures;
+        } else {
+          iarchive iarc(fin);
+          load_engine_state(iarc);
+        }
+        fin.pop();
+        fin.pop();
+        in_file.close();
+      } else {
+        std::ifstream in_file(fname.c_str(),
+                              std::ios_base::in | std::ios_base::binary);
+        if(!in_file.good()) {
+          logstream(LOG_ERROR) << "Error opening file: " << fname << std::endl;
+          ++failures;
+        } else {
+          boost::iostreams::filtering_stream<boost::iostreams::input> fin;
+          fin.push(boost::iostreams::gzip_decompressor());
+          fin.push(in_file);
+          iarchive iarc(fin);
+          load_engine_state(iarc);
+          fin.pop();
+          fin.pop();
+          in_file.close();
+        }
+      }
+    }
+    // all machines must agree on the outcome
+    rmi.all_reduce(failures);
+    const bool success = (failures == 0);
+    if (success && rmi.procid() == 0) {
+      logstream(LOG_EMPH) << "Resuming from iteration " << iteration_counter
+                          << std::endl;
+    }
+    rmi.full_barrier();
+    return success;
+  } // end of load_snapshot
+
+
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  save_engine_state(oarchive& oarc) const {
+    oarc << size_t(rmi.numprocs())
+         << iteration_counter << pull_superstep
+         << messages << has_message
+         << gather_cache << has_cache
+         << cache_invalidations << cache_disabled;
+    aggregator.save_schedule(oarc);
+  } // end of save_engine_state
+
+
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  load_engine_state(iarchive& iarc) {
+    size_t numprocs = 0;
+    iarc >> numprocs;
+    if (numprocs != rmi.numprocs()) {
+      logstream(LOG_FATAL) << "Snapshot was taken with " << numprocs
+                           << " machines but " << rmi.numprocs()
+                           << " are running" << std::endl;
+    }
+    iarc >> iteration_counter >> pull_superstep
+         >> messages >> has_message;
+    // the cache is only restored if caching is enabled in this run
+    std::vector<gather_type> saved_cache;
+    dense_bitset saved_has_cache;
+    iarc >> saved_cache >> saved_has_cache;
+    if (use_cache && saved_cache.size() == graph.num_local_vertices()) {
+      gather_cache.swap(saved_cache);
+      has_cache = saved_has_cache;
+    }
+    // and so is the adaptive cache state of each vertex
+    std::vector<unsigned char> saved_invalidations;
+    dense_bitset saved_disabled;
+    iarc >> saved_invalidations >> saved_disabled;
+    if (adaptive_cache &&
+        saved_invalidations.size() == graph.num_local_vertices()) {
+      cache_invalidations.swap(saved_invalidations);
+      cache_disabled = saved_disabled;
+    }
+    aggregator.load_schedule(iarc);
+  } // end of load_engine_state
+
+
+
 
 
 
@@ -1012,6 +1012,25 @@ namespace warp {
       }
     }
 
+    /**
+     * \internal
+     * Called by one thread on every machine when the fibers terminate,
+     * and before they are first launched. Starts the next round held
+     * back by the scheduler (see start_next_scheduler_round()), and
+     * returns false if there is none or if any machine was stopped.
+     */
+    bool start_next_round() {
+      if (!start_next_scheduler_round(rmi, *scheduler_ptr,
+              termination_reason != execution_status::RUNNING)) {
+        return false;
+      }
+      consensus->reset();
+      endgame_mode = false;
+      rmi.dc().set_fast_track_requests(false);
+      rmi.barrier();
+      return true;
+    }
+
     void set_endgame_mode() {
         if (!endgame_mode) logstream(LOG_EMPH) << "Endgame mode\n";
         endgame_mode = true;
@@ -1168,7 +1187,10 @@ namespace warp {
       /**************************************************************************/
       /*                             Acquire Locks                              */
       /**************************************************************************/
-      if (!factorized_consistency) {
+      // a vertex with no mirrors whose neighbors are idle takes its
+      // forks at once
+      if (!factorized_consistency &&
+          !cmlocks->try_make_philosopher_eat(lvid)) {
         // begin lock acquisition
         cm_handles[lvid] = new vertex_fiber_cm_handle;
         cm_handles[lvid]->philosopher_ready = false;
@@ -1316,10 +1338,14 @@ namespace warp {
       thrgroup.set_affinity(affinity);
       thrgroup.set_stacksize(stacksize);
 
-      for (size_t i = 0; i < nfibers ; ++i) {
-        thrgroup.launch(boost::bind(&engine_type::thread_start, this, i));
-      }
-      thrgroup.join();
+      // run the rounds held back by the scheduler one after the other
+      start_next_round();
+      do {
+        for (size_t i = 0; i < nfibers ; ++i) {
+          thrgroup.launch(boost::bind(&engine_type::thread_start, this, i));
+        }
+        thrgroup.join();
+      } while (start_next_round());
       aggregator.stop();
       // if termination reason was not changed, then it must be depletion
       if (termination_reason == execution_status::RUNNING) {
@@ -46,6 +46,44 @@
 namespace graphlab {
 
   namespace builtin_parsers {
+
+    /**
+     * \brief Parses an unsigned decimal integer from a null terminated
+     * string, skipping leading spaces, tabs, commas and carriage returns.
+     *
+     * On success, ptr is moved past the last digit. Much faster than
+     * strtoul or an istream since there is no locale, base or sign
+     * handling.
+     *
+     * \return false if there is no integer at ptr.
+     */
+    template <typename IntType>
+    inline bool parse_uint(const char*& ptr, IntType& value) {
+      while (*ptr == ' ' || *ptr == '\t' || *ptr == ',' || *ptr == '\r') ++ptr;
+      if (*ptr < '0' || *ptr > '9') return false;
+      IntType ret = 0;
+      do {
+        ret = ret * 10 + IntType(*ptr - '0');
+        ++ptr;
+      } while (*ptr >= '0' && *ptr <= '9');
+      value = ret;
+      return true;
+    } // end of parse_uint
+
+    /**
+     * \internal
+     * Parses a "[source] [target]" line and adds the edge. Lines without
+     * any number are skipped, a source without a target is an error.
+     */
+    template <typename Graph>
+    inline bool parse_edge_line(Graph& graph, const std::string& str) {
+      const char* ptr = str.c_str();
+      typename Graph::vertex_id_type source, target;
+      if (!parse_uint(ptr, source)) return true;
+      if (!parse_uint(ptr, target)) return false;
+      if(source != target) graph.add_edge(source, target);
+      return true;
+    } // end of parse_edge_line
   
     /**
      * \brief Parse files in the Stanford Network Analysis Package format.
@@ -65,15 +103,9 @@ namespace graphlab {
       if (str.empty()) return true;
       else if (str[0] == '#') {
         std::cout << str << std::endl;
-      } else {
-        size_t source, target;
-        char* targetptr;
-        source = strtoul(str.c_str(), &targetptr, 10);
-        if (targetptr == NULL) return false;
-        target = strtoul(targetptr, NULL, 10);
-        if(source != target) graph.add_edge(source, target);
-      }
-      return true;
+        return true;
+      } 
+      return parse_edge_line(graph, str);
     } // end of snap parser
 
     /**
@@ -86,13 +118,7 @@ namespace graphlab {
     bool tsv_parser(Graph& graph, const std::string& srcfilename,
                     const std::string& str) {
       if (str.empty()) return true;
-      size_t source, target;
-      char* targetptr;
-      source = strtoul(str.c_str(), &targetptr, 10);
-      if (targetptr == NULL) return false;
-      target = strtoul(targetptr, NULL, 10);
-      if(source != target) graph.add_edge(source, target);
-      return true;
+      return parse_edge_line(graph, str);
     } // end of tsv parser
 
 
@@ -35,6 +35,7 @@
 #include <set>
 #include <map>
 #include <graphlab/util/dense_bitset.hpp>
+#include <graphlab/util/mirror_set.hpp>
 
 
 #include <queue>
@@ -43,6 +44,8 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
+#include <typeinfo>
 
 #include <boost/functional.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -77,6 +80,8 @@
 #include <graphlab/graph/ingress/distributed_ingress_base.hpp>
 #include <graphlab/graph/ingress/distributed_oblivious_ingress.hpp>
 #include <graphlab/graph/ingress/distributed_hdrf_ingress.hpp>
+#include <graphlab/graph/ingress/distributed_restream_ingress.hpp>
+#include <graphlab/graph/ingress/distributed_hybrid_ingress.hpp>
 #include <graphlab/graph/ingress/distributed_random_ingress.hpp>
 #include <graphlab/graph/ingress/distributed_identity_ingress.hpp>
 
@@ -84,6 +89,7 @@
 #include <graphlab/graph/ingress/distributed_constrained_random_ingress.hpp>
 
 #include <graphlab/graph/graph_hash.hpp>
+#include <graphlab/graph/mmap_graph_format.hpp>
 
 #include <graphlab/util/hopscotch_map.hpp>
 
@@ -150,7 +156,9 @@ namespace graphlab {
    * Alternatively, load_binary() may be used to perform an extremely rapid
    * load of a graph previously saved with save_binary(). The caveat being that
    * the number of machines used to save the graph must match the number of
-   * machines used to load the graph.
+   * machines used to load the graph. load_binary_mmap() is faster still,
+   * reading the uncompressed files of save_binary_mmap() from a memory
+   * mapping, for warm restarts on the same cluster.
    *
    * The second construction strategy is to call the add_vertex() and
    * add_edge() functions directly. These functions are parallel reentrant, and
@@ -208,6 +216,39 @@ namespace graphlab {
    *		    "HDRF: Stream-Based Partitioning for Power-Law Graphs". 
    *		    CIKM, 2015.
    *
+   * \li \c "fennel" Like hdrf, but scores machines with the Fennel
+   *                  objective: the endpoints already present minus a
+   *                  convex penalty on the number of edges, with a hard
+   *                  cap of 1.1 times the average. Keeps the edges of a
+   *                  machine in memory until finalize.
+   *
+   * \li \c "hybrid" Runs at roughly the speed of random. Places all the
+   *                  in edges of a vertex with at most hybrid_threshold
+   *                  (default 100) in edges on its master, like an
+   *                  edge-cut, and spreads the in edges of the other
+   *                  vertices by source. Most low degree vertices then
+   *                  gather without mirrors. Described in
+   *                  R. Chen, J. Shi, Y. Chen and H. Chen: "PowerLyra:
+   *                  Differentiated Graph Computation and Partitioning on
+   *                  Skewed Graphs". EuroSys, 2015.
+   *
+   * Setting --graph_opts="restream_passes=[n]" with n > 1 makes "hdrf"
+   * and "fennel" place the edges loaded by each machine n times, each
+   * pass starting from the replicas of the previous one, which keeps
+   * the loaded edges in memory until finalize. The replication factor
+   * and the edge and vertex imbalance of every pass are logged.
+   *
+   * ### Local Vertex Order
+   *
+   * Local vertex ids are assigned in the order the edges arrive. Setting
+   * --graph_opts="vertex_order=[method]" renumbers them when the graph is
+   * first finalized so that gathers and scatters touch nearby vertex data.
+   * \li \c "none" Keep the arrival order (default).
+   * \li \c "degree" Sort by decreasing degree, packing the high degree
+   *                 vertices together.
+   * \li \c "rcm" Reverse Cuthill-McKee order, placing neighbors close to
+   *              each other.
+   *
    * ### Referencing Vertices / Edges Many GraphLab operations will pass around
    * vertex_type and edge_type objects. These objects are light-weight copyable
    * opaque references to vertices and edges in the distributed graph.  The
@@ -384,7 +425,7 @@ namespace graphlab {
                                  const std::string&)> line_parser_type;
 
 
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> mirror_type;
+    typedef mirror_set mirror_type;
 
     /// The type of the local graph used to store the graph data
 #ifdef USE_DYNAMIC_LOCAL_GRAPH
@@ -608,6 +649,22 @@ namespace graphlab {
      *                when there are a large number of machines) at a small
      *                partitioning penalty. Defaults to 0. Set to 1 to
      *                enable.
+     * \li \c load_chunk_size Uncompressed input files are split into
+     *                chunks of this many bytes which are parsed in
+     *                parallel. Defaults to 64MB.
+     * \li \c restream_passes The number of placement passes of the
+     *                "hdrf" and "fennel" ingress methods. Defaults to 1.
+     * \li \c streaming_ingress Moves the edges received from other
+     *                machines into the local graph while the graph is
+     *                loaded instead of buffering them all until finalize.
+     *                Lowers the peak ingress memory. Defaults to 0. Set
+     *                to 1 to enable.
+     * \li \c hybrid_threshold The in degree above which the "hybrid"
+     *                ingress method cuts the in edges of a vertex.
+     *                Defaults to 100.
+     * \li \c partition_cache A path prefix under which load_format()
+     *                keeps the partitioned graph of text inputs. See
+     *                load_format(). Disabled by default.
      * \li \c bufsize The batch size used by the batch ingress method.
      *                Defaults to 50,000. Increasing this number will
      *                decrease partitioning time with a penalty to partitioning
@@ -628,7 +685,9 @@ namespace graphlab {
 #else
       vertex_exchange(dc), 
 #endif
-      vset_exchange(dc), parallel_ingress(true) {
+      vset_exchange(dc), parallel_ingress(true), vertex_order("none"),
+      load_chunk_size(64 * 1024 * 1024), partition_cache_loading(false),
+      modified_outside_load(false) {
       rpc.barrier();
       set_options(opts);
     }
@@ -646,6 +705,9 @@ namespace graphlab {
       size_t bufsize = 50000;
       bool usehash = false;
       bool userecent = false;
+      bool streaming_ingress = false;
+      size_t restream_passes = 1;
+      size_t hybrid_threshold = 100;
       std::string ingress_method = "";
       std::vector<std::string> keys = opts.get_graph_args().get_option_keys();
       foreach(std::string opt, keys) {
@@ -659,6 +721,42 @@ namespace graphlab {
           if (!parallel_ingress && rpc.procid() == 0)
             logstream(LOG_EMPH) << "Disable parallel ingress. Graph will be streamed through one node."
               << std::endl;
+        } else if (opt == "vertex_order") {
+          opts.get_graph_args().get_option("vertex_order", vertex_order);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: vertex_order = "
+              << vertex_order << std::endl;
+        } else if (opt == "load_chunk_size") {
+          opts.get_graph_args().get_option("load_chunk_size", load_chunk_size);
+          if (load_chunk_size == 0) {
+            logstream(LOG_FATAL) << "load_chunk_size must be positive" << std::endl;
+          }
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: load_chunk_size = "
+              << load_chunk_size << std::endl;
+        } else if (opt == "restream_passes") {
+          opts.get_graph_args().get_option("restream_passes", restream_passes);
+          if (restream_passes == 0) {
+            logstream(LOG_FATAL) << "restream_passes must be positive" << std::endl;
+          }
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: restream_passes = "
+              << restream_passes << std::endl;
+        } else if (opt == "hybrid_threshold") {
+          opts.get_graph_args().get_option("hybrid_threshold", hybrid_threshold);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: hybrid_threshold = "
+              << hybrid_threshold << std::endl;
+        } else if (opt == "partition_cache") {
+          opts.get_graph_args().get_option("partition_cache", partition_cache);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: partition_cache = "
+              << partition_cache << std::endl;
+        } else if (opt == "streaming_ingress") {
+          opts.get_graph_args().get_option("streaming_ingress", streaming_ingress);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: streaming_ingress = "
+              << streaming_ingress << std::endl;
         }
         /**
          * These options below are deprecated.
@@ -681,8 +779,16 @@ namespace graphlab {
         }  else {
           logstream(LOG_ERROR) << "Unexpected Graph Option: " << opt << std::endl;
         }
+        // every option but the cache location may change the partitioning
+        if (opt != "partition_cache") {
+          std::string value;
+          opts.get_graph_args().get_option(opt, value);
+          graph_options_signature += opt + "=" + value + ";";
+        }
     }
-      set_ingress_method(ingress_method, bufsize, usehash, userecent);
+      set_ingress_method(ingress_method, bufsize, usehash, userecent,
+                         restream_passes, hybrid_threshold);
+      ingress_ptr->set_streaming(streaming_ingress);
     }
 
   public:
@@ -714,6 +820,7 @@ namespace graphlab {
       rpc.barrier(); 
 
       finalized = true;
+      if (!partition_cache_pending.empty()) save_partition_cache();
     }
 
     /// \brief Returns true if the graph is finalized.
@@ -836,6 +943,9 @@ namespace graphlab {
         return false;
       }
       ASSERT_NE(ingress_ptr, NULL);
+      if (!partition_cache_loading && !modified_outside_load) {
+        modified_outside_load = true;
+      }
       ingress_ptr->add_vertex(vid, vdata);
       return true;
     }
@@ -896,7 +1006,9 @@ namespace graphlab {
         return false;
       }
       ASSERT_NE(ingress_ptr, NULL);
-
+      if (!partition_cache_loading && !modified_outside_load) {
+        modified_outside_load = true;
+      }
       ingress_ptr->add_edge(source, target, edata);
       return true;
     }
@@ -1722,6 +1834,8 @@ namespace graphlab {
       std::string fname = prefix + tostr(rpc.procid()) + ".bin";
 
       logstream(LOG_INFO) << "Load graph from " << fname << std::endl;
+      // every machine must reach the final barrier, even on failure
+      bool success = true;
       if(boost::starts_with(fname, "hdfs://")) {
         graphlab::hdfs hdfs;
         graphlab::hdfs::fstream in_file(hdfs, fname);
@@ -1731,10 +1845,11 @@ namespace graphlab {
 
         if(!fin.good()) {
           logstream(LOG_ERROR) << "\n\tError opening file: " << fname << std::endl;
-          return false;
+          success = false;
+        } else {
+          iarchive iarc(fin);
+          iarc >> *this;
         }
-        iarchive iarc(fin);
-        iarc >> *this;
         fin.pop();
         fin.pop();
         in_file.close();
@@ -1743,20 +1858,23 @@ namespace graphlab {
                               std::ios_base::in | std::ios_base::binary);
         if(!in_file.good()) {
           logstream(LOG_ERROR) << "\n\tError opening file: " << fname << std::endl;
-          return false;
+          success = false;
+        } else {
+          boost::iostreams::filtering_stream<boost::iostreams::input> fin;
+          fin.push(boost::iostreams::gzip_decompressor());
+          fin.push(in_file);
+          iarchive iarc(fin);
+          iarc >> *this;
+          fin.pop();
+          fin.pop();
+          in_file.close();
         }
-        boost::iostreams::filtering_stream<boost::iostreams::input> fin;
-        fin.push(boost::iostreams::gzip_decompressor());
-        fin.push(in_file);
-        iarchive iarc(fin);
-        iarc >> *this;
-        fin.pop();
-        fin.pop();
-        in_file.close();
       }
-      logstream(LOG_INFO) << "Finish loading graph from " << fname << std::endl;
+      if (success) {
+        logstream(LOG_INFO) << "Finish loading graph from " << fname << std::endl;
+      }
       rpc.full_barrier();
-      return true;
+      return success;
     } // end of load
 
 
@@ -1827,6 +1945,247 @@ namespace graphlab {
     } // end of save
 
 
+    /** \brief Saves a distributed graph to flat binary files which can be
+     * memory mapped by load_binary_mmap(). This function must be called
+     * simultaneously on all machines.
+     *
+     * This function saves a sequence of files numbered
+     * \li [prefix]0.gbin
+     * \li [prefix]1.gbin
+     * \li [prefix]2.gbin
+     * \li etc.
+     *
+     * Each file holds the out edges of the local graph in CSR order, the
+     * vertex records and the vertex and edge data as uncompressed arrays
+     * (see mmap_graph_format.hpp). POD vertex and edge data are stored
+     * as is, other types with the graphlab serialization system.
+     * The files can only be loaded with the <b>same number of
+     * machines</b>, on machines of the same architecture, and must be on
+     * a local or shared file system.
+     *
+     * If the graph is not already finalized before save_binary_mmap() is
+     * called, this function will finalize the graph.
+     *
+     * Returns true on success, and false if the files cannot be written.
+     */
+    bool save_binary_mmap(const std::string& prefix) {
+      rpc.full_barrier();
+      finalize();
+      timer savetime;  savetime.start();
+      std::string fname = prefix + tostr(rpc.procid()) + ".gbin";
+      logstream(LOG_INFO) << "Save graph to " << fname << std::endl;
+      if(boost::starts_with(fname, "hdfs://")) {
+        logstream(LOG_ERROR) << "\n\tThe binmmap format cannot be saved to HDFS: "
+                             << fname << std::endl;
+        // keep the barriers of all machines matched
+        rpc.full_barrier();
+        return false;
+      }
+      mmap_graph_format::writer out;
+      if (!out.open(fname)) {
+        logstream(LOG_ERROR) << "\n\tError opening file: " << fname << std::endl;
+        rpc.full_barrier();
+        return false;
+      }
+      const size_t nlocal = local_graph.num_vertices();
+      {
+        std::vector<uint64_t> row_ptrs(nlocal + 1, 0);
+        std::vector<lvid_type> targets;
+        std::vector<EdgeData> edata;
+        targets.reserve(local_graph.num_edges());
+        edata.reserve(local_graph.num_edges());
+        for (lvid_type lvid = 0; lvid < nlocal; ++lvid) {
+          foreach(local_edge_type e, l_vertex(lvid).out_edges()) {
+            targets.push_back(e.target().id());
+            edata.push_back(e.data());
+          }
+          row_ptrs[lvid + 1] = targets.size();
+        }
+        out.write(mmap_graph_format::ROW_PTRS, row_ptrs);
+        out.write(mmap_graph_format::TARGETS, targets);
+        out.write_data(mmap_graph_format::EDGE_DATA, edata);
+      }
+      {
+        std::vector<VertexData> vdata(nlocal);
+        for (lvid_type lvid = 0; lvid < nlocal; ++lvid) {
+          vdata[lvid] = local_graph.vertex_data(lvid);
+        }
+        out.write_data(mmap_graph_format::VERTEX_DATA, vdata);
+      }
+      {
+        std::vector<vertex_id_type> gvids(nlocal), in_edges(nlocal),
+            out_edges(nlocal);
+        std::vector<procid_t> owners(nlocal), mirrors;
+        std::vector<uint64_t> mirror_ptrs(nlocal + 1, 0);
+        for (lvid_type lvid = 0; lvid < nlocal; ++lvid) {
+          const vertex_record& record = lvid2record[lvid];
+          gvids[lvid] = record.gvid;
+          owners[lvid] = record.owner;
+          in_edges[lvid] = record.num_in_edges;
+          out_edges[lvid] = record.num_out_edges;
+          foreach(size_t proc, record.mirrors()) mirrors.push_back(proc);
+          mirror_ptrs[lvid + 1] = mirrors.size();
+        }
+        out.write(mmap_graph_format::GVIDS, gvids);
+        out.write(mmap_graph_format::OWNERS, owners);
+        out.write(mmap_graph_format::NUM_IN_EDGES, in_edges);
+        out.write(mmap_graph_format::NUM_OUT_EDGES, out_edges);
+        out.write(mmap_graph_format::MIRROR_PTRS, mirror_ptrs);
+        out.write(mmap_graph_format::MIRRORS, mirrors);
+      }
+      mmap_graph_format::header& hdr = out.get_header();
+      hdr.procid = rpc.procid();
+      hdr.numprocs = rpc.numprocs();
+      hdr.sizeof_vertex_id = sizeof(vertex_id_type);
+      hdr.vertex_data_layout = mmap_graph_format::layout_of<VertexData>();
+      hdr.sizeof_vertex_data = sizeof(VertexData);
+      hdr.edge_data_layout = mmap_graph_format::layout_of<EdgeData>();
+      hdr.sizeof_edge_data = sizeof(EdgeData);
+      hdr.nverts = nverts;
+      hdr.nedges = nedges;
+      hdr.local_own_nverts = local_own_nverts;
+      hdr.nreplicas = nreplicas;
+      hdr.num_local_vertices = nlocal;
+      hdr.num_local_edges = local_graph.num_edges();
+      if (!out.close()) {
+        logstream(LOG_ERROR) << "\n\tError writing file: " << fname << std::endl;
+        rpc.full_barrier();
+        return false;
+      }
+      logstream(LOG_INFO) << "Finish saving graph to " << fname << std::endl
+                          << "Finished saving binmmap graph: "
+                          << savetime.current_time() << std::endl;
+      rpc.full_barrier();
+      return true;
+    } // end of save_binary_mmap
+
+
+    /** \brief Loads a distributed graph from the flat binary files saved
+     * by save_binary_mmap(). This function must be called simultaneously
+     * on all machines, and the number of machines must be the same as
+     * when the graph was saved.
+     *
+     * Each machine memory maps its own file and copies the arrays into
+     * the local graph without parsing or decompression. As the edges are
+     * stored in CSR order, finalizing the local graph is a linear pass.
+     *
+     * A graph loaded using load_binary_mmap() is already finalized and
+     * structure modifications are not permitted after loading.
+     *
+     * Return true on success and false on failure if the file cannot be
+     * loaded.
+     */
+    bool load_binary_mmap(const std::string& prefix) {
+      rpc.full_barrier();
+      timer loadtime;  loadtime.start();
+      std::string fname = prefix + tostr(rpc.procid()) + ".gbin";
+      logstream(LOG_INFO) << "Load graph from " << fname << std::endl;
+      mmap_graph_format::reader in;
+      std::string error;
+      if (!in.open(fname, error)) {
+        logstream(LOG_ERROR) << "\n\tError opening file: " << fname
+                             << ": " << error << std::endl;
+        // keep the barriers of all machines matched
+        rpc.full_barrier();
+        return false;
+      }
+      const mmap_graph_format::header& hdr = in.get_header();
+      if (hdr.procid != rpc.procid() || hdr.numprocs != rpc.numprocs()) {
+        logstream(LOG_ERROR) << "\n\t" << fname << " was saved by machine "
+                             << hdr.procid << " of " << hdr.numprocs
+                             << std::endl;
+        rpc.full_barrier();
+        return false;
+      }
+      if (hdr.sizeof_vertex_id != sizeof(vertex_id_type) ||
+          hdr.vertex_data_layout != uint64_t(mmap_graph_format::layout_of<VertexData>()) ||
+          hdr.sizeof_vertex_data != sizeof(VertexData) ||
+          hdr.edge_data_layout != uint64_t(mmap_graph_format::layout_of<EdgeData>()) ||
+          hdr.sizeof_edge_data != sizeof(EdgeData)) {
+        logstream(LOG_ERROR) << "\n\t" << fname << " was saved with different "
+                             << "vertex id, vertex data or edge data types"
+                             << std::endl;
+        rpc.full_barrier();
+        return false;
+      }
+      const size_t nlocal = hdr.num_local_vertices;
+      const size_t nlocal_edges = hdr.num_local_edges;
+      const uint64_t* row_ptrs =
+          in.data<uint64_t>(mmap_graph_format::ROW_PTRS, nlocal + 1);
+      const lvid_type* targets =
+          in.data<lvid_type>(mmap_graph_format::TARGETS, nlocal_edges);
+      const vertex_id_type* gvids =
+          in.data<vertex_id_type>(mmap_graph_format::GVIDS, nlocal);
+      const procid_t* owners =
+          in.data<procid_t>(mmap_graph_format::OWNERS, nlocal);
+      const vertex_id_type* in_edges =
+          in.data<vertex_id_type>(mmap_graph_format::NUM_IN_EDGES, nlocal);
+      const vertex_id_type* out_edges =
+          in.data<vertex_id_type>(mmap_graph_format::NUM_OUT_EDGES, nlocal);
+      const uint64_t* mirror_ptrs =
+          in.data<uint64_t>(mmap_graph_format::MIRROR_PTRS, nlocal + 1);
+      const procid_t* mirrors = mirror_ptrs == NULL ? NULL :
+          in.data<procid_t>(mmap_graph_format::MIRRORS, mirror_ptrs[nlocal]);
+      std::vector<VertexData> vdata;
+      std::vector<EdgeData> edata;
+      if (row_ptrs == NULL || targets == NULL || gvids == NULL ||
+          owners == NULL || in_edges == NULL || out_edges == NULL ||
+          mirrors == NULL ||
+          !in.read_data(mmap_graph_format::VERTEX_DATA, nlocal, vdata) ||
+          !in.read_data(mmap_graph_format::EDGE_DATA, nlocal_edges, edata)) {
+        logstream(LOG_ERROR) << "\n\tCorrupted file: " << fname << std::endl;
+        rpc.full_barrier();
+        return false;
+      }
+
+      clear();
+      nverts = hdr.nverts;
+      nedges = hdr.nedges;
+      local_own_nverts = hdr.local_own_nverts;
+      nreplicas = hdr.nreplicas;
+
+      local_graph.resize(nlocal);
+      for (lvid_type lvid = 0; lvid < nlocal; ++lvid) {
+        local_graph.vertex_data(lvid) = vdata[lvid];
+      }
+      std::vector<VertexData>().swap(vdata);
+      {
+        std::vector<lvid_type> sources(nlocal_edges);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (ssize_t lvid = 0; lvid < ssize_t(nlocal); ++lvid) {
+          for (size_t i = row_ptrs[lvid]; i < row_ptrs[lvid + 1]; ++i) {
+            sources[i] = lvid;
+          }
+        }
+        std::vector<lvid_type> dests(targets, targets + nlocal_edges);
+        local_graph.add_edges(sources, dests, edata);
+      }
+      std::vector<EdgeData>().swap(edata);
+      local_graph.finalize();
+
+      lvid2record.resize(nlocal);
+      for (lvid_type lvid = 0; lvid < nlocal; ++lvid) {
+        vertex_record& record = lvid2record[lvid];
+        record.gvid = gvids[lvid];
+        record.owner = owners[lvid];
+        record.num_in_edges = in_edges[lvid];
+        record.num_out_edges = out_edges[lvid];
+        for (size_t i = mirror_ptrs[lvid]; i < mirror_ptrs[lvid + 1]; ++i) {
+          record._mirrors.set_bit(mirrors[i]);
+        }
+        vid2lvid[record.gvid] = lvid;
+      }
+      lock_manager.resize(num_local_vertices());
+      finalized = true;
+      logstream(LOG_INFO) << "Finish loading graph from " << fname << " in "
+                          << loadtime.current_time() << " secs" << std::endl;
+      rpc.full_barrier();
+      return true;
+    } // end of load_binary_mmap
+
+
     /**
      * \brief Saves the graph to the filesystem using a provided Writer object.
      * Like \ref save(const std::string& prefix, writer writer, bool gzip, bool save_vertex, bool save_edge, size_t files_per_machine) "save()"
@@ -2131,13 +2490,13 @@ namespace graphlab {
      *               If prefix begins with "hdfs://", the output is written to
      *               HDFS.
      * \param format The file format to save in.
-     *               Either "tsv", "snap", "graphjrl" or "bin".
+     *               Either "tsv", "snap", "graphjrl", "bin" or "binmmap".
      * \param gzip If gzip compression should be used. If set, all files will be
      *             appended with the .gz suffix. Defaults to true. Ignored
-     *             if format == "bin".
+     *             if format == "bin" or "binmmap".
      * \param files_per_machine Number of files to write simultaneously in
      *                          parallel per machine. Defaults to 4. Ignored if
-     *                          format == "bin".
+     *                          format == "bin" or "binmmap".
      */
     void save_format(const std::string& prefix, const std::string& format,
                         bool gzip = true, size_t files_per_machine = 4) {
@@ -2149,6 +2508,8 @@ namespace graphlab {
              gzip, true, true, files_per_machine);
       } else if (format == "bin") {
          save_binary(prefix);
+      } else if (format == "binmmap") {
+         save_binary_mmap(prefix);
       } else if (format == "bintsv4") {
          save_direct(prefix, gzip, &graph_type::save_bintsv4_to_stream);
       } else {
@@ -2166,36 +2527,56 @@ namespace graphlab {
      *  the filesystem using the user defined line parser. Like
      *  \ref load(const std::string& path, line_parser_type line_parser)
      *  but only loads from the filesystem.
+     *
+     *  Uncompressed files larger than the load_chunk_size graph option
+     *  are split into chunks at line boundaries, and the chunks of all
+     *  the files of the machine are parsed by all threads. Gzip files
+     *  are parsed by one thread each.
      */
     void load_from_posixfs(std::string prefix,
                            line_parser_type line_parser) {
-      std::string directory_name; std::string original_path(prefix);
-      boost::filesystem::path path(prefix);
-      std::string search_prefix;
-      if (boost::filesystem::is_directory(path)) {
-        // if this is a directory
-        // force a "/" at the end of the path
-        // make sure to check that the path is non-empty. (you do not
-        // want to make the empty path "" the root path "/" )
-        directory_name = path.native();
-      }
-      else {
-        directory_name = path.parent_path().native();
-        search_prefix = path.filename().native();
-        directory_name = (directory_name.empty() ? "." : directory_name);
-      }
       std::vector<std::string> graph_files;
-      fs_util::list_files_with_prefix(directory_name, search_prefix, graph_files);
+      list_posixfs_files(prefix, graph_files);
       if (graph_files.size() == 0) {
-        logstream(LOG_WARNING) << "No files found matching " << original_path << std::endl;
+        logstream(LOG_WARNING) << "No files found matching " << prefix << std::endl;
       }
 
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
+      std::vector<file_chunk> chunks;
       for(size_t i = 0; i < graph_files.size(); ++i) {
         if ((parallel_ingress && (i % rpc.numprocs() == rpc.procid()))
             || (!parallel_ingress && (rpc.procid() == 0))) {
+          const size_t size = boost::ends_with(graph_files[i], ".gz") ? 0 :
+              boost::filesystem::file_size(graph_files[i]);
+          if (size <= load_chunk_size) {
+            chunks.push_back(file_chunk(i, 0, size_t(-1)));
+          } else {
+            for (size_t begin = 0; begin < size; begin += load_chunk_size) {
+              chunks.push_back(file_chunk(i, begin, 
+                                          std::min(begin + load_chunk_size, size)));
+            }
+          }
+        }
+      }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for(size_t c = 0; c < chunks.size(); ++c) {
+        const size_t i = chunks[c].file;
+        if (chunks[c].end != size_t(-1)) {
+          if (chunks[c].begin == 0) {
+            logstream(LOG_EMPH) << "Loading graph from file: " << graph_files[i]
+                                << " in parallel chunks" << std::endl;
+          }
+          const bool success = load_from_file_range(graph_files[i], 
+                                                    chunks[c].begin,
+                                                    chunks[c].end,
+                                                    line_parser);
+          if(!success) {
+            logstream(LOG_FATAL)
+              << "\n\tError parsing file: " << graph_files[i] << std::endl;
+          }
+        } else {
           logstream(LOG_EMPH) << "Loading graph from file: " << graph_files[i] << std::endl;
           // is it a gzip file ?
           const bool gzip = boost::ends_with(graph_files[i], ".gz");
@@ -2417,8 +2798,29 @@ namespace graphlab {
      *  machines simultaneously.
      *
      *  The supported graph formats are described in \ref graph_formats.
+     *
+     *  If the partition_cache graph option is set to a path prefix, text
+     *  inputs on a local or shared file system are cached there in the
+     *  "binmmap" format after the graph is first finalized. The cache
+     *  files are keyed by a hash of the format, the input file names,
+     *  sizes and modification times, the number of machines, the graph
+     *  options and the vertex and edge data types. A later load of the
+     *  same inputs with the same key maps the cached partitions instead
+     *  of parsing and partitioning the input again. The returned graph is
+     *  then already finalized.
+     *
+     *  The cache is only written if the graph was built from a single
+     *  load_format() call with no other add_vertex() or add_edge() calls.
      */
     void load_format(const std::string& path, const std::string& format) {
+      const bool text_format = format == "snap" || format == "adj" ||
+          format == "tsv" || format == "csv" || format == "graphjrl" ||
+          format == "bintsv4";
+      if (text_format && !partition_cache.empty() &&
+          load_partition_cache(path, format)) {
+        return;
+      }
+      partition_cache_loading = true;
       line_parser_type line_parser;
       if (format == "snap") {
         line_parser = builtin_parsers::snap_parser<distributed_graph>;
@@ -2439,11 +2841,13 @@ namespace graphlab {
          load_direct(path,&graph_type::load_bintsv4_from_stream);
       } else if (format == "bin") {
          load_binary(path);
+      } else if (format == "binmmap") {
+         load_binary_mmap(path);
       } else {
         logstream(LOG_ERROR)
           << "Unrecognized Format \"" << format << "\"!" << std::endl;
-        return;
       }
+      partition_cache_loading = false;
     } // end of load
 
 
@@ -3173,20 +3577,53 @@ namespace graphlab {
     /** Command option to disable parallel ingress. Used for simulating single node ingress */
     bool parallel_ingress;
 
+    /** The renumbering of the local vertices applied when the graph is
+        first finalized. See vertex_ordering::compute_order. */
+    std::string vertex_order;
+
+    /** The size in bytes of the chunks of uncompressed input files parsed
+        in parallel by load_from_posixfs() */
+    size_t load_chunk_size;
+
+    /** The path prefix of the partition cache, empty if disabled */
+    std::string partition_cache;
+
+    /** The cache file prefix to save the graph to at the next finalize */
+    std::string partition_cache_pending;
+
+    /** True while load_format() adds the edges of its input */
+    bool partition_cache_loading;
+
+    /** True if vertices or edges were added outside load_format(), in
+        which case the graph is not saved to the partition cache */
+    bool modified_outside_load;
+
+    /** The graph options which may change the partitioning */
+    std::string graph_options_signature;
+
 
     lock_manager_type lock_manager;
 
     void set_ingress_method(const std::string& method,
-        size_t bufsize = 50000, bool usehash = false, bool userecent = false) {
+        size_t bufsize = 50000, bool usehash = false, bool userecent = false,
+        size_t restream_passes = 1, size_t hybrid_threshold = 100) {
       if(ingress_ptr != NULL) { delete ingress_ptr; ingress_ptr = NULL; }
       if (method == "oblivious") {
         if (rpc.procid() == 0) logstream(LOG_EMPH) << "Use oblivious ingress, usehash: " << usehash
           << ", userecent: " << userecent << std::endl;
         ingress_ptr = new distributed_oblivious_ingress<VertexData, EdgeData>(rpc.dc(), *this, usehash, userecent);
+      } else if ((method == "hdrf" && restream_passes > 1) || method == "fennel") {
+        if (rpc.procid() == 0) logstream(LOG_EMPH) << "Use restreaming " << method
+          << " ingress, passes: " << restream_passes << ", usehash: " << usehash << std::endl;
+        ingress_ptr = new distributed_restream_ingress<VertexData, EdgeData>(rpc.dc(), *this, method, restream_passes, usehash);
       } else if (method == "hdrf") {
         if (rpc.procid() == 0) logstream(LOG_EMPH) << "Use hdrf oblivious ingress, usehash: " << usehash
           << ", userecent: " << userecent << std::endl;
         ingress_ptr = new distributed_hdrf_ingress<VertexData, EdgeData>(rpc.dc(), *this, usehash, userecent);
+      } else if (method == "hybrid") {
+        if (rpc.procid() == 0) logstream(LOG_EMPH) << "Use hybrid ingress, threshold: "
+          << hybrid_threshold << std::endl;
+        ingress_ptr = new distributed_hybrid_ingress<VertexData, EdgeData>(rpc.dc(), *this, hybrid_threshold);
       } else if  (method == "random") {
         if (rpc.procid() == 0)logstream(LOG_EMPH) << "Use random ingress" << std::endl;
         ingress_ptr = new distributed_random_ingress<VertexData, EdgeData>(rpc.dc(), *this); 
@@ -3223,6 +3660,198 @@ namespace graphlab {
     } // end of set ingress method
 
 
+    /**
+       \internal
+       A byte range of an input file parsed by one thread. end is -1 for
+       a whole file read through a (possibly gzip) stream.
+     */
+    struct file_chunk {
+      size_t file, begin, end;
+      file_chunk(size_t file, size_t begin, size_t end) :
+        file(file), begin(begin), end(end) { }
+    };
+
+    /**
+       \internal
+       Parses the lines of an uncompressed file which start in the byte
+       range [begin, end). The line containing byte begin - 1 belongs to
+       the previous range.
+     */
+    bool load_from_file_range(const std::string& filename, 
+                              size_t begin, size_t end,
+                              line_parser_type& line_parser) {
+      std::ifstream fin(filename.c_str(), 
+                        std::ios_base::in | std::ios_base::binary);
+      if (!fin.good()) return false;
+      std::string line;
+      size_t pos = begin;
+      if (begin > 0) {
+        fin.seekg(begin - 1);
+        std::getline(fin, line);
+        pos = begin + line.size();
+      }
+      size_t linecount = 0;
+      while(pos < end && std::getline(fin, line)) {
+        pos += line.size() + 1;
+        if(line.empty()) continue;
+        const bool success = line_parser(*this, filename, line);
+        if (!success) {
+          logstream(LOG_WARNING)
+            << "Error parsing line " << linecount << " after byte "
+            << begin << " in " << filename << ": " << std::endl
+            << "\t\"" << line << "\"" << std::endl;
+          return false;
+        }
+        ++linecount;
+      }
+      return true;
+    } // end of load from file range
+
+    /**
+       \internal
+       Lists the files matching a path prefix, or in a directory.
+     */
+    void list_posixfs_files(const std::string& prefix,
+                            std::vector<std::string>& graph_files) {
+      std::string directory_name;
+      boost::filesystem::path path(prefix);
+      std::string search_prefix;
+      if (boost::filesystem::is_directory(path)) {
+        // if this is a directory
+        // force a "/" at the end of the path
+        // make sure to check that the path is non-empty. (you do not
+        // want to make the empty path "" the root path "/" )
+        directory_name = path.native();
+      }
+      else {
+        directory_name = path.parent_path().native();
+        search_prefix = path.filename().native();
+        directory_name = (directory_name.empty() ? "." : directory_name);
+      }
+      fs_util::list_files_with_prefix(directory_name, search_prefix, graph_files);
+    } // end of list posixfs files
+
+    /**
+       \internal
+       The key of the partition cache entry of an input: a 64 bit FNV-1a
+       hash of everything which determines the partitioned graph.
+       Computed on machine 0 so that all machines agree.
+     */
+    std::string partition_cache_key(const std::string& path,
+                                    const std::string& format) {
+      std::string key;
+      if (rpc.procid() == 0) {
+        std::stringstream strm;
+        strm << format << ";" << rpc.numprocs() << ";" << parallel_ingress
+             << ";" << graph_options_signature
+             << ";" << typeid(VertexData).name()
+             << ";" << typeid(EdgeData).name();
+        std::vector<std::string> graph_files;
+        list_posixfs_files(path, graph_files);
+        foreach(const std::string& file, graph_files) {
+          strm << ";" << file << ":" << boost::filesystem::file_size(file)
+               << ":" << boost::filesystem::last_write_time(file);
+        }
+        const std::string description = strm.str();
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < description.size(); ++i) {
+          hash ^= (unsigned char)description[i];
+          hash *= 1099511628211ULL;
+        }
+        std::stringstream hex;
+        hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+        key = hex.str();
+      }
+      rpc.broadcast(key, rpc.procid() == 0);
+      return key;
+    } // end of partition cache key
+
+    /**
+       \internal
+       Loads the graph from the partition cache if all machines have a
+       valid cache file for the input, and clears the graph again if the
+       load failed on any machine. Otherwise returns false and, if
+       the graph is built from this input alone, schedules saving it to
+       the cache at the next finalize.
+     */
+    bool load_partition_cache(const std::string& path,
+                              const std::string& format) {
+      if (boost::starts_with(path, "hdfs://") ||
+          boost::starts_with(partition_cache, "hdfs://")) {
+        if (rpc.procid() == 0) {
+          logstream(LOG_WARNING) << "The partition cache does not support HDFS"
+                                 << std::endl;
+        }
+        return false;
+      }
+      // the graph must not hold anything but this input
+      size_t num_modified = modified_outside_load;
+      rpc.all_reduce(num_modified);
+      if (num_modified > 0 || num_vertices() > 0 ||
+          !partition_cache_pending.empty()) {
+        partition_cache_pending.clear();
+        return false;
+      }
+      const std::string prefix =
+          partition_cache + "_" + partition_cache_key(path, format) + ".";
+      size_t num_missing = 0;
+      {
+        mmap_graph_format::reader cache_file;
+        std::string error;
+        if (!cache_file.open(prefix + tostr(rpc.procid()) + ".gbin", error)) {
+          num_missing = 1;
+        }
+      }
+      rpc.all_reduce(num_missing);
+      if (num_missing == 0) {
+        if (rpc.procid() == 0) {
+          logstream(LOG_EMPH) << "Loading graph from partition cache "
+                              << prefix << std::endl;
+        }
+        // a truncated or corrupted file only fails on its machine, so
+        // all machines must agree before using the cache
+        size_t num_failed = load_binary_mmap(prefix) ? 0 : 1;
+        rpc.all_reduce(num_failed);
+        if (num_failed == 0) return true;
+        if (rpc.procid() == 0) {
+          logstream(LOG_WARNING) << "Failed to load the partition cache on "
+                                 << num_failed << " machines. Loading "
+                                 << path << " instead" << std::endl;
+        }
+        clear();
+      }
+      partition_cache_pending = prefix;
+      return false;
+    } // end of load partition cache
+
+    /**
+       \internal
+       Saves the finalized graph to the pending partition cache entry.
+     */
+    void save_partition_cache() {
+      std::string prefix;
+      prefix.swap(partition_cache_pending);
+      size_t num_modified = modified_outside_load;
+      rpc.all_reduce(num_modified);
+      if (num_modified > 0) {
+        if (rpc.procid() == 0) {
+          logstream(LOG_WARNING) << "Not saving the partition cache since the "
+                                 << "graph was modified outside load_format()"
+                                 << std::endl;
+        }
+        return;
+      }
+      boost::system::error_code ec;
+      const boost::filesystem::path dir =
+          boost::filesystem::path(prefix).parent_path();
+      if (!dir.empty()) boost::filesystem::create_directories(dir, ec);
+      if (rpc.procid() == 0) {
+        logstream(LOG_EMPH) << "Saving graph to partition cache "
+                            << prefix << std::endl;
+      }
+      save_binary_mmap(prefix);
+    } // end of save partition cache
+
     /**
        \internal
        This internal function is used to load a single line from an input stream
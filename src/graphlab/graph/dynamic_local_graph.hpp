@@ -48,6 +48,7 @@
 
 #include <graphlab/graph/graph_basic_types.hpp>
 #include <graphlab/graph/local_edge_buffer.hpp>
+#include <graphlab/graph/vertex_ordering.hpp>
 #include <graphlab/util/random.hpp>
 #include <graphlab/util/generics/shuffle.hpp>
 #include <graphlab/util/generics/counting_sort.hpp>
@@ -225,6 +226,34 @@ namespace graphlab {
       edge_buffer.add_block_edges(src_arr, dst_arr, edata_arr);
     } // End of add block edges
 
+    /**
+     * \brief Renumbers the vertices to improve the locality of the
+     * vertex data accesses, before the graph is first finalized.
+     *
+     * \param [in] method The ordering passed to
+     *                    vertex_ordering::compute_order.
+     * \param [out] new_lvid The new id of each previous vertex id.
+     * \return false if the vertices were left in their order.
+     */
+    bool reorder_vertices(const std::string& method,
+                          std::vector<lvid_type>& new_lvid) {
+      // only edges which are not yet finalized can be renumbered
+      ASSERT_EQ(num_edges(), 0);
+      if (!vertex_ordering::compute_order(method, vertices.size(),
+                                          edge_buffer.source_arr,
+                                          edge_buffer.target_arr,
+                                          new_lvid)) {
+        return false;
+      }
+      std::vector<VertexData> permuted(vertices.size());
+      for (size_t i = 0; i < vertices.size(); ++i) {
+        permuted[new_lvid[i]] = vertices[i];
+      }
+      vertices.swap(permuted);
+      edge_buffer.relabel(new_lvid);
+      return true;
+    } // End of reorder vertices
+
 
     /** \brief Returns a vertex of given ID. */
     vertex_type vertex(lvid_type vid) {
@@ -257,6 +286,11 @@ namespace graphlab {
      * fail if there are any duplicate edges.
      * Detail implementation depends on the type of graph_storage.
      * This is also automatically invoked by the engine at start.
+     *
+     * The CSR and then the CSC entries of the buffered edges are placed
+     * by a stable parallel counting sort, without a permutation array.
+     * Besides the edge buffer, only the entries of one of them are
+     * allocated at any time, and are freed once added to the storage.
      */
     void finalize() {
 
@@ -264,72 +298,30 @@ namespace graphlab {
 #ifdef DEBUG_GRAPH
       logstream(LOG_DEBUG) << "Graph2 finalize starts." << std::endl;
 #endif
-      std::vector<edge_id_type> src_permute;
-      std::vector<edge_id_type> dest_permute;
-      std::vector<edge_id_type> src_counting_prefix_sum;
-      std::vector<edge_id_type> dest_counting_prefix_sum;
+      // fast path with first time insertion.
+      const bool first_insertion = edges.size() == 0;
+      const edge_id_type begineid = edges.size();
 
 #ifdef DEBUG_GRAPH
       logstream(LOG_DEBUG) << "Graph2 finalize: Sort by source vertex" << std::endl;
 #endif
-      counting_sort(edge_buffer.source_arr, dest_permute, &src_counting_prefix_sum);
+      add_buffered_edges(_csr_storage, edge_buffer.source_arr,
+                         edge_buffer.target_arr, begineid, first_insertion);
 #ifdef DEBUG_GRAPH
       logstream(LOG_DEBUG) << "Graph2 finalize: Sort by dest id" << std::endl;
 #endif
-      counting_sort(edge_buffer.target_arr, src_permute, &dest_counting_prefix_sum);
-
-      std::vector< std::pair<lvid_type, edge_id_type> >  csr_values;
-      std::vector< std::pair<lvid_type, edge_id_type> >  csc_values;
-
-      csr_values.reserve(dest_permute.size());
-      edge_id_type begineid = edges.size();
-      for (size_t i = 0; i < dest_permute.size(); ++i) {
-        csr_values.push_back(std::pair<lvid_type, edge_id_type> (edge_buffer.target_arr[dest_permute[i]],
-                                                                 begineid + dest_permute[i]));
-      }
-      csc_values.reserve(src_permute.size());
+      add_buffered_edges(_csc_storage, edge_buffer.target_arr,
+                         edge_buffer.source_arr, begineid, first_insertion);
 
-      for (size_t i = 0; i < src_permute.size(); ++i) {
-        csc_values.push_back(std::pair<lvid_type, edge_id_type> (edge_buffer.source_arr[src_permute[i]],
-                                                                 begineid + src_permute[i]));
-      }
-      ASSERT_EQ(csc_values.size(), csr_values.size());
-
-      // fast path with first time insertion.
-      if (edges.size() == 0) {
+      if (first_insertion) {
         edges.swap(edge_buffer.data);
-        edge_buffer.clear();
-        // warp into csr csc storage.
-        _csr_storage.wrap(src_counting_prefix_sum, csr_values);
-        _csc_storage.wrap(dest_counting_prefix_sum, csc_values);
       } else {
         // insert edge data
         edges.reserve(edges.size() + edge_buffer.size());
         edges.insert(edges.end(), edge_buffer.data.begin(), edge_buffer.data.end());
         std::vector<EdgeData>().swap(edge_buffer.data);
-        edge_buffer.clear();
-        size_t begin, end;
-        for (size_t i = 0; i < src_counting_prefix_sum.size(); ++i) {
-          begin = src_counting_prefix_sum[i];
-          end = (i==src_counting_prefix_sum.size()-1)
-              ? csr_values.size()
-              : src_counting_prefix_sum[i+1];
-          if (end > begin) {
-            _csr_storage.insert(i, csr_values.begin()+begin, csr_values.begin()+end);
-          }
-        }
-        for (size_t i = 0; i < dest_counting_prefix_sum.size(); ++i) {
-          begin = dest_counting_prefix_sum[i];
-          end = (i==dest_counting_prefix_sum.size()-1)
-              ? csc_values.size()
-              : dest_counting_prefix_sum[i+1];
-          if (end > begin) {
-            _csc_storage.insert(i, csc_values.begin()+begin, csc_values.begin()+end);
-          }
-        }
-        _csr_storage.repack();
-        _csc_storage.repack();
       }
+      edge_buffer.clear();
       ASSERT_EQ(_csr_storage.num_values(), _csc_storage.num_values());
       ASSERT_EQ(_csr_storage.num_values(), edges.size());
 
@@ -513,6 +505,53 @@ namespace graphlab {
 
     typedef typename csr_type::iterator csr_edge_iterator;
 
+    /**
+     * \internal
+     * Writes the entry (others[i], begineid + i) of the buffered edge i
+     * at its position in the sorted order.
+     */
+    struct edge_entry_output {
+      const std::vector<lvid_type>* others;
+      std::vector<std::pair<lvid_type, edge_id_type> >* values;
+      edge_id_type begineid;
+      edge_entry_output(const std::vector<lvid_type>* others,
+                        std::vector<std::pair<lvid_type, edge_id_type> >* values,
+                        edge_id_type begineid) :
+        others(others), values(values), begineid(begineid) { }
+      inline void operator()(size_t i, size_t pos) {
+        (*values)[pos] = std::make_pair((*others)[i], edge_id_type(begineid + i));
+      }
+    };
+
+    /**
+     * \internal
+     * Adds the buffered edges to storage, each under keys[i] with entry
+     * (others[i], begineid + i). The storage is replaced if wrap is set,
+     * and extended and repacked otherwise.
+     */
+    void add_buffered_edges(csr_type& storage,
+                            const std::vector<lvid_type>& keys,
+                            const std::vector<lvid_type>& others,
+                            edge_id_type begineid, bool wrap) {
+      std::vector<edge_id_type> prefix;
+      std::vector<std::pair<lvid_type, edge_id_type> > values(keys.size());
+      parallel_counting_scatter(keys, prefix,
+                                edge_entry_output(&others, &values, begineid));
+      if (wrap) {
+        storage.wrap(prefix, values);
+        return;
+      }
+      for (size_t i = 0; i < prefix.size(); ++i) {
+        const size_t begin = prefix[i];
+        const size_t end = (i + 1 == prefix.size()) ? values.size()
+                                                    : prefix[i + 1];
+        if (end > begin) {
+          storage.insert(i, values.begin() + begin, values.begin() + end);
+        }
+      }
+      storage.repack();
+    }
+
     // PRIVATE DATA MEMBERS ===================================================>
     //
     /** The vertex data is simply a vector of vertex data */
@@ -31,8 +31,9 @@
 #include <graphlab/graph/distributed_graph.hpp>
 #include <graphlab/rpc/buffered_exchange.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
-#include <graphlab/util/dense_bitset.hpp>
+#include <graphlab/util/mirror_set.hpp>
 #include <graphlab/util/cuckoo_map_pow2.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/graph/ingress/sharding_constraint.hpp>
 #include <graphlab/macros_def.hpp>
 namespace graphlab {
@@ -57,7 +58,7 @@ namespace graphlab {
 
     typedef distributed_ingress_base<VertexData, EdgeData> base_type;
     // typedef typename boost::unordered_map<vertex_id_type, std::vector<size_t> > degree_hash_table_type;
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+    typedef mirror_set bin_counts_type; 
 
     /** Type of the degree hash table: 
      * a map from vertex id to a bitset of length num_procs. */
@@ -66,6 +67,7 @@ namespace graphlab {
 
     /** Array of number of edges on each proc. */
     std::vector<size_t> proc_num_edges;
+    simple_spinlock obliv_lock;
 
     /** Ingress tratis. */
     bool usehash;
@@ -88,14 +90,16 @@ namespace graphlab {
     /** Add an edge to the ingress object using oblivious greedy assignment. */
     void add_edge(vertex_id_type source, vertex_id_type target,
                   const EdgeData& edata) {
+      obliv_lock.lock();
       dht[source]; dht[target];
       const std::vector<procid_t>& candidates = 
         constraint->get_joint_neighbors(get_master(source), get_master(target));
       const procid_t owning_proc = 
         base_type::edge_decision.edge_to_proc_greedy(source, target, dht[source], dht[target], candidates, proc_num_edges, usehash, userecent);
+      obliv_lock.unlock();
       typedef typename base_type::edge_buffer_record edge_buffer_record;
       edge_buffer_record record(source, target, edata);
-      base_type::edge_exchange.send(owning_proc, record);
+      base_type::send_edge(owning_proc, record);
     } // end of add edge
 
     virtual void finalize() {
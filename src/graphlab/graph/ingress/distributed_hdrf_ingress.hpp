@@ -30,8 +30,9 @@
 #include <graphlab/graph/distributed_graph.hpp>
 #include <graphlab/rpc/buffered_exchange.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
-#include <graphlab/util/dense_bitset.hpp>
+#include <graphlab/util/mirror_set.hpp>
 #include <graphlab/util/cuckoo_map_pow2.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/macros_def.hpp>
 namespace graphlab {
   template<typename VertexData, typename EdgeData>
@@ -51,7 +52,7 @@ namespace graphlab {
     typedef typename graph_type::mirror_type mirror_type;
 
     typedef distributed_ingress_base<VertexData, EdgeData> base_type;
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+    typedef mirror_set bin_counts_type; 
 
     /** Type of the replica degree hash table: 
      * a map from vertex id to a bitset of length num_procs.
@@ -67,6 +68,7 @@ namespace graphlab {
 
     /** Array of number of edges on each proc. */
     std::vector<size_t> proc_num_edges;
+    simple_spinlock hdrf_lock;
 
     /** Ingress tratis. */
     bool usehash;
@@ -85,15 +87,17 @@ namespace graphlab {
     /** Add an edge to the ingress object using hdrf greedy assignment. */
     void add_edge(vertex_id_type source, vertex_id_type target,
                   const EdgeData& edata) {
+      hdrf_lock.lock();
       dht[source]; dht[target];
       degree_dht[source]; degree_dht[target];
 
       const procid_t owning_proc = 
         base_type::edge_decision.edge_to_proc_hdrf(source, target, dht[source], dht[target], degree_dht[source], degree_dht[target], proc_num_edges, usehash, userecent);
+      hdrf_lock.unlock();
 
       typedef typename base_type::edge_buffer_record edge_buffer_record;
       edge_buffer_record record(source, target, edata);
-      base_type::edge_exchange.send(owning_proc, record);
+      base_type::send_edge(owning_proc, record);
     } // end of add edge
 
     virtual void finalize() {
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.  All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ *  use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_DISTRIBUTED_HYBRID_INGRESS_HPP
+#define GRAPHLAB_DISTRIBUTED_HYBRID_INGRESS_HPP
+
+#include <vector>
+
+#include <graphlab/rpc/buffered_exchange.hpp>
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/graph/graph_hash.hpp>
+#include <graphlab/graph/ingress/distributed_ingress_base.hpp>
+#include <graphlab/graph/distributed_graph.hpp>
+#include <graphlab/util/hopscotch_map.hpp>
+
+
+#include <graphlab/macros_def.hpp>
+namespace graphlab {
+  template<typename VertexData, typename EdgeData>
+  class distributed_graph;
+
+  /**
+   * \brief Ingress object placing edges with a hybrid cut.
+   *
+   * The in edges of a vertex with at most threshold in edges are all
+   * placed on its master, as in an edge-cut, so the vertex needs no
+   * mirror to gather. The in edges of the high degree vertices are
+   * spread by the hash of their source, as in a vertex-cut.
+   *
+   * Since the degrees are only known once the whole graph is loaded,
+   * every edge is first sent to the master of its target, which counts
+   * the in degrees. At finalize, the masters forward the edges of their
+   * high degree vertices.
+   *
+   * Based on the publication:
+   * R. Chen, J. Shi, Y. Chen and H. Chen:
+   * "PowerLyra: Differentiated Graph Computation and Partitioning on
+   * Skewed Graphs". EuroSys, 2015.
+   */
+  template<typename VertexData, typename EdgeData>
+  class distributed_hybrid_ingress :
+    public distributed_ingress_base<VertexData, EdgeData> {
+  public:
+    typedef distributed_graph<VertexData, EdgeData> graph_type;
+    /// The type of the vertex data stored in the graph
+    typedef VertexData vertex_data_type;
+    /// The type of the edge data stored in the graph
+    typedef EdgeData   edge_data_type;
+
+    typedef distributed_ingress_base<VertexData, EdgeData> base_type;
+    typedef typename base_type::edge_buffer_record edge_buffer_record;
+    typedef typename base_type::edge_buffer_type edge_buffer_type;
+
+    /// Edges on their way to the master of their target
+    buffered_exchange<edge_buffer_record> hybrid_edge_exchange;
+
+    /// The in degree of the vertices mastered by this machine
+    hopscotch_map<vertex_id_type, size_t> in_degree;
+
+    /// Vertices with more in edges are cut
+    size_t threshold;
+
+  public:
+    distributed_hybrid_ingress(distributed_control& dc, graph_type& graph,
+                               size_t threshold) :
+      base_type(dc, graph),
+#ifdef _OPENMP
+      hybrid_edge_exchange(dc, omp_get_max_threads()),
+#else
+      hybrid_edge_exchange(dc),
+#endif
+      threshold(threshold) {
+    } // end of constructor
+
+    ~distributed_hybrid_ingress() { }
+
+    /** Send the edge to the master of its target. */
+    void add_edge(vertex_id_type source, vertex_id_type target,
+                  const EdgeData& edata) {
+      const procid_t owning_proc =
+        graph_hash::hash_vertex(target) % base_type::rpc.numprocs();
+      const edge_buffer_record record(source, target, edata);
+#ifdef _OPENMP
+      hybrid_edge_exchange.send(owning_proc, record, omp_get_thread_num());
+#else
+      hybrid_edge_exchange.send(owning_proc, record);
+#endif
+    } // end of add edge
+
+    virtual void finalize() {
+      hybrid_edge_exchange.flush();
+
+      // Count the in degrees of the vertices mastered here
+      std::vector<edge_buffer_type> buffers;
+      {
+        edge_buffer_type buffer;
+        procid_t proc;
+        while(hybrid_edge_exchange.recv(proc, buffer)) {
+          foreach(const edge_buffer_record& rec, buffer) {
+            ++in_degree[rec.target];
+          }
+          buffers.push_back(edge_buffer_type());
+          buffers.back().swap(buffer);
+        }
+      }
+
+      // Keep the edges of low degree targets, cut the others by source
+      const procid_t numprocs = base_type::rpc.numprocs();
+      const procid_t procid = base_type::rpc.procid();
+      size_t num_edges = 0, num_cut_edges = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+ : num_edges, num_cut_edges)
+#endif
+      for (ssize_t i = 0; i < ssize_t(buffers.size()); ++i) {
+        foreach(const edge_buffer_record& rec, buffers[i]) {
+          procid_t owning_proc = procid;
+          if (in_degree.find(rec.target)->second > threshold) {
+            owning_proc = graph_hash::hash_vertex(rec.source) % numprocs;
+            ++num_cut_edges;
+          }
+          base_type::send_edge(owning_proc, rec);
+          ++num_edges;
+        }
+        edge_buffer_type().swap(buffers[i]);
+      }
+      base_type::rpc.all_reduce(num_edges);
+      base_type::rpc.all_reduce(num_cut_edges);
+      if (procid == 0) {
+        logstream(LOG_EMPH) << "Hybrid ingress: " << num_cut_edges << " of "
+                            << num_edges << " new edges are in edges of "
+                            << "vertices with more than " << threshold
+                            << " in edges" << std::endl;
+      }
+      base_type::finalize();
+    } // end of finalize
+  }; // end of distributed_hybrid_ingress
+}; // end of namespace graphlab
+#include <graphlab/macros_undef.hpp>
+
+
+#endif
@@ -64,7 +64,7 @@ namespace graphlab {
       typedef typename base_type::edge_buffer_record edge_buffer_record;
       const procid_t owning_proc = base_type::rpc.procid();
       const edge_buffer_record record(source, target, edata);
-      base_type::edge_exchange.send(owning_proc, record);
+      base_type::send_edge(owning_proc, record);
     } // end of add edge
   }; // end of distributed_identity_ingress
 }; // end of namespace graphlab
@@ -111,6 +111,16 @@ namespace graphlab {
     /// Ingress decision object for computing the edge destination. 
     ingress_edge_decision<VertexData, EdgeData> edge_decision;
 
+    typedef typename graph_type::hopscotch_map_type vid2lvid_map_type;
+
+    typedef typename buffered_exchange<edge_buffer_record>::buffer_type 
+      edge_buffer_type;
+
+    /// Number of edges a thread sends between two streaming drains
+    static const size_t STREAMING_DRAIN_INTERVAL = 65536;
+    /// Number of locks guarding the mirror sets in the master handshake
+    static const size_t MIRROR_LOCK_COUNT = 1024;
+
   public:
     distributed_ingress_base(distributed_control& dc, graph_type& graph) :
       rpc(dc, this), graph(graph), 
@@ -120,7 +130,12 @@ namespace graphlab {
 #else
       vertex_exchange(dc), edge_exchange(dc),
 #endif
-      edge_decision(dc) {
+      edge_decision(dc), streaming(false), num_drained_edges(0) {
+#ifdef _OPENMP
+      sends_since_drain.resize(omp_get_max_threads(), 0);
+#else
+      sends_since_drain.resize(1, 0);
+#endif
       rpc.barrier();
     } // end of constructor
 
@@ -132,11 +147,7 @@ namespace graphlab {
       const procid_t owning_proc = 
         edge_decision.edge_to_proc_random(source, target, rpc.numprocs());
       const edge_buffer_record record(source, target, edata);
-#ifdef _OPENMP
-      edge_exchange.send(owning_proc, record, omp_get_thread_num());
-#else
-      edge_exchange.send(owning_proc, record);
-#endif
+      send_edge(owning_proc, record);
     } // end of add edge
 
 
@@ -152,6 +163,40 @@ namespace graphlab {
     } // end of add vertex
 
 
+    /**
+     * \brief Sends an edge to the machine which stores it.
+     *
+     * In streaming mode, every STREAMING_DRAIN_INTERVAL sends the calling
+     * thread also moves the edges received so far into the local graph,
+     * unless another thread is already doing so.
+     */
+    void send_edge(procid_t owning_proc, const edge_buffer_record& record) {
+#ifdef _OPENMP
+      const size_t thread_id = omp_get_thread_num();
+#else
+      const size_t thread_id = 0;
+#endif
+      edge_exchange.send(owning_proc, record, thread_id);
+      if (streaming && 
+          ++sends_since_drain[thread_id] >= STREAMING_DRAIN_INTERVAL) {
+        sends_since_drain[thread_id] = 0;
+        drain_edge_exchange(true);
+      }
+    } // end of send edge
+
+
+    /**
+     * \brief Enables or disables streaming ingress.
+     *
+     * Without streaming, the edges sent to this machine are kept in the
+     * exchange buffers until finalize(). With streaming, they are
+     * periodically converted to local edges while the graph is loaded,
+     * so the full set of edge_buffer_records never exists at once and
+     * the peak ingress memory stays close to the size of the local graph.
+     */
+    void set_streaming(bool enabled) { streaming = enabled; }
+
+
     void set_duplicate_vertex_strategy(
         boost::function<void(vertex_data_type&,
                              const vertex_data_type&)> combine_strategy) {
@@ -187,7 +232,8 @@ namespace graphlab {
        * Fast pass for first time finalization. 
        */
       if (graph.is_dynamic()) {
-        size_t nverts = graph.num_local_vertices();
+        // the local graph may already hold streamed vertices
+        size_t nverts = graph.vid2lvid.size();
         rpc.all_reduce(nverts);
         first_time_finalize = (nverts == 0);
       } else {
@@ -202,30 +248,18 @@ namespace graphlab {
       typedef typename hopscotch_map<vertex_id_type, lvid_type>::value_type
         vid2lvid_pair_type;
 
-      typedef typename buffered_exchange<edge_buffer_record>::buffer_type 
-        edge_buffer_type;
-
       typedef typename buffered_exchange<vertex_buffer_record>::buffer_type 
         vertex_buffer_type;
 
-      /**
-       * \internal
-       * Buffer storage for new vertices to the local graph.
-       */
-      typedef typename graph_type::hopscotch_map_type vid2lvid_map_type;
-      vid2lvid_map_type vid2lvid_buffer;
-
       /**
        * \internal
        * The begining id assinged to the first new vertex.
        */
       const lvid_type lvid_start  = graph.vid2lvid.size();
 
-      /**
-       * \internal
-       * Bit field incidate the vertex that is updated during the ingress. 
-       */
-      dense_bitset updated_lvids(graph.vid2lvid.size());
+      if (updated_lvids.size() < graph.vid2lvid.size()) {
+        updated_lvids.resize(graph.vid2lvid.size());
+      }
 
       /**************************************************************************/
       /*                                                                        */
@@ -238,7 +272,8 @@ namespace graphlab {
        * Fast pass for redundant finalization with no graph changes. 
        */
       {
-        size_t changed_size = edge_exchange.size() + vertex_exchange.size();
+        size_t changed_size = edge_exchange.size() + vertex_exchange.size() +
+            num_drained_edges;
         rpc.all_reduce(changed_size);
         if (changed_size == 0) {
           logstream(LOG_INFO) << "Skipping Graph Finalization because no changes happened..." << std::endl;
@@ -257,42 +292,9 @@ namespace graphlab {
       /**************************************************************************/
       { // Add all the edges to the local graph
         logstream(LOG_INFO) << "Graph Finalize: constructing local graph" << std::endl;
-        const size_t nedges = edge_exchange.size()+1;
+        const size_t nedges = num_drained_edges + edge_exchange.size()+1;
         graph.local_graph.reserve_edge_space(nedges + 1);      
-        edge_buffer_type edge_buffer;
-        procid_t proc;
-        while(edge_exchange.recv(proc, edge_buffer)) {
-          foreach(const edge_buffer_record& rec, edge_buffer) {
-            // Get the source_vlid;
-            lvid_type source_lvid(-1);
-            if(graph.vid2lvid.find(rec.source) == graph.vid2lvid.end()) {
-              if (vid2lvid_buffer.find(rec.source) == vid2lvid_buffer.end()) {
-                source_lvid = lvid_start + vid2lvid_buffer.size();
-                vid2lvid_buffer[rec.source] = source_lvid;
-              } else {
-                source_lvid = vid2lvid_buffer[rec.source];
-              }
-            } else {
-              source_lvid = graph.vid2lvid[rec.source];
-              updated_lvids.set_bit(source_lvid);
-            }
-            // Get the target_lvid;
-            lvid_type target_lvid(-1);
-            if(graph.vid2lvid.find(rec.target) == graph.vid2lvid.end()) {
-              if (vid2lvid_buffer.find(rec.target) == vid2lvid_buffer.end()) {
-                target_lvid = lvid_start + vid2lvid_buffer.size();
-                vid2lvid_buffer[rec.target] = target_lvid;
-              } else {
-                target_lvid = vid2lvid_buffer[rec.target];
-              }
-            } else {
-              target_lvid = graph.vid2lvid[rec.target];
-              updated_lvids.set_bit(target_lvid);
-            }
-            graph.local_graph.add_edge(source_lvid, target_lvid, rec.edata);
-            // std::cout << "add edge " << rec.source << "\t" << rec.target << std::endl;
-          } // end of loop over add edges
-        } // end for loop over buffers
+        drain_edge_exchange(false);
         edge_exchange.clear();
 
         ASSERT_EQ(graph.vid2lvid.size()  + vid2lvid_buffer.size(), graph.local_graph.num_vertices());
@@ -300,6 +302,21 @@ namespace graphlab {
           memory_info::log_usage("Finished populating local graph.");
         }
 
+        // Renumber the vertices of a newly constructed local graph
+        // for locality. Only the edges and vid2lvid_buffer refer to
+        // the lvids at this point.
+        if (lvid_start == 0) {
+          std::vector<lvid_type> new_lvid;
+          if (graph.local_graph.reorder_vertices(graph.vertex_order, new_lvid)) {
+            for (typename vid2lvid_map_type::iterator it = vid2lvid_buffer.begin();
+                 it != vid2lvid_buffer.end(); ++it) {
+              it->second = new_lvid[it->second];
+            }
+            logstream(LOG_INFO) << "Graph Finalize: renumbered vertices in "
+                                << graph.vertex_order << " order" << std::endl;
+          }
+        }
+
         // Finalize local graph
         logstream(LOG_INFO) << "Graph Finalize: finalizing local graph." 
                             << std::endl;
@@ -402,9 +419,11 @@ namespace graphlab {
         vid_buffer.flush();
         rpc.barrier();
 
-        // receive all vids owned by me
+        // receive all vids owned by me. mirror_type::set_bit is not
+        // atomic, so the mirrors are updated under a lock picked by vid.
         mutex flying_vids_lock;
         boost::unordered_map<vertex_id_type, mirror_type> flying_vids;
+        std::vector<simple_spinlock> mirror_locks(MIRROR_LOCK_COUNT);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -413,19 +432,27 @@ namespace graphlab {
           procid_t recvid;
           while(vid_buffer.recv(recvid, buffer)) {
             foreach(const vertex_id_type vid, buffer) {
+              simple_spinlock& mirror_lock =
+                mirror_locks[vid % MIRROR_LOCK_COUNT];
               if (graph.vid2lvid.find(vid) == graph.vid2lvid.end()) {
                 if (vid2lvid_buffer.find(vid) == vid2lvid_buffer.end()) {
                   flying_vids_lock.lock();
                   mirror_type& mirrors = flying_vids[vid];
                   flying_vids_lock.unlock();
+                  mirror_lock.lock();
                   mirrors.set_bit(recvid);
+                  mirror_lock.unlock();
                 } else {
                   lvid_type lvid = vid2lvid_buffer[vid];
+                  mirror_lock.lock();
                   graph.lvid2record[lvid]._mirrors.set_bit(recvid);
+                  mirror_lock.unlock();
                 }
               } else {
                 lvid_type lvid = graph.vid2lvid[vid];
+                mirror_lock.lock();
                 graph.lvid2record[lvid]._mirrors.set_bit(recvid);
+                mirror_lock.unlock();
                 updated_lvids.set_bit(lvid);
               }
             }
@@ -505,6 +532,9 @@ namespace graphlab {
           memory_info::log_usage("Finished synchronizing vertex (meta)data");
       }
 
+      updated_lvids.clear();
+      num_drained_edges = 0;
+
       exchange_global_info();
     } // end of finalize
 
@@ -556,6 +586,87 @@ namespace graphlab {
   private:
     boost::function<void(vertex_data_type&, const vertex_data_type&)> vertex_combine_strategy;
 
+    /// True if received edges are moved into the local graph during ingress
+    bool streaming;
+
+    /// The number of edges each thread sent since its last streaming drain
+    std::vector<size_t> sends_since_drain;
+
+    /// Held while moving received edges into the local graph
+    mutex drain_lock;
+
+    /// The number of edges moved into the local graph since the last finalize
+    size_t num_drained_edges;
+
+    /// The lvids of the vertices added to the local graph since the last
+    /// finalize, which are not in graph.vid2lvid yet
+    vid2lvid_map_type vid2lvid_buffer;
+
+    /// The existing vertices which were updated since the last finalize
+    dense_bitset updated_lvids;
+
+    /**
+     * \internal
+     * Moves all the edges received so far into the local graph. If
+     * try_lock is set, returns immediately when another thread is
+     * draining.
+     */
+    void drain_edge_exchange(bool try_lock) {
+      if (try_lock) {
+        if (!drain_lock.try_lock()) return;
+      } else {
+        drain_lock.lock();
+      }
+      edge_buffer_type edge_buffer;
+      procid_t proc;
+      while(edge_exchange.recv(proc, edge_buffer, try_lock)) {
+        add_local_edges(edge_buffer);
+      }
+      drain_lock.unlock();
+    } // end of drain edge exchange
+
+    /**
+     * \internal
+     * Adds received edges to the local graph, assigning lvids to the
+     * vertices seen for the first time.
+     */
+    void add_local_edges(const edge_buffer_type& edge_buffer) {
+      const lvid_type lvid_start = graph.vid2lvid.size();
+      if (updated_lvids.size() < graph.vid2lvid.size()) {
+        updated_lvids.resize(graph.vid2lvid.size());
+      }
+      foreach(const edge_buffer_record& rec, edge_buffer) {
+        // Get the source_vlid;
+        lvid_type source_lvid(-1);
+        if(graph.vid2lvid.find(rec.source) == graph.vid2lvid.end()) {
+          if (vid2lvid_buffer.find(rec.source) == vid2lvid_buffer.end()) {
+            source_lvid = lvid_start + vid2lvid_buffer.size();
+            vid2lvid_buffer[rec.source] = source_lvid;
+          } else {
+            source_lvid = vid2lvid_buffer[rec.source];
+          }
+        } else {
+          source_lvid = graph.vid2lvid[rec.source];
+          updated_lvids.set_bit(source_lvid);
+        }
+        // Get the target_lvid;
+        lvid_type target_lvid(-1);
+        if(graph.vid2lvid.find(rec.target) == graph.vid2lvid.end()) {
+          if (vid2lvid_buffer.find(rec.target) == vid2lvid_buffer.end()) {
+            target_lvid = lvid_start + vid2lvid_buffer.size();
+            vid2lvid_buffer[rec.target] = target_lvid;
+          } else {
+            target_lvid = vid2lvid_buffer[rec.target];
+          }
+        } else {
+          target_lvid = graph.vid2lvid[rec.target];
+          updated_lvids.set_bit(target_lvid);
+        }
+        graph.local_graph.add_edge(source_lvid, target_lvid, rec.edata);
+      } // end of loop over add edges
+      num_drained_edges += edge_buffer.size();
+    } // end of add local edges
+
     /**
      * \brief Gather the vertex distributed meta data.
      */
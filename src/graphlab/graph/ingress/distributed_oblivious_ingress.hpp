@@ -30,7 +30,7 @@
 #include <graphlab/graph/distributed_graph.hpp>
 #include <graphlab/rpc/buffered_exchange.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
-#include <graphlab/util/dense_bitset.hpp>
+#include <graphlab/util/mirror_set.hpp>
 #include <graphlab/util/cuckoo_map_pow2.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/macros_def.hpp>
@@ -56,7 +56,7 @@ namespace graphlab {
 
     typedef distributed_ingress_base<VertexData, EdgeData> base_type;
     // typedef typename boost::unordered_map<vertex_id_type, std::vector<size_t> > degree_hash_table_type;
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+    typedef mirror_set bin_counts_type; 
 
     /** Type of the degree hash table: 
      * a map from vertex id to a bitset of length num_procs. */
@@ -92,11 +92,7 @@ namespace graphlab {
 
       typedef typename base_type::edge_buffer_record edge_buffer_record;
       edge_buffer_record record(source, target, edata);
-#ifdef _OPENMP
-      base_type::edge_exchange.send(owning_proc, record, omp_get_thread_num());
-#else      
-      base_type::edge_exchange.send(owning_proc, record);
-#endif
+      base_type::send_edge(owning_proc, record);
     } // end of add edge
 
     virtual void finalize() {
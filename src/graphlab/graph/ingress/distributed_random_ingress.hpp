@@ -65,7 +65,7 @@ namespace graphlab {
       typedef typename base_type::edge_buffer_record edge_buffer_record;
       const procid_t owning_proc = base_type::edge_decision.edge_to_proc_random(source, target, base_type::rpc.numprocs());
       const edge_buffer_record record(source, target, edata);
-      base_type::edge_exchange.send(owning_proc, record);
+      base_type::send_edge(owning_proc, record);
     } // end of add edge
   }; // end of distributed_random_ingress
 }; // end of namespace graphlab
@@ -0,0 +1,251 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.  All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ *  use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_DISTRIBUTED_RESTREAM_INGRESS_HPP
+#define GRAPHLAB_DISTRIBUTED_RESTREAM_INGRESS_HPP
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/graph/ingress/distributed_ingress_base.hpp>
+#include <graphlab/graph/ingress/ingress_edge_decision.hpp>
+#include <graphlab/graph/distributed_graph.hpp>
+#include <graphlab/util/mirror_set.hpp>
+#include <graphlab/util/hopscotch_map.hpp>
+#include <graphlab/macros_def.hpp>
+namespace graphlab {
+  template<typename VertexData, typename EdgeData>
+    class distributed_graph;
+
+  /**
+   * \brief Ingress which places the edges loaded by each machine with
+   * several greedy passes over them.
+   *
+   * The edges are kept on the machine which loaded them until finalize.
+   * Every pass then places all of them with the "hdrf" or "fennel"
+   * score. From the second pass on, a vertex counts as present on the
+   * machines where it was replicated at the end of the previous pass,
+   * so that the early edges of a vertex follow its later ones instead of
+   * being placed blindly. Since all edges are known before the first
+   * pass, HDRF uses the full vertex degrees and Fennel derives its load
+   * penalty from the edge and vertex counts.
+   *
+   * Each pass logs the replication factor and the edge and vertex
+   * imbalance of its placement.
+   */
+  template<typename VertexData, typename EdgeData>
+  class distributed_restream_ingress:
+    public distributed_ingress_base<VertexData, EdgeData> {
+  public:
+    typedef distributed_graph<VertexData, EdgeData> graph_type;
+    /// The type of the vertex data stored in the graph
+    typedef VertexData vertex_data_type;
+    /// The type of the edge data stored in the graph
+    typedef EdgeData   edge_data_type;
+
+    typedef distributed_ingress_base<VertexData, EdgeData> base_type;
+    typedef typename base_type::edge_buffer_record edge_buffer_record;
+    typedef mirror_set bin_counts_type;
+
+    /// The exponent of the Fennel load cost
+    static const double FENNEL_GAMMA;
+    /// The Fennel edge capacity of a machine relative to the average
+    static const double FENNEL_SLACK;
+
+  public:
+    /**
+     * \param method "hdrf" or "fennel"
+     * \param passes The number of placement passes, at least 1
+     */
+    distributed_restream_ingress(distributed_control& dc, graph_type& graph,
+                                 const std::string& method, size_t passes,
+                                 bool usehash = false) :
+      base_type(dc, graph), method(method), passes(passes),
+      usehash(usehash) {
+      ASSERT_GE(passes, 1);
+    }
+
+    ~distributed_restream_ingress() { }
+
+    /** Keep the edge until finalize. */
+    void add_edge(vertex_id_type source, vertex_id_type target,
+                  const EdgeData& edata) {
+      edges_lock.lock();
+      edges.push_back(edge_buffer_record(source, target, edata));
+      edges_lock.unlock();
+    } // end of add edge
+
+    virtual void finalize() {
+      std::vector<procid_t> assignment;
+      compute_assignment(assignment);
+      for (size_t i = 0; i < edges.size(); ++i) {
+        base_type::send_edge(assignment[i], edges[i]);
+      }
+      std::vector<edge_buffer_record>().swap(edges);
+      base_type::finalize();
+    } // end of finalize
+
+  private:
+    std::string method;
+    size_t passes;
+    bool usehash;
+
+    /// The edges loaded by this machine since the last finalize
+    std::vector<edge_buffer_record> edges;
+    mutex edges_lock;
+
+    /**
+     * Places the loaded edges, running all the passes. Must be called on
+     * all machines since the passes are reported collectively.
+     */
+    void compute_assignment(std::vector<procid_t>& assignment) {
+      const size_t numprocs = base_type::rpc.numprocs();
+      const size_t nedges = edges.size();
+
+      // Number the vertices and count their degrees
+      hopscotch_map<vertex_id_type, lvid_type> vid2idx;
+      std::vector<lvid_type> src_idx(nedges), dst_idx(nedges);
+      std::vector<size_t> degree;
+      for (size_t i = 0; i < nedges; ++i) {
+        src_idx[i] = vertex_index(vid2idx, degree, edges[i].source);
+        dst_idx[i] = vertex_index(vid2idx, degree, edges[i].target);
+      }
+      vid2idx.clear();
+      const size_t nverts = degree.size();
+
+      // The load of a machine with e edges costs alpha * e^gamma. The
+      // cost of a perfectly balanced placement is then comparable to the
+      // number of vertices, like the objective of Fennel.
+      const double alpha = nedges == 0 ? 0 :
+          nverts * std::pow(double(numprocs), FENNEL_GAMMA - 1) /
+          std::pow(double(nedges), FENNEL_GAMMA);
+      const size_t capacity =
+          size_t(FENNEL_SLACK * nedges / numprocs) + 1;
+
+      std::vector<bin_counts_type> replicas(nverts), prev_replicas;
+      assignment.resize(nedges);
+      for (size_t pass = 0; pass < passes; ++pass) {
+        prev_replicas.swap(replicas);
+        replicas.assign(nverts, bin_counts_type());
+        std::vector<size_t> proc_num_edges(numprocs, 0);
+        for (size_t i = 0; i < nedges; ++i) {
+          const lvid_type src = src_idx[i], dst = dst_idx[i];
+          bin_counts_type src_bins = replicas[src];
+          bin_counts_type dst_bins = replicas[dst];
+          if (pass > 0) {
+            src_bins |= prev_replicas[src];
+            dst_bins |= prev_replicas[dst];
+          }
+          procid_t proc;
+          if (method == "fennel") {
+            proc = base_type::edge_decision.edge_to_proc_fennel(
+                edges[i].source, edges[i].target, src_bins, dst_bins,
+                proc_num_edges, alpha, FENNEL_GAMMA, capacity);
+          } else {
+            size_t src_degree = degree[src], dst_degree = degree[dst];
+            proc = base_type::edge_decision.edge_to_proc_hdrf(
+                edges[i].source, edges[i].target, src_bins, dst_bins,
+                src_degree, dst_degree, proc_num_edges, usehash);
+          }
+          replicas[src].set_bit(proc);
+          replicas[dst].set_bit(proc);
+          assignment[i] = proc;
+        }
+        report_pass(pass, proc_num_edges, replicas);
+      }
+    } // end of compute assignment
+
+    static lvid_type vertex_index(hopscotch_map<vertex_id_type, lvid_type>& vid2idx,
+                                  std::vector<size_t>& degree,
+                                  vertex_id_type vid) {
+      typename hopscotch_map<vertex_id_type, lvid_type>::iterator it =
+          vid2idx.find(vid);
+      if (it != vid2idx.end()) {
+        ++degree[it->second];
+        return it->second;
+      }
+      const lvid_type idx = degree.size();
+      vid2idx[vid] = idx;
+      degree.push_back(1);
+      return idx;
+    }
+
+    /**
+     * Logs the placement quality of a pass on machine 0. The counts of
+     * all machines are added, so a vertex loaded by several machines
+     * contributes to the vertex count once per machine and the
+     * replication factor is an estimate of the one reported by finalize.
+     */
+    void report_pass(size_t pass, const std::vector<size_t>& proc_num_edges,
+                     const std::vector<bin_counts_type>& replicas) {
+      const size_t numprocs = proc_num_edges.size();
+      // edges per machine, vertices per machine, number of vertices
+      std::vector<size_t> counts(2 * numprocs + 1, 0);
+      for (size_t p = 0; p < numprocs; ++p) counts[p] = proc_num_edges[p];
+      foreach(const bin_counts_type& bins, replicas) {
+        size_t p = 0;
+        if (!bins.first_bit(p)) continue;
+        do { ++counts[numprocs + p]; } while (bins.next_bit(p));
+      }
+      counts[2 * numprocs] = replicas.size();
+
+      std::vector<std::vector<size_t> > all_counts(numprocs);
+      all_counts[base_type::rpc.procid()].swap(counts);
+      base_type::rpc.all_gather(all_counts);
+      if (base_type::rpc.procid() != 0) return;
+
+      std::vector<size_t> total(2 * numprocs + 1, 0);
+      foreach(const std::vector<size_t>& c, all_counts) {
+        for (size_t i = 0; i < total.size(); ++i) total[i] += c[i];
+      }
+      size_t nedges = 0, nreplicas = 0, max_edges = 0, max_replicas = 0;
+      for (size_t p = 0; p < numprocs; ++p) {
+        nedges += total[p];
+        nreplicas += total[numprocs + p];
+        max_edges = std::max(max_edges, total[p]);
+        max_replicas = std::max(max_replicas, total[numprocs + p]);
+      }
+      const size_t nverts = total[2 * numprocs];
+      logstream(LOG_EMPH)
+        << method << " ingress pass " << pass + 1 << " of " << passes << ": "
+        << "\n\t replication factor: "
+        << (nverts == 0 ? 0 : double(nreplicas) / nverts)
+        << "\n\t edge imbalance: "
+        << (nedges == 0 ? 0 : double(max_edges) * numprocs / nedges)
+        << "\n\t vertex imbalance: "
+        << (nreplicas == 0 ? 0 : double(max_replicas) * numprocs / nreplicas)
+        << std::endl;
+    } // end of report pass
+  }; // end of distributed_restream_ingress
+
+  template<typename VertexData, typename EdgeData>
+  const double distributed_restream_ingress<VertexData, EdgeData>::FENNEL_GAMMA = 1.5;
+
+  template<typename VertexData, typename EdgeData>
+  const double distributed_restream_ingress<VertexData, EdgeData>::FENNEL_SLACK = 1.1;
+
+}; // end of namespace graphlab
+#include <graphlab/macros_undef.hpp>
+
+
+#endif
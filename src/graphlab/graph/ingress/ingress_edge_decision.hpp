@@ -26,8 +26,10 @@
 #include <graphlab/graph/graph_basic_types.hpp>
 #include <graphlab/graph/graph_hash.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
-#include <graphlab/util/dense_bitset.hpp>
+#include <graphlab/util/mirror_set.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
+#include <cmath>
+#include <limits>
 
 namespace graphlab {
   template<typename VertexData, typename EdgeData>
@@ -39,7 +41,7 @@ namespace graphlab {
     public:
       typedef graphlab::vertex_id_type vertex_id_type;
       typedef distributed_graph<VertexData, EdgeData> graph_type;
-      typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+      typedef mirror_set bin_counts_type; 
 
     public:
       /** \brief A decision object for computing the edge assingment. */
@@ -259,6 +261,65 @@ namespace graphlab {
         ++dst_true_degree;
         return best_proc;
      };
+
+     /** Fennel greedy assign (source, target) to a machine using: 
+      *  bitset<MAX_MACHINE> src_degree : the degree presence of source over machines
+      *  bitset<MAX_MACHINE> dst_degree : the degree presence of target over machines
+      *  vector<size_t>      proc_num_edges : the edge counts over machines
+      *  double              alpha, gamma : the load of a machine with e edges
+      *                                     costs alpha * e^gamma
+      *  size_t              capacity : machines with this many edges are
+      *                                 full unless all machines are
+      *
+      *  The score of a machine is the number of endpoints already on it
+      *  minus the marginal load cost alpha * gamma * e^(gamma-1), the
+      *  vertex-cut analogue of the objective of 
+      *  C. Tsourakakis, C. Gkantsidis, B. Radunovic and M. Vojnovic:
+      *  "FENNEL: Streaming Graph Partitioning for Massive Scale Graphs". 
+      *  WSDM, 2014.
+      * */
+     procid_t edge_to_proc_fennel (const vertex_id_type source, 
+          const vertex_id_type target,
+          bin_counts_type& src_degree,
+          bin_counts_type& dst_degree,
+          std::vector<size_t>& proc_num_edges,
+          double alpha, double gamma, size_t capacity) {
+        size_t numprocs = proc_num_edges.size();
+        const bool all_full = 
+          *std::min_element(proc_num_edges.begin(), proc_num_edges.end()) >= capacity;
+
+        // Compute the score of each proc.
+        procid_t best_proc = -1; 
+        double maxscore = -std::numeric_limits<double>::max();
+        std::vector<double> proc_score(numprocs); 
+        for (size_t i = 0; i < numprocs; ++i) {
+          if (!all_full && proc_num_edges[i] >= capacity) {
+            proc_score[i] = -std::numeric_limits<double>::max();
+            continue;
+          }
+          const double gain = src_degree.get(i) + dst_degree.get(i);
+          const double cost = 
+            alpha * gamma * std::pow(double(proc_num_edges[i]), gamma - 1);
+          proc_score[i] = gain - cost;
+          maxscore = std::max(maxscore, proc_score[i]);
+        }
+
+        std::vector<procid_t> top_procs; 
+        for (size_t i = 0; i < numprocs; ++i)
+          if (std::fabs(proc_score[i] - maxscore) < 1e-5)
+            top_procs.push_back(i);
+
+        // Hash the edge to one of the best procs.
+        typedef std::pair<vertex_id_type, vertex_id_type> edge_pair_type;
+        const edge_pair_type edge_pair(std::min(source, target), std::max(source, target));
+        best_proc = top_procs[graph_hash::hash_edge(edge_pair) % top_procs.size()];
+
+        ASSERT_LT(best_proc, numprocs);
+        src_degree.set_bit(best_proc);
+        dst_degree.set_bit(best_proc);
+        ++proc_num_edges[best_proc];
+        return best_proc;
+     };
   };// end of ingress_edge_decision
 }
 
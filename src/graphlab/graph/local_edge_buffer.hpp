@@ -57,6 +57,13 @@ namespace graphlab {
         source_arr.insert(source_arr.end(), src_arr.begin(), src_arr.end());
         target_arr.insert(target_arr.end(), dst_arr.begin(), dst_arr.end());
       }
+      // \brief Replace every vertex id v by new_lvid[v].
+      void relabel(const std::vector<lvid_type>& new_lvid) {
+        for (size_t i = 0; i < source_arr.size(); ++i) {
+          source_arr[i] = new_lvid[source_arr[i]];
+          target_arr[i] = new_lvid[target_arr[i]];
+        }
+      }
       // \brief Remove all contents in the storage. 
       void clear() {
         std::vector<EdgeData>().swap(data);
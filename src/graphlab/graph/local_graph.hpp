@@ -47,11 +47,12 @@
 
 #include <graphlab/graph/graph_basic_types.hpp>
 #include <graphlab/graph/local_edge_buffer.hpp>
+#include <graphlab/graph/vertex_ordering.hpp>
 #include <graphlab/util/random.hpp>
 #include <graphlab/util/generics/shuffle.hpp>
 #include <graphlab/util/generics/counting_sort.hpp>
-#include <graphlab/util/generics/vector_zip.hpp>
 #include <graphlab/util/generics/csr_storage.hpp>
+#include <graphlab/util/generics/compressed_csr_storage.hpp>
 #include <graphlab/parallel/atomic.hpp>
 
 #include <graphlab/logger/logger.hpp>
@@ -187,6 +188,9 @@ namespace graphlab {
       edges.clear();
       _csc_storage.clear();
       _csr_storage.clear();
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      std::vector<edge_id_type>().swap(csc_edge_ids);
+#endif
       std::vector<VertexData>().swap(vertices);
       std::vector<EdgeData>().swap(edges);
       edge_buffer.clear();
@@ -199,6 +203,10 @@ namespace graphlab {
      * fail if there are any duplicate edges.
      * Detail implementation depends on the type of graph_storage.
      * This is also automatically invoked by the engine at start.
+     *
+     * All phases run in parallel with OpenMP. Besides the edge buffer,
+     * at most the edge permutation, one permuted edge field and the CSC
+     * are allocated at any time. The time of each phase is logged.
      */
     void finalize() {   
       if(finalized) return;
@@ -206,77 +214,81 @@ namespace graphlab {
 #ifdef DEBUG_GRAPH
       logstream(LOG_DEBUG) << "Graph2 finalize starts." << std::endl;
 #endif
-      std::vector<edge_id_type> permute;
+      const size_t nedges = edge_buffer.size();
       std::vector<edge_id_type> src_counting_prefix_sum;
       std::vector<edge_id_type> dest_counting_prefix_sum;
-           
-#ifdef DEBUG_GRAPH
-      logstream(LOG_DEBUG) << "Graph2 finalize: Sort by source vertex" << std::endl;
-#endif
-      // Sort edges by source;
-      // Begin of counting sort.
-      counting_sort(edge_buffer.source_arr, permute, &src_counting_prefix_sum);
+      double sort_time, permute_time, rows_time, csc_time, csr_time;
+
+      // Sort edges by source. The source of the edges in CSR order is
+      // given by the prefix sum, so the source array is no longer needed.
+      {
+        std::vector<edge_id_type> permute;
+        parallel_counting_sort(edge_buffer.source_arr, permute,
+                               &src_counting_prefix_sum);
+        std::vector<lvid_type>().swap(edge_buffer.source_arr);
+        sort_time = mytimer.current_time();
+
+        // Permute one edge field at a time so that at most one extra
+        // array is allocated. The fields are permuted out of place so
+        // that all threads take part: inplace_shuffle follows the cycles
+        // of the permutation on a single thread.
+        outofplace_shuffle(edge_buffer.target_arr, permute);
+        outofplace_shuffle(edge_buffer.data, permute);
+        permute_time = mytimer.current_time() - sort_time;
+      }
 
-      // Inplace permute of edge_data, edge_src, edge_target array.
-#ifdef DEBUG_GRAPH
-      logstream(LOG_DEBUG) << "Graph2 finalize: Inplace permute by source id" << std::endl;
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      sort_rows(src_counting_prefix_sum);
 #endif
-      lvid_type swap_src; lvid_type swap_target; EdgeData  swap_data;
-      for (size_t i = 0; i < permute.size(); ++i) {
-        if (i != permute[i]) {
-          // Reserve the ith entry;
-          size_t j = i;
-          swap_data = edge_buffer.data[i];
-          swap_src = edge_buffer.source_arr[i];
-          swap_target = edge_buffer.target_arr[i];
-          // Begin swap cycle:
-          while (j != permute[j]) {
-            size_t next = permute[j];
-            if (next != i) {
-              edge_buffer.data[j] = edge_buffer.data[next];
-              edge_buffer.source_arr[j] = edge_buffer.source_arr[next];
-              edge_buffer.target_arr[j] = edge_buffer.target_arr[next];
-              permute[j] = j;
-              j = next;
-            } else {
-              // end of cycle
-              edge_buffer.data[j] = swap_data;
-              edge_buffer.source_arr[j] = swap_src;
-              edge_buffer.target_arr[j] = swap_target;
-              permute[j] = j;
-              break;
-            }
-          }
-        }
-      }
-#ifdef DEBUG_GRAPH
-      logstream(LOG_DEBUG) << "Graph2 finalize: Sort by dest id" << std::endl;
+      rows_time = mytimer.current_time() - sort_time - permute_time;
+
+      {
+        std::vector<std::pair<lvid_type, edge_id_type> > csc_value;
+        build_csc_entries(src_counting_prefix_sum, dest_counting_prefix_sum,
+                          csc_value);
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+        std::vector<lvid_type> csc_sources(nedges);
+        csc_edge_ids.resize(nedges);
+#ifdef _OPENMP
+#pragma omp parallel for
 #endif
-      counting_sort(edge_buffer.target_arr, permute, &dest_counting_prefix_sum); 
-      // Shuffle source array
-#ifdef DEBUG_GRAPH
-      logstream(LOG_DEBUG) << "Graph2 finalize: Outofplace permute by dest id" << std::endl;
+        for (ssize_t i = 0; i < ssize_t(nedges); ++i) {
+          csc_sources[i] = csc_value[i].first;
+          csc_edge_ids[i] = csc_value[i].second;
+        }
+        std::vector<std::pair<lvid_type, edge_id_type> >().swap(csc_value);
+        _csc_storage.build(vertices.size(), dest_counting_prefix_sum,
+                           csc_sources);
+#else
+        _csc_storage.wrap(dest_counting_prefix_sum, csc_value); 
 #endif
+      }
+      csc_time = mytimer.current_time() - sort_time - permute_time - rows_time;
 
-      outofplace_shuffle(edge_buffer.source_arr, permute);
-      // Use inplace shuffle to reduce peak memory footprint:
-      // inplace_shuffle(edge_buffer.source_arr, permute);
-      // counting_sort(edge_buffer.target_arr, permute);
-
-      // warp into csr csc storage.
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      _csr_storage.build(vertices.size(), src_counting_prefix_sum,
+                         edge_buffer.target_arr);
+#else
       _csr_storage.wrap(src_counting_prefix_sum, edge_buffer.target_arr);
-      std::vector<std::pair<lvid_type, edge_id_type> > csc_value = vector_zip(edge_buffer.source_arr, permute);
-      //ASSERT_EQ(csc_value.size(), edge_buffer.size());
-      _csc_storage.wrap(dest_counting_prefix_sum, csc_value); 
+#endif
       edges.swap(edge_buffer.data);
+      edge_buffer.clear();
+      csr_time = mytimer.current_time() - sort_time - permute_time - rows_time
+          - csc_time;
+
       ASSERT_EQ(_csr_storage.num_values(), _csc_storage.num_values());
-      ASSERT_EQ(_csr_storage.num_values(), edges.size());
+      ASSERT_EQ(_csr_storage.num_values(), nedges);
+      ASSERT_EQ(edges.size(), nedges);
 #ifdef DEBGU_GRAPH
       logstream(LOG_DEBUG) << "End of finalize." << std::endl;
 #endif
 
       logstream(LOG_INFO) << "Graph finalized in " << mytimer.current_time() 
-                          << " secs" << std::endl;
+                          << " secs (sort by source " << sort_time
+                          << ", permute " << permute_time
+                          << ", sort rows " << rows_time
+                          << ", csc " << csc_time
+                          << ", csr " << csr_time << ")" << std::endl;
       finalized = true;
     } // End of finalize
 
@@ -392,6 +404,33 @@ namespace graphlab {
       edge_buffer.add_block_edges(src_arr, dst_arr, edata_arr);
     } // End of add block edges
 
+    /**
+     * \brief Renumbers the vertices to improve the locality of the
+     * vertex data accesses, before the graph is first finalized.
+     *
+     * \param [in] method The ordering passed to
+     *                    vertex_ordering::compute_order.
+     * \param [out] new_lvid The new id of each previous vertex id.
+     * \return false if the vertices were left in their order.
+     */
+    bool reorder_vertices(const std::string& method,
+                          std::vector<lvid_type>& new_lvid) {
+      ASSERT_FALSE(finalized);
+      if (!vertex_ordering::compute_order(method, vertices.size(),
+                                          edge_buffer.source_arr,
+                                          edge_buffer.target_arr,
+                                          new_lvid)) {
+        return false;
+      }
+      std::vector<VertexData> permuted(vertices.size());
+      for (size_t i = 0; i < vertices.size(); ++i) {
+        permuted[new_lvid[i]] = vertices[i];
+      }
+      vertices.swap(permuted);
+      edge_buffer.relabel(new_lvid);
+      return true;
+    } // End of reorder vertices
+
 
     /** \brief Returns a vertex of given ID. */
     vertex_type vertex(lvid_type vid) {
@@ -424,8 +463,11 @@ namespace graphlab {
       arc >> vertices
           >> edges 
           >> _csr_storage
-          >> _csc_storage
-          >> finalized;
+          >> _csc_storage;
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      arc >> csc_edge_ids;
+#endif
+      arc >> finalized;
     } // end of load
 
     /** \brief Save the local_graph to an archive */
@@ -434,8 +476,11 @@ namespace graphlab {
       arc << vertices
           << edges
           << _csr_storage  
-          << _csc_storage
-          << finalized;
+          << _csc_storage;
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      arc << csc_edge_ids;
+#endif
+      arc << finalized;
     } // end of save
     
     /** swap two graphs */
@@ -445,6 +490,9 @@ namespace graphlab {
       std::swap(edges, other.edges);
       std::swap(_csr_storage, other._csr_storage);
       std::swap(_csc_storage, other._csc_storage);
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      std::swap(csc_edge_ids, other.csc_edge_ids);
+#endif
       std::swap(finalized, other.finalized);
     } // end of swap
 
@@ -502,7 +550,11 @@ namespace graphlab {
      * \brief Returns the number of in edges of the vertex with the given id. */
     size_t num_in_edges(const lvid_type v) const {
       ASSERT_TRUE(finalized);
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      return _csc_storage.num_values(v);
+#else
       return (_csc_storage.end(v) - _csc_storage.begin(v));
+#endif
     }
 
     /** 
@@ -510,23 +562,37 @@ namespace graphlab {
      * \brief Returns the number of in edges of the vertex with the given id. */
     size_t num_out_edges(const lvid_type v) const {
       ASSERT_TRUE(finalized);
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      return _csr_storage.num_values(v);
+#else
       return (_csr_storage.end(v) - _csr_storage.begin(v));
+#endif
     }
 
     /** 
      * \internal
      * \brief Returns a list of in edges of the vertex with the given id. */
     edge_list_type in_edges(lvid_type v) {
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      return boost::make_iterator_range(
+          edge_iterator(*this, _csc_storage.begin(v), v, edge_iterator::CSC),
+          edge_iterator(*this, _csc_storage.end(v), v, edge_iterator::CSC));
+#else
       edge_iterator begin = edge_iterator(*this, _csc_storage.begin(v), v);
       edge_iterator end = edge_iterator(*this, _csc_storage.end(v), v);
       return boost::make_iterator_range(begin, end);
+#endif
     }
 
     /** 
      * \internal
      * \brief Returns a list of out edges of the vertex with the given id. */
     edge_list_type out_edges(lvid_type v) {
-
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      return boost::make_iterator_range(
+          edge_iterator(*this, _csr_storage.begin(v), v, edge_iterator::CSR),
+          edge_iterator(*this, _csr_storage.end(v), v, edge_iterator::CSR));
+#else
       csr_type::iterator base_begin = _csr_storage.begin(v);
       csr_type::iterator base_end = _csr_storage.end(v);
 
@@ -545,6 +611,7 @@ namespace graphlab {
               csr_edge_iterator(csr_iterator_tuple(base_end, counter_end)), v);
 
       return boost::make_iterator_range(begin, end);
+#endif
     }
 
     /** 
@@ -573,6 +640,9 @@ namespace graphlab {
       size_t elist_size = _csr_storage.estimate_sizeof() 
           + _csc_storage.estimate_sizeof()
           + sizeof(edges) + sizeof(EdgeData)*edges.capacity();
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+      elist_size += sizeof(edge_id_type) * csc_edge_ids.capacity();
+#endif
       size_t ebuffer_size = edge_buffer.estimate_sizeof();
       // std::cerr << "local_graph: tmplist size: " << (double)elist_size/(1024*1024)
       //           << "  gstoreage size: " << (double)store_size/(1024*1024)
@@ -599,6 +669,137 @@ namespace graphlab {
     }
    
   private:    
+    /**
+     * \internal
+     * Sorts the targets of each source of the edge buffer sorted by
+     * source, along with their edge data.
+     */
+    void sort_rows(const std::vector<edge_id_type>& src_prefix) {
+      const size_t nedges = edge_buffer.target_arr.size();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      {
+        std::vector<std::pair<lvid_type, edge_id_type> > row;
+        std::vector<EdgeData> row_data;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+        for (ssize_t v = 0; v < ssize_t(src_prefix.size()); ++v) {
+          const size_t begin = src_prefix[v];
+          const size_t end = size_t(v + 1) < src_prefix.size() ?
+              src_prefix[v + 1] : nedges;
+          if (end - begin < 2) continue;
+          row.clear(); row_data.clear();
+          for (size_t i = begin; i < end; ++i) {
+            row.push_back(std::make_pair(edge_buffer.target_arr[i],
+                                         edge_id_type(i)));
+          }
+          std::sort(row.begin(), row.end());
+          for (size_t i = 0; i < row.size(); ++i) {
+            row_data.push_back(edge_buffer.data[row[i].second]);
+          }
+          for (size_t i = begin; i < end; ++i) {
+            edge_buffer.target_arr[i] = row[i - begin].first;
+            edge_buffer.data[i] = row_data[i - begin];
+          }
+        }
+      }
+    } // end of sort_rows
+
+    /**
+     * \internal
+     * Writes the CSC entry of the edge at position i of the edge buffer
+     * sorted by source. Remembers the last row to find the source of
+     * the next edge without a search.
+     */
+    struct csc_output {
+      const std::vector<edge_id_type>* src_prefix;
+      std::vector<std::pair<lvid_type, edge_id_type> >* csc_value;
+      lvid_type source;
+      size_t row_begin, row_end;
+      csc_output(const std::vector<edge_id_type>* src_prefix,
+                 std::vector<std::pair<lvid_type, edge_id_type> >* csc_value) :
+        src_prefix(src_prefix), csc_value(csc_value),
+        source(0), row_begin(0), row_end(0) { }
+      inline void operator()(size_t i, size_t pos) {
+        if (i < row_begin || i >= row_end) {
+          source = std::upper_bound(src_prefix->begin(), src_prefix->end(), i)
+              - src_prefix->begin() - 1;
+          row_begin = (*src_prefix)[source];
+          row_end = size_t(source + 1) < src_prefix->size() ?
+              (*src_prefix)[source + 1] : csc_value->size();
+        }
+        (*csc_value)[pos] = std::make_pair(source, edge_id_type(i));
+      }
+    };
+
+    /**
+     * \internal
+     * Builds the CSC from the edge buffer sorted by source: the edge at
+     * position i of the row of v goes from v to edge_buffer.target_arr[i]
+     * and has id i. As the counting sort is stable, the in edges of
+     * each target are sorted by source.
+     */
+    void build_csc_entries(const std::vector<edge_id_type>& src_prefix,
+                           std::vector<edge_id_type>& dest_prefix,
+                           std::vector<std::pair<lvid_type, edge_id_type> >& csc_value) {
+      csc_value.resize(edge_buffer.target_arr.size());
+      parallel_counting_scatter(edge_buffer.target_arr, dest_prefix,
+                                csc_output(&src_prefix, &csc_value));
+    } // end of build_csc_entries
+
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+    /**
+     * \internal
+     * Gap encoded CSR/CSC storage types. The id of an out edge is its
+     * position in the CSR, the id of an in edge is stored in csc_edge_ids
+     * at its position in the CSC.
+     */
+    typedef compressed_csr_storage<lvid_type, edge_id_type> csr_type;
+    typedef compressed_csr_storage<lvid_type, edge_id_type> csc_type;
+
+    class edge_iterator :
+        public boost::iterator_facade <
+        edge_iterator,
+        edge_type,
+        boost::random_access_traversal_tag,
+        edge_type> {
+         public:
+           enum list_type {CSR, CSC};
+           edge_iterator(local_graph& lgraph_ref,
+                         typename csr_type::iterator iter, lvid_type vid,
+                         list_type type)
+               : lgraph_ref(lgraph_ref), _type(type), iter(iter), vid(vid) {}
+
+         private:
+           friend class boost::iterator_core_access;
+
+           void increment() { ++iter; }
+           void decrement() { --iter; }
+           void advance(int n) { iter += n; }
+           bool equal(const edge_iterator& other) const {
+             ASSERT_EQ(_type, other._type);
+             return iter == other.iter;
+           }
+           ptrdiff_t distance_to(const edge_iterator& other) const {
+             return other.iter - iter;
+           }
+           edge_type dereference() const {
+             if (_type == CSC) {
+               return edge_type(lgraph_ref, *iter, vid,
+                                lgraph_ref.csc_edge_ids[iter.index()]);
+             } else {
+               return edge_type(lgraph_ref, vid, *iter, iter.index());
+             }
+           }
+           local_graph& lgraph_ref;
+           list_type _type;
+           typename csr_type::iterator iter;
+           lvid_type vid;
+        }; // end of edge_iterator
+
+#else
     /** 
      * \internal
      * CSR/CSC storage types
@@ -611,7 +812,7 @@ namespace graphlab {
                          > csr_iterator_tuple;
 
     typedef boost::zip_iterator<csr_iterator_tuple> csr_edge_iterator;
-    typedef csc_type::iterator csc_edge_iterator;
+    typedef typename csc_type::iterator csc_edge_iterator;
 
     class edge_iterator : 
         public boost::iterator_facade <
@@ -696,6 +897,7 @@ namespace graphlab {
            csr_edge_iterator csr_iter;
            const lvid_type vid;
         }; // end of edge_iterator
+#endif
 
 
     /**************************************************************************/
@@ -709,6 +911,9 @@ namespace graphlab {
     /** Stores the edge data and edge relationships. */
     csr_type _csr_storage;
     csc_type _csc_storage;
+#ifdef USE_COMPRESSED_LOCAL_GRAPH
+    std::vector<edge_id_type> csc_edge_ids;
+#endif
     std::vector<EdgeData> edges;
 
     /** The edge data is a vector of edges where each edge stores its
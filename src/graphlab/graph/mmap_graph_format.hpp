@@ -0,0 +1,297 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/**
+ * \file mmap_graph_format.hpp
+ *
+ * The "binmmap" partition file of distributed_graph: a header followed
+ * by flat arrays ("sections") aligned to 64 bytes, which are read from a
+ * memory mapping of the file without parsing or decompression.
+ */
+
+#ifndef GRAPHLAB_MMAP_GRAPH_FORMAT_HPP
+#define GRAPHLAB_MMAP_GRAPH_FORMAT_HPP
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <boost/type_traits.hpp>
+
+#include <graphlab/logger/logger.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+
+namespace graphlab {
+
+  namespace mmap_graph_format {
+
+    /// "GLMMAPG1" in little endian
+    static const uint64_t MAGIC = 0x314750414d4d4c47ULL;
+    static const uint64_t VERSION = 1;
+    /// Alignment of every section in the file
+    static const size_t ALIGNMENT = 64;
+
+    /**
+     * The sections of a partition file. The out edges of local vertex v
+     * are targets[row_ptrs[v]] up to targets[row_ptrs[v+1]], with their
+     * data at the same positions of edge_data. The mirrors of v are
+     * mirrors[mirror_ptrs[v]] up to mirrors[mirror_ptrs[v+1]]. The other
+     * sections have one entry per local vertex.
+     */
+    enum section_id {
+      ROW_PTRS, TARGETS, EDGE_DATA, VERTEX_DATA,
+      GVIDS, OWNERS, NUM_IN_EDGES, NUM_OUT_EDGES, MIRROR_PTRS, MIRRORS,
+      NUM_SECTIONS
+    };
+
+    /// How vertex or edge data is stored in its section
+    enum data_layout {
+      /// Types without members: the section is empty
+      DATA_NONE = 0,
+      /// POD types: an array of the values
+      DATA_RAW = 1,
+      /// Other types: the values written with an oarchive
+      DATA_SERIALIZED = 2
+    };
+
+    struct section {
+      uint64_t offset;
+      uint64_t bytes;
+    };
+
+    struct header {
+      uint64_t magic;
+      uint64_t version;
+      uint64_t procid;
+      uint64_t numprocs;
+      uint64_t sizeof_vertex_id;
+      uint64_t vertex_data_layout, sizeof_vertex_data;
+      uint64_t edge_data_layout, sizeof_edge_data;
+      /// The global counts of the distributed graph
+      uint64_t nverts, nedges, local_own_nverts, nreplicas;
+      /// The counts of the local graph
+      uint64_t num_local_vertices, num_local_edges;
+      section sections[NUM_SECTIONS];
+    };
+
+    /// The layout in which values of type T are stored
+    template <typename T>
+    inline data_layout layout_of() {
+      if (boost::is_empty<T>::value) return DATA_NONE;
+      if (gl_is_pod<T>::value) return DATA_RAW;
+      return DATA_SERIALIZED;
+    }
+
+
+    /**
+     * Writes a partition file. The header is written last, so a file
+     * which was not closed successfully is rejected by the reader.
+     */
+    class writer {
+     public:
+      /// Creates the file. Returns false on failure.
+      bool open(const std::string& fname) {
+        memset(&hdr, 0, sizeof(hdr));
+        out.open(fname.c_str(), std::ios_base::out | std::ios_base::binary
+                                | std::ios_base::trunc);
+        if (!out.good()) return false;
+        // placeholder for the header
+        pad_to(sizeof(header));
+        return out.good();
+      }
+
+      /// The header to fill before close(). The sections are set by write.
+      header& get_header() { return hdr; }
+
+      /// Writes the bytes of a section
+      void write(section_id id, const void* data, size_t bytes) {
+        pad_to(((size_t(out.tellp()) + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT);
+        hdr.sections[id].offset = out.tellp();
+        hdr.sections[id].bytes = bytes;
+        if (bytes > 0) out.write(reinterpret_cast<const char*>(data), bytes);
+      }
+
+      /// Writes a vector of POD values as a section
+      template <typename T>
+      void write(section_id id, const std::vector<T>& vec) {
+        write(id, vec.empty() ? NULL : &vec[0], sizeof(T) * vec.size());
+      }
+
+      /// Writes vertex or edge data in the layout of T
+      template <typename T>
+      void write_data(section_id id, const std::vector<T>& vec) {
+        switch (layout_of<T>()) {
+         case DATA_NONE: write(id, NULL, 0); break;
+         case DATA_RAW: write(id, vec); break;
+         case DATA_SERIALIZED: {
+           oarchive oarc;
+           for (size_t i = 0; i < vec.size(); ++i) oarc << vec[i];
+           write(id, oarc.buf, oarc.off);
+           free(oarc.buf);
+           break;
+         }
+        }
+      }
+
+      /// Writes the header and closes the file. Returns false on failure.
+      bool close() {
+        hdr.magic = MAGIC;
+        hdr.version = VERSION;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        const bool success = out.good();
+        out.close();
+        return success;
+      }
+
+     private:
+      std::ofstream out;
+      header hdr;
+
+      void pad_to(size_t pos) {
+        while (size_t(out.tellp()) < pos) out.put(0);
+      }
+    }; // end of writer
+
+
+    /**
+     * A read only memory mapping of a partition file.
+     */
+    class reader {
+     public:
+      reader() : base(NULL), length(0) { }
+      ~reader() { close(); }
+
+      /**
+       * Maps the file and checks its header. Returns false, with a
+       * message in error, if the file cannot be used.
+       */
+      bool open(const std::string& fname, std::string& error) {
+        close();
+        int fd = ::open(fname.c_str(), O_RDONLY);
+        if (fd < 0) {
+          error = "cannot open the file";
+          return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(header)) {
+          ::close(fd);
+          error = "the file is too short";
+          return false;
+        }
+        length = st.st_size;
+        void* ptr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (ptr == MAP_FAILED) {
+          length = 0;
+          error = "mmap failed";
+          return false;
+        }
+        base = reinterpret_cast<const char*>(ptr);
+        // the sections are mostly read sequentially
+        madvise(ptr, length, MADV_WILLNEED);
+        const header& hdr = get_header();
+        if (hdr.magic != MAGIC || hdr.version != VERSION) {
+          error = "not a binmmap graph file of this version";
+          close();
+          return false;
+        }
+        for (size_t i = 0; i < NUM_SECTIONS; ++i) {
+          if (hdr.sections[i].offset + hdr.sections[i].bytes > length) {
+            error = "the file is truncated";
+            close();
+            return false;
+          }
+        }
+        return true;
+      }
+
+      void close() {
+        if (base != NULL) munmap(const_cast<char*>(base), length);
+        base = NULL;
+        length = 0;
+      }
+
+      const header& get_header() const {
+        return *reinterpret_cast<const header*>(base);
+      }
+
+      /// Number of bytes of a section
+      size_t bytes(section_id id) const {
+        return get_header().sections[id].bytes;
+      }
+
+      /**
+       * Returns the values of a section, which must hold count values of
+       * type T, or NULL if it does not.
+       */
+      template <typename T>
+      const T* data(section_id id, size_t count) const {
+        if (bytes(id) != sizeof(T) * count) return NULL;
+        return reinterpret_cast<const T*>(base + get_header().sections[id].offset);
+      }
+
+      /**
+       * Reads count vertex or edge data values written by
+       * writer::write_data. Returns false if the section does not match.
+       */
+      template <typename T>
+      bool read_data(section_id id, size_t count, std::vector<T>& vec) const {
+        const section& sec = get_header().sections[id];
+        switch (layout_of<T>()) {
+         case DATA_NONE:
+           vec.resize(count);
+           return true;
+         case DATA_RAW: {
+           const T* values = data<T>(id, count);
+           if (values == NULL) return false;
+           vec.assign(values, values + count);
+           return true;
+         }
+         case DATA_SERIALIZED: {
+           iarchive iarc(base + sec.offset, sec.bytes);
+           vec.resize(count);
+           for (size_t i = 0; i < count; ++i) iarc >> vec[i];
+           return true;
+         }
+        }
+        return false;
+      }
+
+     private:
+      const char* base;
+      size_t length;
+    }; // end of reader
+
+  } // namespace mmap_graph_format
+} // namespace graphlab
+
+#endif
@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/**
+ * \file vertex_ordering.hpp
+ *
+ * Locality improving renumberings of the local vertex ids, computed from
+ * the edge list of a local graph before it is finalized.
+ */
+
+#ifndef GRAPHLAB_VERTEX_ORDERING_HPP
+#define GRAPHLAB_VERTEX_ORDERING_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/logger/logger.hpp>
+#include <graphlab/logger/assertions.hpp>
+
+namespace graphlab {
+
+  namespace vertex_ordering {
+
+    namespace vertex_ordering_impl {
+      /// Orders vertices by decreasing degree, then by increasing id
+      struct greater_degree {
+        const std::vector<size_t>& degree;
+        greater_degree(const std::vector<size_t>& degree) : degree(degree) { }
+        bool operator()(lvid_type a, lvid_type b) const {
+          return degree[a] > degree[b] || (degree[a] == degree[b] && a < b);
+        }
+      };
+
+      /// Orders vertices by increasing degree, then by increasing id
+      struct less_degree {
+        const std::vector<size_t>& degree;
+        less_degree(const std::vector<size_t>& degree) : degree(degree) { }
+        bool operator()(lvid_type a, lvid_type b) const {
+          return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+        }
+      };
+
+      /// Returns the number of edges incident to each vertex
+      inline void compute_degree(size_t nverts,
+                                 const std::vector<lvid_type>& src,
+                                 const std::vector<lvid_type>& dst,
+                                 std::vector<size_t>& degree) {
+        degree.assign(nverts, 0);
+        for (size_t i = 0; i < src.size(); ++i) {
+          ++degree[src[i]];
+          ++degree[dst[i]];
+        }
+      }
+    } // namespace vertex_ordering_impl
+
+
+    /**
+     * \brief Renumbers the vertices by decreasing total degree.
+     *
+     * The high degree vertices which are touched by most gathers and
+     * scatters end up next to each other at the front of the vertex data
+     * array.
+     *
+     * \param [in] nverts The number of vertices.
+     * \param [in] src The source of each edge.
+     * \param [in] dst The target of each edge.
+     * \param [out] new_lvid The new id of each vertex.
+     */
+    inline void degree_order(size_t nverts,
+                             const std::vector<lvid_type>& src,
+                             const std::vector<lvid_type>& dst,
+                             std::vector<lvid_type>& new_lvid) {
+      std::vector<size_t> degree;
+      vertex_ordering_impl::compute_degree(nverts, src, dst, degree);
+      std::vector<lvid_type> order(nverts);
+      for (size_t i = 0; i < nverts; ++i) order[i] = i;
+      std::sort(order.begin(), order.end(),
+                vertex_ordering_impl::greater_degree(degree));
+      new_lvid.resize(nverts);
+      for (size_t i = 0; i < nverts; ++i) new_lvid[order[i]] = i;
+    } // end of degree_order
+
+
+    /**
+     * \brief Renumbers the vertices in reverse Cuthill-McKee order.
+     *
+     * Each connected component is traversed breadth first starting from
+     * its lowest degree vertex, visiting the neighbors of every vertex by
+     * increasing degree. Reversing the visit order makes the ids of
+     * neighboring vertices close to each other. Edge directions are
+     * ignored. Requires 2 * |E| temporary vertex ids.
+     *
+     * \param [in] nverts The number of vertices.
+     * \param [in] src The source of each edge.
+     * \param [in] dst The target of each edge.
+     * \param [out] new_lvid The new id of each vertex.
+     */
+    inline void rcm_order(size_t nverts,
+                          const std::vector<lvid_type>& src,
+                          const std::vector<lvid_type>& dst,
+                          std::vector<lvid_type>& new_lvid) {
+      std::vector<size_t> degree;
+      vertex_ordering_impl::compute_degree(nverts, src, dst, degree);
+      // Build the undirected adjacency lists
+      std::vector<size_t> offset(nverts + 1, 0);
+      for (size_t i = 0; i < nverts; ++i) offset[i + 1] = offset[i] + degree[i];
+      std::vector<lvid_type> adj(offset[nverts]);
+      {
+        std::vector<size_t> pos(offset.begin(), offset.end() - 1);
+        for (size_t i = 0; i < src.size(); ++i) {
+          adj[pos[src[i]]++] = dst[i];
+          adj[pos[dst[i]]++] = src[i];
+        }
+      }
+      // Start a new traversal from the lowest degree unvisited vertex
+      std::vector<lvid_type> roots(nverts);
+      for (size_t i = 0; i < nverts; ++i) roots[i] = i;
+      std::sort(roots.begin(), roots.end(),
+                vertex_ordering_impl::less_degree(degree));
+
+      std::vector<bool> visited(nverts, false);
+      std::vector<lvid_type> order;
+      order.reserve(nverts);
+      for (size_t r = 0; r < nverts; ++r) {
+        if (visited[roots[r]]) continue;
+        size_t head = order.size();
+        order.push_back(roots[r]);
+        visited[roots[r]] = true;
+        while (head < order.size()) {
+          const lvid_type v = order[head++];
+          const size_t first_child = order.size();
+          for (size_t j = offset[v]; j < offset[v + 1]; ++j) {
+            if (!visited[adj[j]]) {
+              visited[adj[j]] = true;
+              order.push_back(adj[j]);
+            }
+          }
+          std::sort(order.begin() + first_child, order.end(),
+                    vertex_ordering_impl::less_degree(degree));
+        }
+      }
+      ASSERT_EQ(order.size(), nverts);
+      new_lvid.resize(nverts);
+      for (size_t i = 0; i < nverts; ++i) new_lvid[order[i]] = nverts - 1 - i;
+    } // end of rcm_order
+
+
+    /**
+     * \brief Computes the renumbering named by method.
+     *
+     * \param [in] method One of "none", "degree" or "rcm".
+     * \param [in] nverts The number of vertices.
+     * \param [in] src The source of each edge.
+     * \param [in] dst The target of each edge.
+     * \param [out] new_lvid The new id of each vertex.
+     *
+     * \return false if method is "none" and the vertices are to be left
+     * in their current order.
+     */
+    inline bool compute_order(const std::string& method, size_t nverts,
+                              const std::vector<lvid_type>& src,
+                              const std::vector<lvid_type>& dst,
+                              std::vector<lvid_type>& new_lvid) {
+      ASSERT_EQ(src.size(), dst.size());
+      if (method == "none" || method.empty()) {
+        return false;
+      } else if (method == "degree") {
+        degree_order(nverts, src, dst, new_lvid);
+      } else if (method == "rcm") {
+        rcm_order(nverts, src, dst, new_lvid);
+      } else {
+        logstream(LOG_FATAL) << "Unknown vertex order: " << method << std::endl;
+        return false;
+      }
+      return true;
+    } // end of compute_order
+
+  } // namespace vertex_ordering
+} // namespace graphlab
+
+#endif
@@ -28,6 +28,7 @@
 #include <graphlab/parallel/fiber_control.hpp>
 #include <graphlab/rpc/dc.hpp>
 #include <graphlab/rpc/dc_dist_object.hpp>
+#include <graphlab/rpc/exchange_compression.hpp>
 #include <graphlab/util/mpi_tools.hpp>
 
 
@@ -96,6 +97,8 @@ namespace graphlab {
     const size_t num_threads;
     const size_t max_buffer_size;
 
+    dc_impl::exchange_compressor compressor;
+
 
     // typedef boost::function<void (const T& tref)> handler_type;
     // handler_type recv_handler;
@@ -162,7 +165,7 @@ namespace graphlab {
         oarchive* prevarc = swap_buffer(index);
         send_locks[index].unlock();
         // complete the send
-        rpc.split_call_end(proc, prevarc);
+        send_buffer(proc, prevarc);
       } else {
         send_locks[index].unlock();
       }
@@ -180,7 +183,7 @@ namespace graphlab {
           oarchive* prevarc = swap_buffer(index);
           send_locks[index].unlock();
           // complete the send
-          rpc.split_call_end(proc, prevarc);
+          send_buffer(proc, prevarc);
           rpc.dc().flush_soon(proc);
         }
       }
@@ -198,7 +201,7 @@ namespace graphlab {
         if (send_buffers[i].numinserts > 0) {
           oarchive* prevarc = swap_buffer(i);
           // complete the send
-          rpc.split_call_end(proc, prevarc);
+          send_buffer(proc, prevarc);
         }
         send_locks[i].unlock();
       }
@@ -274,7 +277,31 @@ namespace graphlab {
     void clear() { }
 
     void barrier() { rpc.barrier(); }
+
+    /**
+     * Sets when the blocks sent are compressed. Defaults to
+     * EXCHANGE_COMPRESSION_ADAPTIVE.
+     */
+    void set_compression(exchange_compression_mode mode) {
+      compressor.set_mode(mode);
+    }
+
+    /**
+     * Compresses the blocks with codec, which must outlive the exchange
+     * and be used by all machines.
+     */
+    void set_compression_codec(const dc_impl::exchange_codec* codec) {
+      compressor.set_codec(codec);
+    }
   private:
+    void rpc_recv_compressed(size_t len, wild_pointer w) {
+      char* block; size_t blocklen;
+      compressor.decompress(len, w, block, blocklen);
+      wild_pointer blockptr; blockptr.ptr = block;
+      rpc_recv(blocklen, blockptr);
+      free(block);
+    } // end of rpc recv compressed
+
     void rpc_recv(size_t len, wild_pointer w) {
       buffer_type tmp;
       iarchive iarc(reinterpret_cast<const char*>(w.ptr), len);
@@ -317,6 +344,12 @@ namespace graphlab {
       return swaparc;
     }
 
+    // send a block returned by swap_buffer, compressed if worthwhile
+    void send_buffer(procid_t proc, oarchive* oarc) {
+      rpc.split_call_end(proc, compressor.compress(
+          rpc, oarc, &buffered_exchange::rpc_recv_compressed));
+    }
+
 
   }; // end of buffered exchange
 
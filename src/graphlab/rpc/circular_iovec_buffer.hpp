@@ -144,17 +144,30 @@ struct circular_iovec_buffer {
     data.msg_iovlen = std::min<size_t>(IOV_MAX, data.msg_iovlen);
   }
 
+  /**
+   * Erases a single iovec from the head without freeing the pointer,
+   * which is appended to retired instead.
+   */
+  inline void erase_from_head(std::vector<void*>& retired) {
+    retired.push_back(v[head].iov_base);
+    head = (head + 1) & (v.size() - 1);
+    --numel;
+  }
+
   /**
    * Advances the head as if some amount of data was sent.
+   * If retired is not NULL, the pointers which were completely sent are
+   * appended to it instead of being freed.
    */
-  void sent(size_t len) {
+  void sent(size_t len, std::vector<void*>* retired = NULL) {
     while(len > 0) {
       size_t curv_sent_len = std::min(len, parallel_v[head].iov_len);
       parallel_v[head].iov_len -= curv_sent_len;
       parallel_v[head].iov_base = (char*)(parallel_v[head].iov_base) + curv_sent_len;
       len -= curv_sent_len;
       if (parallel_v[head].iov_len == 0) {
-        erase_from_head_and_free();
+        if (retired == NULL) erase_from_head_and_free();
+        else erase_from_head(*retired);
       }
     }
   }
@@ -42,11 +42,15 @@
 
 #include <graphlab/rpc/dc.hpp>
 #include <graphlab/rpc/dc_tcp_comm.hpp>
+#include <graphlab/rpc/dc_shm_comm.hpp>
 //#include <graphlab/rpc/dc_sctp_comm.hpp>
 #include <graphlab/rpc/dc_buffered_stream_send2.hpp>
 #include <graphlab/rpc/dc_stream_receive.hpp>
+#include <graphlab/rpc/receive_buffer_pool.hpp>
 #include <graphlab/rpc/request_reply_handler.hpp>
 #include <graphlab/rpc/dc_services.hpp>
+#include <graphlab/rpc/dc_rpc_stats.hpp>
+#include <graphlab/ui/metrics_server.hpp>
 
 #include <graphlab/rpc/dc_init_from_env.hpp>
 #include <graphlab/rpc/dc_init_from_mpi.hpp>
@@ -88,6 +92,39 @@ distributed_control* distributed_control::get_instance() {
   return last_dc;
 }
 
+/// Returns the rpc statistics of this process as json
+static std::string local_rpc_stats_json() {
+  distributed_control* dc = distributed_control::get_instance();
+  if (dc == NULL || dc->get_rpc_stats() == NULL) return "{}";
+  return dc->get_rpc_stats()->to_json(*dc);
+}
+
+/**
+ * Metric server page listing the rpc statistics of every process, or of
+ * the one given by the "machine" variable.
+ */
+static std::pair<std::string, std::string>
+rpc_stats_json(std::map<std::string, std::string>& vars) {
+  distributed_control* dc = distributed_control::get_instance();
+  std::stringstream strm;
+  strm << "[\n";
+  if (dc != NULL) {
+    procid_t pstart = 0;
+    procid_t pend = dc->numprocs();
+    if (vars.count("machine")) {
+      pstart = std::min<size_t>(atoi(vars["machine"].c_str()), pend);
+      pend = std::min<size_t>(pstart + 1, pend);
+    }
+    for (procid_t p = pstart; p < pend; ++p) {
+      if (p > pstart) strm << ",\n";
+      if (p == dc->procid()) strm << local_rpc_stats_json();
+      else strm << dc->remote_request(p, local_rpc_stats_json);
+    }
+  }
+  strm << "\n]\n";
+  return std::make_pair(std::string("text/plain"), strm.str());
+}
+
 
 
 
@@ -178,6 +215,13 @@ distributed_control::~distributed_control() {
 
   comm->close();
 
+  // the statistics read the byte counts of the senders
+  if (rpc_statistics != NULL) {
+    std::stringstream strm;
+    rpc_statistics->print(strm, *this);
+    logstream(LOG_INFO) << strm.str();
+  }
+
   for (size_t i = 0;i < senders.size(); ++i) {
     delete senders[i];
   }
@@ -200,6 +244,10 @@ distributed_control::~distributed_control() {
   logstream(LOG_INFO) << "Network Sent: " << network_bytes_sent() << std::endl;
   logstream(LOG_INFO) << "Bytes Received: " << bytesreceived << std::endl;
   logstream(LOG_INFO) << "Calls Received: " << calls_received() << std::endl;
+  if (rpc_statistics != NULL) {
+    dc_impl::ireply_container::track_issue_time = false;
+    delete rpc_statistics;
+  }
 
   delete comm;
 
@@ -217,7 +265,13 @@ void distributed_control::exec_function_call(procid_t source,
   arc >> f;
   // a regular funcion call
   dc_impl::dispatch_type dispatch = (dc_impl::dispatch_type)f;
-  dispatch(*this, source, packet_type_mask, data + arc.off, len - arc.off);
+  if (rpc_statistics == NULL) {
+    dispatch(*this, source, packet_type_mask, data + arc.off, len - arc.off);
+  } else {
+    unsigned long long start = rdtsc();
+    dispatch(*this, source, packet_type_mask, data + arc.off, len - arc.off);
+    rpc_statistics->record_call(f, len, rdtsc() - start);
+  }
   if ((packet_type_mask & CONTROL_PACKET) == 0) inc_calls_received(source);
   END_TRACEPOINT(dc_call_dispatch);
 }
@@ -241,9 +295,11 @@ unsigned char distributed_control::get_block_sequentialization_key(fcallqueue_en
   return seq_key;
 }
 
-void distributed_control::deferred_function_call_chunk(char* buf, size_t len, procid_t src) {
+void distributed_control::deferred_function_call_chunk(char* block, char* buf,
+                                                       size_t len, procid_t src) {
   BEGIN_TRACEPOINT(dc_receive_queuing);
   fcallqueue_entry* fc = new fcallqueue_entry;
+  fc->chunk_block = block;
   fc->chunk_src = buf;
   fc->chunk_len = len;
   fc->chunk_ref_counter = NULL;
@@ -294,7 +350,7 @@ void distributed_control::process_fcall_block(fcallqueue_entry &fcallblock) {
     if (fcallblock.chunk_ref_counter != NULL) {
       if (fcallblock.chunk_ref_counter->dec(fcallblock.calls.size()) == 0) {
         delete fcallblock.chunk_ref_counter;
-        free(fcallblock.chunk_src);
+        dc_impl::receive_buffer_pool::release(fcallblock.chunk_block);
       }
     }
   }
@@ -321,7 +377,7 @@ void distributed_control::process_fcall_block(fcallqueue_entry &fcallblock) {
       data += sizeof(dc_impl::packet_hdr) + hdr.len;
       remaininglen -= sizeof(dc_impl::packet_hdr) + hdr.len;
     }
-    free(fcallblock.chunk_src);
+    dc_impl::receive_buffer_pool::release(fcallblock.chunk_block);
   }
 #else
   else {
@@ -332,6 +388,7 @@ void distributed_control::process_fcall_block(fcallqueue_entry &fcallblock) {
 
     fcallqueue_entry immediate_queue;
 
+    immediate_queue.chunk_block = fcallblock.chunk_block;
     immediate_queue.chunk_src = fcallblock.chunk_src;
     immediate_queue.chunk_ref_counter = refctr;
     immediate_queue.chunk_len = 0;
@@ -340,6 +397,7 @@ void distributed_control::process_fcall_block(fcallqueue_entry &fcallblock) {
 
     for (size_t i = 0;i < fcallqueue.size(); ++i) {
       queuebufs[i] = new fcallqueue_entry;
+      queuebufs[i]->chunk_block = fcallblock.chunk_block;
       queuebufs[i]->chunk_src = fcallblock.chunk_src;
       queuebufs[i]->chunk_ref_counter = refctr;
       queuebufs[i]->chunk_len = 0;
@@ -496,7 +554,8 @@ void distributed_control::init(const std::vector<std::string> &machines,
     else numhandlerthreads = 2;
   }
   ASSERT_MSG(machines.size() <= RPC_MAX_N_PROCS,
-             "Number of processes exceeded hard limit of %d", RPC_MAX_N_PROCS);
+             "Number of processes exceeded the limit of %d of procid_t",
+             RPC_MAX_N_PROCS);
 
   // initialize thread local storage
   if (dc_impl::thrlocal_sequentialization_key_initialized == false) {
@@ -526,11 +585,31 @@ void distributed_control::init(const std::vector<std::string> &machines,
   // options
   set_fast_track_requests(true);
 
-  // parse the initstring
-  std::map<std::string,std::string> options = parse_options(initstring);
+  // parse the initstring. Options may also be given in the environment.
+  std::string allopts = initstring;
+  char* envopts = getenv("GRAPHLAB_RPC_OPTIONS");
+  if (envopts != NULL) allopts = allopts + " " + envopts;
+  std::map<std::string,std::string> options = parse_options(allopts);
+
+  rpc_statistics = NULL;
+  if (options.count("rpc_stats") && atoi(options["rpc_stats"].c_str()) != 0) {
+    rpc_statistics = new dc_impl::rpc_stats(machines.size());
+    dc_impl::ireply_container::track_issue_time = true;
+    add_metric_server_callback("rpc_stats.json", rpc_stats_json);
+  }
 
   if (commtype == TCP_COMM) {
-    comm = new dc_impl::dc_tcp_comm();
+    // processes sharing a host talk through shared memory
+    std::map<std::string,std::string>::const_iterator shmopt =
+      options.find("shm_comm");
+    bool use_shm = shmopt == options.end() ||
+        atoi(shmopt->second.c_str()) != 0;
+    if (use_shm &&
+        dc_impl::dc_shm_comm::colocated(machines, curmachineid).size() > 1) {
+      comm = new dc_impl::dc_shm_comm();
+    } else {
+      comm = new dc_impl::dc_tcp_comm();
+    }
   } else {
     ASSERT_MSG(false, "Unexpected value for comm type");
   }
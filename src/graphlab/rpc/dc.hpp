@@ -49,6 +49,7 @@
 #include <graphlab/rpc/request_reply_handler.hpp>
 #include <graphlab/rpc/function_ret_type.hpp>
 #include <graphlab/rpc/dc_compile_parameters.hpp>
+#include <graphlab/rpc/dc_rpc_stats.hpp>
 #include <graphlab/rpc/thread_local_send_buffer.hpp>
 #include <graphlab/util/tracepoint.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
@@ -85,7 +86,27 @@ struct dc_init_param{
   /** Additional construction options of the form
     "key1=value1,key2=value2".
 
-    There are no available options at this time.
+    Options of the TCP communication layer:
+    \li \b tcp_nodelay=0 Leaves Nagle's algorithm enabled. Defaults to 1.
+    \li \b tcp_zerocopy=1 Sends large buffers with MSG_ZEROCOPY instead of
+                         copying them into the kernel (Linux 4.14 and
+                         later). Defaults to 0.
+    \li \b shm_comm=0 Uses TCP between processes on the same host too.
+                     By default they exchange data through shared
+                     memory, which is chosen when several machines of
+                     the list resolve to the same address.
+
+    Other options:
+    \li \b rpc_stats=1 Counts the calls and bytes received by each RPC
+                     handler, and keeps histograms of the time spent in
+                     the handlers and of the request round trips to each
+                     machine. They are printed at shutdown and served on
+                     the rpc_stats.json page of the metrics server.
+                     Defaults to 0.
+
+    The same options may be given in the GRAPHLAB_RPC_OPTIONS environment
+    variable, which also applies to the default constructor of
+    distributed_control.
 
     Internal options which should not be used
     \li \b __socket__=NUMBER Forces TCP comm to use this socket number for its
@@ -234,6 +255,8 @@ class distributed_control{
 
   struct fcallqueue_entry {
     std::vector<function_call_block> calls;
+    /// The receive buffer holding the chunk
+    char* chunk_block;
     char* chunk_src;
     size_t chunk_len;
     atomic<size_t>* chunk_ref_counter;
@@ -267,7 +290,11 @@ class distributed_control{
 
   std::vector<boost::function<void(void)> > deletion_callbacks;
 
+  /// RPC statistics. NULL unless the rpc_stats option is set
+  dc_impl::rpc_stats* rpc_statistics;
+
   template <typename T> friend class dc_dist_object;
+  friend class dc_impl::rpc_stats;
   friend class dc_impl::dc_stream_receive;
   friend class dc_impl::dc_buffered_stream_send2;
   friend struct dc_impl::thread_local_buffer;
@@ -350,6 +377,14 @@ class distributed_control{
     return localnumprocs;
   }
 
+  /**
+   * Returns the RPC statistics of this process, or NULL if the
+   * rpc_stats option is not set.
+   */
+  inline dc_impl::rpc_stats* get_rpc_stats() const {
+    return rpc_statistics;
+  }
+
 
   bool use_fast_track_requests;
 
@@ -757,10 +792,12 @@ class distributed_control{
 
   /**
    * \internal
-   * Receive a collection of serialized function calls.
-   * This function will take ownership of the pointer
+   * Receive a collection of serialized function calls: len bytes at buf,
+   * which lies within the receive buffer block. This function takes over
+   * one reference on block and releases it once the calls are executed.
    */
-  void deferred_function_call_chunk(char* buf, size_t len, procid_t src);
+  void deferred_function_call_chunk(char* block, char* buf, size_t len,
+                                    procid_t src);
 
 
   /**
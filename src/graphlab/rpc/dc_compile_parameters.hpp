@@ -36,8 +36,12 @@
   \ingroup rpc
   \def RPC_MAX_N_PROCS
   \brief Maximum number of processes supported
+ *
+ * procid_t is 16 bits and (procid_t)-1 marks an unknown process. Per
+ * process structures, such as the mirror sets of the vertices, are sized
+ * by the number of processes at runtime.
  */
-#define RPC_MAX_N_PROCS 128
+#define RPC_MAX_N_PROCS 65535
 
 /**
  * \ingroup RPC
@@ -46,6 +50,37 @@
  */
 #define RECEIVE_BUFFER_SIZE 131072
 
+/**
+ * \ingroup RPC
+ * \def RECEIVE_BUFFER_POOL_SIZE
+ * The maximum number of free receive buffers kept for reuse
+ */
+#define RECEIVE_BUFFER_POOL_SIZE 64
+
+/**
+ * \ingroup RPC
+ * \def ZEROCOPY_SEND_THRESHOLD
+ * With the tcp_zerocopy option, sends of at least this many bytes
+ * use MSG_ZEROCOPY. Smaller ones are cheaper to copy.
+ */
+#define ZEROCOPY_SEND_THRESHOLD 16384
+
+/**
+ * \ingroup RPC
+ * \def SHM_RING_SIZE
+ * The size of the shared memory ring between two processes on the
+ * same host. Must be a power of 2.
+ */
+#define SHM_RING_SIZE (4 * 1024 * 1024)
+
+/**
+ * \ingroup RPC
+ * \def SHM_SPIN_COUNT
+ * The number of times the shared memory receiver polls its empty
+ * rings before sleeping until a sender wakes it.
+ */
+#define SHM_SPIN_COUNT 1000
+
 /**************************************************************************/
 /*                                                                        */
 /*                      Send Buffer Behavior Control                      */
@@ -145,5 +180,13 @@
  */
 #define DEFAULT_BUFFERED_EXCHANGE_SIZE FULL_BUFFER_SIZE_LIMIT
 
+/**
+ * \ingroup RPC
+ * \def EXCHANGE_COMPRESSION_BACKLOG
+ * In the adaptive compression mode, the buffered exchanges compress
+ * their blocks while at least this many bytes wait to be sent.
+ */
+#define EXCHANGE_COMPRESSION_BACKLOG (4 * 1024 * 1024)
+
 
 #endif
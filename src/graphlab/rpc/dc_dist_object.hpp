@@ -28,6 +28,8 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
+#include <algorithm>
 #include <graphlab/parallel/atomic.hpp>
 #include <graphlab/parallel/fiber_conditional.hpp>
 #include <graphlab/rpc/dc_internal_types.hpp>
@@ -230,10 +232,8 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
 
     parent =  (procid_t)((dc_.procid() - 1) / BARRIER_BRANCH_FACTOR)   ;
 
-    //-------- Initialize all gather --------------
-    ab_child_barrier_counter.value = 0;
-    ab_barrier_sense = 1;
-    ab_barrier_release = -1;
+    //-------- Initialize the collectives --------------
+    coll_seq = 0;
 
 
     //-------- Initialize the full barrier ---------
@@ -859,60 +859,112 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
 
 
 /*****************************************************************************
-                      Implementation of Broadcast
+                      Implementation of the Collectives
  *****************************************************************************/
 
-private:
+ private:
+  /**
+   * broadcast, all_gather and all_reduce take about log2(numprocs()) rounds
+   * of messages between pairs of machines. The messages are matched by the
+   * number of the collective and the round. A machine may receive the
+   * messages of the next collective before it completes the current one.
+   */
+  struct collective_message {
+    procid_t origin;
+    std::vector<std::string> blocks;
+  };
+  std::map<std::pair<size_t, size_t>, collective_message> coll_mailbox;
+  /// Number of collectives completed by this machine
+  size_t coll_seq;
+  mutex coll_mut;
+  fiber_conditional coll_cond;
+
+  /// The round in which all_reduce returns the result to the machines
+  /// past the largest power of 2
+  static const size_t COLL_RESULT_ROUND = size_t(-1);
+
+  void __coll_receive(size_t seq, size_t round, procid_t origin,
+                      const std::vector<std::string>& blocks) {
+    coll_mut.lock();
+    collective_message& msg = coll_mailbox[std::make_pair(seq, round)];
+    msg.origin = origin;
+    msg.blocks = blocks;
+    coll_cond.signal();
+    coll_mut.unlock();
+  }
 
-  std::string broadcast_receive;
+  void coll_send(procid_t target, size_t round, procid_t origin,
+                 const std::vector<std::string>& blocks, bool control) {
+    if (control) {
+      internal_control_call(target, &dc_dist_object<T>::__coll_receive,
+                            coll_seq, round, origin, blocks);
+    } else {
+      internal_call(target, &dc_dist_object<T>::__coll_receive,
+                    coll_seq, round, origin, blocks);
+    }
+  }
 
-  void set_broadcast_receive(const std::string &s) {
-    broadcast_receive = s;
+  /// Waits for the message of a round of the current collective
+  void coll_recv(size_t round, collective_message& ret) {
+    const std::pair<size_t, size_t> key(coll_seq, round);
+    coll_mut.lock();
+    while(1) {
+      typename std::map<std::pair<size_t, size_t>, collective_message>::iterator
+          iter = coll_mailbox.find(key);
+      if (iter != coll_mailbox.end()) {
+        ret.origin = iter->second.origin;
+        ret.blocks.swap(iter->second.blocks);
+        coll_mailbox.erase(iter);
+        break;
+      }
+      coll_cond.wait(coll_mut);
+    }
+    coll_mut.unlock();
   }
 
+  template <typename U>
+  static std::string coll_serialize(const U& data) {
+    charstream strm(128);
+    oarchive oarc(strm);
+    oarc << data;
+    strm.flush();
+    return std::string(strm->c_str(), strm->size());
+  }
+
+  template <typename U>
+  static void coll_deserialize(const std::string& s, U& data) {
+    iarchive iarc(s.c_str(), s.length());
+    iarc >> data;
+  }
 
  public:
 
   /// \copydoc distributed_control::broadcast()
   template <typename U>
   void broadcast(U& data, bool originator, bool control = false) {
-    if (originator) {
-      // construct the data stream
-      std::stringstream strm;
-      oarchive oarc(strm);
-      oarc << data;
-      strm.flush();
-      broadcast_receive = strm.str();
-      if (control == false) {
-        for (size_t i = 0;i < numprocs(); ++i) {
-          if (i != procid()) {
-            internal_request(i,
-                            &dc_dist_object<T>::set_broadcast_receive,
-                            broadcast_receive);
-          }
-        }
+    if (numprocs() > 1) {
+      const size_t nprocs = numprocs();
+      collective_message msg;
+      if (originator) {
+        msg.origin = procid();
+        msg.blocks.push_back(coll_serialize(data));
+      } else {
+        coll_recv(0, msg);
+        coll_deserialize(msg.blocks[0], data);
       }
-      else {
-        for (size_t i = 0;i < numprocs(); ++i) {
-          if (i != procid()) {
-            internal_control_request(i,
-                                    &dc_dist_object<T>::set_broadcast_receive,
-                                    broadcast_receive);
-          }
+      // forward down the binomial tree rooted at the originator. The
+      // machine of rank r receives from r minus its highest bit, and
+      // sends to r + d for the powers of 2 d > r, largest subtree first.
+      const size_t rank = (procid() + nprocs - msg.origin) % nprocs;
+      size_t dist = 1;
+      while (dist < nprocs) dist *= 2;
+      for (dist /= 2; dist > rank; dist /= 2) {
+        if (rank + dist < nprocs) {
+          coll_send((procid() + dist) % nprocs, 0, msg.origin, msg.blocks,
+                    control);
         }
       }
-    }
-
-    // by the time originator gets here, all machines
-    // will have received the data due to the broadcast_receive
-    // set a barrier here.
-    barrier();
-
-    // all machines will now deserialize the data
-    if (!originator) {
-      std::stringstream strm(broadcast_receive);
-      iarchive iarc(strm);
-      iarc >> data;
+      ++coll_seq;
     }
     barrier();
   }
@@ -978,204 +1030,31 @@ private:
              Implementation of all gather
 *********************************************************************/
 
-
-
- private:
-  // ------- Sense reversing barrier data ----------
-  /// The next value of the barrier. either +1 or -1
-  int ab_barrier_sense;
-  /// When this flag == the current barrier value. The barrier is complete
-  int ab_barrier_release;
-  /** when barrier sense is 1, barrier clears when
-   * child_barrier_counter == numchild. When barrier sense is -1, barrier
-   * clears when child_barrier_counter == 0;
-   */
-  atomic<int> ab_child_barrier_counter;
-  /// condition variable and mutex protecting the barrier variables
-  fiber_conditional ab_barrier_cond;
-  mutex ab_barrier_mut;
-  std::string ab_children_data[BARRIER_BRANCH_FACTOR];
-  std::string ab_alldata;
-
-  /**
-    The child calls this function in the parent once the child enters the barrier
-  */
-  void __ab_child_to_parent_barrier_trigger(procid_t source, std::string collect) {
-    ab_barrier_mut.lock();
-    // assert childbase <= source <= childbase + BARRIER_BRANCH_FACTOR
-    ASSERT_GE(source, childbase);
-    ASSERT_LT(source, childbase + BARRIER_BRANCH_FACTOR);
-    ab_children_data[source - childbase] = collect;
-    ab_child_barrier_counter.inc(ab_barrier_sense);
-    ab_barrier_cond.signal();
-    ab_barrier_mut.unlock();
-  }
-
-  /**
-    This is on the downward pass of the barrier. The parent calls this function
-    to release all the children's barriers
-  */
-  void __ab_parent_to_child_barrier_release(int releaseval,
-                                            std::string allstrings,
-                                            int use_control_calls) {
-    // send the release downwards
-    // get my largest child
-    logger(LOG_DEBUG, "AB Barrier Release %d", releaseval);
-    ab_alldata = allstrings;
-    for (procid_t i = 0;i < numchild; ++i) {
-      if (use_control_calls) {
-        internal_control_call((procid_t)(childbase + i),
-                              &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                              releaseval,
-                              ab_alldata,
-                              use_control_calls);
-      }
-      else {
-        internal_call((procid_t)(childbase + i),
-                      &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                      releaseval,
-                      ab_alldata,
-                      use_control_calls);
-      }
-    }
-    ab_barrier_mut.lock();
-    ab_barrier_release = releaseval;
-    ab_barrier_cond.signal();
-    ab_barrier_mut.unlock();
-  }
-
-
  public:
 
   /// \copydoc distributed_control::all_gather()
   template <typename U>
   void all_gather(std::vector<U>& data, bool control = false) {
     if (numprocs() == 1) return;
-    // get the string representation of the data
-    charstream strm(128);
-    oarchive oarc(strm);
-    oarc << data[procid()];
-    strm.flush();
-    // upward message
-    int ab_barrier_val = ab_barrier_sense;
-    ab_barrier_mut.lock();
-    // wait for all children to be done
-    while(1) {
-      if ((ab_barrier_sense == -1 && ab_child_barrier_counter.value == 0) ||
-          (ab_barrier_sense == 1 && ab_child_barrier_counter.value == (int)(numchild))) {
-        // flip the barrier sense
-        ab_barrier_sense = -ab_barrier_sense;
-        // call child to parent in parent
-        ab_barrier_mut.unlock();
-        if (procid() != 0) {
-          // collect all my children data
-          charstream strstrm(128);
-          oarchive oarc2(strstrm);
-          oarc2 << std::string(strm->c_str(), strm->size());
-          for (procid_t i = 0;i < numchild; ++i) {
-            strstrm.write(ab_children_data[i].c_str(), ab_children_data[i].length());
-          }
-          strstrm.flush();
-          if (control) {
-            internal_control_call(parent,
-                            &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                            procid(),
-                            std::string(strstrm->c_str(), strstrm->size()));
-          }
-          else {
-            internal_call(parent,
-                          &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                          procid(),
-                          std::string(strstrm->c_str(), strstrm->size()));
-          }
-        }
-        break;
-      }
-      ab_barrier_cond.wait(ab_barrier_mut);
+    const size_t nprocs = numprocs();
+    // Bruck's algorithm: blocks[i] is the data of machine
+    // (procid() + i) % nprocs. Each round doubles the blocks held by
+    // getting those of the machine dist ahead.
+    std::vector<std::string> blocks(1, coll_serialize(data[procid()]));
+    size_t round = 0;
+    for (size_t dist = 1; dist < nprocs; dist *= 2, ++round) {
+      const size_t count = std::min(dist, nprocs - dist);
+      coll_send((procid() + nprocs - dist) % nprocs, round, procid(),
+                std::vector<std::string>(blocks.begin(), blocks.begin() + count),
+                control);
+      collective_message msg;
+      coll_recv(round, msg);
+      ASSERT_EQ(msg.blocks.size(), count);
+      blocks.insert(blocks.end(), msg.blocks.begin(), msg.blocks.end());
     }
-
-
-    logger(LOG_DEBUG, "AB barrier phase 1 complete");
-    // I am root. send the barrier release downwards
-    if (procid() == 0) {
-      ab_barrier_release = ab_barrier_val;
-      // build the downward data
-      charstream strstrm(128);
-      oarchive oarc2(strstrm);
-      oarc2 << std::string(strm->c_str(), strm->size());
-      for (procid_t i = 0;i < numchild; ++i) {
-        strstrm.write(ab_children_data[i].c_str(), ab_children_data[i].length());
-      }
-      strstrm.flush();
-      ab_alldata = std::string(strstrm->c_str(), strstrm->size());
-      for (procid_t i = 0;i < numchild; ++i) {
-        logger(LOG_DEBUG, "Sending AB release to %d", childbase + i);
-        internal_control_call((procid_t)(childbase + i),
-                             &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                             ab_barrier_val,
-                             ab_alldata,
-                             (int)control);
-
-      }
-    }
-    // wait for the downward message releasing the barrier
-    logger(LOG_DEBUG, "AB barrier waiting for %d", ab_barrier_val);
-    ab_barrier_mut.lock();
-    while(1) {
-      if (ab_barrier_release == ab_barrier_val) break;
-      ab_barrier_cond.wait(ab_barrier_mut);
-    }
-    // read the collected data and release the lock
-    std::string local_ab_alldata = ab_alldata;
-    ab_barrier_mut.unlock();
-
-    logger(LOG_DEBUG, "barrier phase 2 complete");
-    // now the data is a DFS search of a heap
-    // I need to unpack it
-    size_t heappos = 0;
-    std::stringstream istrm(local_ab_alldata);
-    iarchive iarc(istrm);
-
-    for (size_t i = 0;i < numprocs(); ++i) {
-      std::string s;
-      iarc >> s;
-
-      std::stringstream strm2(s);
-      iarchive iarc2(strm2);
-      iarc2 >> data[heappos];
-
-      if (i + 1 == numprocs()) break;
-      // advance heappos
-      // leftbranch
-      bool lefttraverseblock = false;
-      while (1) {
-        // can we continue going deaper down the left?
-        size_t leftbranch = heappos * BARRIER_BRANCH_FACTOR + 1;
-        if (lefttraverseblock == false && leftbranch < numprocs()) {
-          heappos = leftbranch;
-          break;
-        }
-        // ok. can't go down the left
-        bool this_is_a_right_branch = (((heappos - 1) % BARRIER_BRANCH_FACTOR) == BARRIER_BRANCH_FACTOR - 1);
-        // if we are a left branch, go to sibling
-        if (this_is_a_right_branch == false) {
-          size_t sibling = heappos + 1;
-          if (sibling < numprocs()) {
-            heappos = sibling;
-            break;
-          }
-        }
-
-        // we have finished this subtree, go back up to parent
-        // and block the depth traversal on the next round
-        // unless heappos is 0
-
-        heappos = (heappos - 1) / BARRIER_BRANCH_FACTOR;
-        lefttraverseblock = true;
-        continue;
-        // go to sibling
-      }
-
+    ++coll_seq;
+    for (size_t i = 1; i < nprocs; ++i) {
+      coll_deserialize(blocks[i], data[(procid() + i) % nprocs]);
     }
   }
 
@@ -1183,103 +1062,51 @@ private:
   template <typename U, typename PlusEqual>
   void all_reduce2(U& data, PlusEqual plusequal, bool control = false) {
     if (numprocs() == 1) return;
-    // get the string representation of the data
-   /* charstream strm(128);
-    oarchive oarc(strm);
-    oarc << data;
-    strm.flush();*/
-    // upward message
-    int ab_barrier_val = ab_barrier_sense;
-    ab_barrier_mut.lock();
-    // wait for all children to be done
-    while(1) {
-      if ((ab_barrier_sense == -1 && ab_child_barrier_counter.value == 0) ||
-          (ab_barrier_sense == 1 && ab_child_barrier_counter.value == (int)(numchild))) {
-        // flip the barrier sense
-        ab_barrier_sense = -ab_barrier_sense;
-        // call child to parent in parent
-        ab_barrier_mut.unlock();
-        if (procid() != 0) {
-          // accumulate my children data
-          for (procid_t i = 0;i < numchild; ++i) {
-            std::stringstream istrm(ab_children_data[i]);
-            iarchive iarc(istrm);
-            U tmp;
-            iarc >> tmp;
-            plusequal(data, tmp);
-          }
-          // upward message
-          charstream ostrm(128);
-          oarchive oarc(ostrm);
-          oarc << data;
-          ostrm.flush();
-          if (control) {
-            internal_control_call(parent,
-                            &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                            procid(),
-                            std::string(ostrm->c_str(), ostrm->size()));
-          }
-          else {
-            internal_call(parent,
-                          &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                          procid(),
-                          std::string(ostrm->c_str(), ostrm->size()));
-          }
-        }
-        break;
-      }
-      ab_barrier_cond.wait(ab_barrier_mut);
+    const size_t nprocs = numprocs();
+    const size_t me = procid();
+    // Recursive doubling over the largest power of 2 of the machines.
+    // The machines past it first hand their value to the one pow2 below,
+    // which returns them the result.
+    size_t pow2 = 1;
+    while (pow2 * 2 <= nprocs) pow2 *= 2;
+    collective_message msg;
+    if (me >= pow2) {
+      coll_send(me - pow2, 0, me,
+                std::vector<std::string>(1, coll_serialize(data)), control);
+      coll_recv(COLL_RESULT_ROUND, msg);
+      coll_deserialize(msg.blocks[0], data);
+      ++coll_seq;
+      return;
     }
-
-
-    logger(LOG_DEBUG, "AB barrier phase 1 complete");
-    // I am root. send the barrier release downwards
-    if (procid() == 0) {
-      ab_barrier_release = ab_barrier_val;
-      for (procid_t i = 0;i < numchild; ++i) {
-        std::stringstream istrm(ab_children_data[i]);
-        iarchive iarc(istrm);
-        U tmp;
-        iarc >> tmp;
-        plusequal(data, tmp);
-      }
-      // build the downward data
-      charstream ostrm(128);
-      oarchive oarc(ostrm);
-      oarc << data;
-      ostrm.flush();
-      ab_alldata = std::string(ostrm->c_str(), ostrm->size());
-      for (procid_t i = 0;i < numchild; ++i) {
-        internal_control_call((procid_t)(childbase + i),
-                             &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                             ab_barrier_val,
-                             ab_alldata,
-                             (int)control);
-
-      }
+    if (me + pow2 < nprocs) {
+      coll_recv(0, msg);
+      U other;
+      coll_deserialize(msg.blocks[0], other);
+      plusequal(data, other);
     }
-    // wait for the downward message releasing the barrier
-    logger(LOG_DEBUG, "AB barrier waiting for %d", ab_barrier_val);
-    ab_barrier_mut.lock();
-    while(1) {
-      if (ab_barrier_release == ab_barrier_val) break;
-      ab_barrier_cond.wait(ab_barrier_mut);
-    }
-
-    if (procid() != 0) {
-      // read the collected data and release the lock
-      std::string local_ab_alldata = ab_alldata;
-      ab_barrier_mut.unlock();
-
-      logger(LOG_DEBUG, "barrier phase 2 complete");
-
-      std::stringstream istrm(local_ab_alldata);
-      iarchive iarc(istrm);
-      iarc >> data;
+    size_t round = 1;
+    for (size_t mask = 1; mask < pow2; mask *= 2, ++round) {
+      const size_t partner = me ^ mask;
+      coll_send(partner, round, me,
+                std::vector<std::string>(1, coll_serialize(data)), control);
+      coll_recv(round, msg);
+      U other;
+      coll_deserialize(msg.blocks[0], other);
+      // both sides add the lower machine's value first, so that all
+      // machines end with the same result even if plusequal rounds or
+      // does not commute
+      if (partner < me) {
+        plusequal(other, data);
+        std::swap(data, other);
+      } else {
+        plusequal(data, other);
+      }
     }
-    else {
-      ab_barrier_mut.unlock();
+    if (me + pow2 < nprocs) {
+      coll_send(me + pow2, COLL_RESULT_ROUND, me,
+                std::vector<std::string>(1, coll_serialize(data)), control);
     }
+    ++coll_seq;
   }
 
 
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#include <execinfo.h>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <sstream>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/rpc/dc_rpc_stats.hpp>
+
+// defined in logger/backtrace.cpp
+std::string demangle(const char* symbol);
+
+namespace graphlab {
+namespace dc_impl {
+
+rpc_stats::rpc_stats(procid_t numprocs)
+    : functions(MAX_FUNCTIONS + 1), round_trip(numprocs) {
+  start_cycles = rdtsc();
+  start_usec = timer::usec_of_day();
+}
+
+double rpc_stats::cycles_per_usec() const {
+  const double usec = double(timer::usec_of_day() - start_usec);
+  if (usec <= 0) return 1.0;
+  return double(rdtsc() - start_cycles) / usec;
+}
+
+std::string rpc_stats::function_name(size_t dispatch) {
+  if (dispatch == 0) return "other";
+  void* addr = reinterpret_cast<void*>(dispatch);
+  char** symbols = backtrace_symbols(&addr, 1);
+  std::string name;
+  if (symbols != NULL) {
+    name = demangle(symbols[0]);
+    free(symbols);
+  } else {
+    char buf[32];
+    sprintf(buf, "%p", addr);
+    name = buf;
+  }
+  // the name goes into a json string
+  std::replace(name.begin(), name.end(), '"', '\'');
+  std::replace(name.begin(), name.end(), '\\', '/');
+  return name;
+}
+
+/// Writes the quantiles of a histogram in cycles as microseconds
+static void histogram_json(std::ostream& strm, const latency_histogram& h,
+                           double cycles_per_usec) {
+  strm << "{\"count\": " << h.count()
+       << ", \"mean\": " << h.mean() / cycles_per_usec
+       << ", \"p50\": " << h.quantile(0.5) / cycles_per_usec
+       << ", \"p90\": " << h.quantile(0.9) / cycles_per_usec
+       << ", \"p99\": " << h.quantile(0.99) / cycles_per_usec
+       << ", \"max\": " << h.max() / cycles_per_usec << "}";
+}
+
+/// Orders the functions by the total time spent in their handlers
+struct by_handler_time {
+  const std::vector<size_t>& total;
+  by_handler_time(const std::vector<size_t>& total) : total(total) { }
+  bool operator()(size_t a, size_t b) const { return total[a] > total[b]; }
+};
+
+std::string rpc_stats::to_json(const distributed_control& dc) const {
+  const double cpu = cycles_per_usec();
+  std::stringstream strm;
+  strm << "{\n  \"procid\": " << dc.procid() << ",\n  \"functions\": [";
+  bool first = true;
+  for (size_t i = 0; i <= MAX_FUNCTIONS; ++i) {
+    if (functions[i].calls.value == 0) continue;
+    strm << (first ? "\n" : ",\n")
+         << "    {\"name\": \"" << function_name(functions[i].dispatch) << "\""
+         << ", \"calls\": " << functions[i].calls.value
+         << ", \"bytes\": " << functions[i].bytes.value
+         << ", \"handler_usec\": ";
+    histogram_json(strm, functions[i].handler_cycles, cpu);
+    strm << "}";
+    first = false;
+  }
+  strm << "\n  ],\n  \"peers\": [";
+  for (procid_t p = 0; p < dc.numprocs(); ++p) {
+    strm << (p == 0 ? "\n" : ",\n")
+         << "    {\"procid\": " << p
+         << ", \"calls_sent\": " << dc.global_calls_sent[p].value
+         << ", \"bytes_sent\": " << dc.senders[p]->bytes_sent()
+         << ", \"calls_received\": " << dc.global_calls_received[p].value
+         << ", \"bytes_received\": " << dc.global_bytes_received[p].value
+         << ", \"round_trip_usec\": ";
+    histogram_json(strm, round_trip[p], cpu);
+    strm << "}";
+  }
+  strm << "\n  ]\n}";
+  return strm.str();
+}
+
+void rpc_stats::print(std::ostream& out, const distributed_control& dc) const {
+  const double cpu = cycles_per_usec();
+  std::vector<size_t> total(MAX_FUNCTIONS + 1);
+  std::vector<size_t> order;
+  for (size_t i = 0; i <= MAX_FUNCTIONS; ++i) {
+    total[i] = functions[i].handler_cycles.total_sum();
+    if (functions[i].calls.value > 0) order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), by_handler_time(total));
+  out << "RPC handlers by total time (usec):\n";
+  for (size_t j = 0; j < order.size(); ++j) {
+    const function_stats& fn = functions[order[j]];
+    out << "  " << total[order[j]] / cpu
+        << "  calls " << fn.calls.value
+        << "  bytes " << fn.bytes.value
+        << "  p50 " << fn.handler_cycles.quantile(0.5) / cpu
+        << "  p99 " << fn.handler_cycles.quantile(0.99) / cpu
+        << "  max " << fn.handler_cycles.max() / cpu
+        << "  " << function_name(fn.dispatch) << "\n";
+  }
+  out << "RPC peers:\n";
+  for (procid_t p = 0; p < dc.numprocs(); ++p) {
+    const latency_histogram& rt = round_trip[p];
+    out << "  " << p
+        << "  calls sent " << dc.global_calls_sent[p].value
+        << "  received " << dc.global_calls_received[p].value
+        << "  bytes sent " << dc.senders[p]->bytes_sent()
+        << "  received " << dc.global_bytes_received[p].value
+        << "  requests " << rt.count();
+    if (rt.count() > 0) {
+      out << "  round trip usec p50 " << rt.quantile(0.5) / cpu
+          << "  p99 " << rt.quantile(0.99) / cpu
+          << "  max " << rt.max() / cpu;
+    }
+    out << "\n";
+  }
+}
+
+} // namespace dc_impl
+} // namespace graphlab
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_DC_RPC_STATS_HPP
+#define GRAPHLAB_DC_RPC_STATS_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <graphlab/rpc/dc_types.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/util/latency_histogram.hpp>
+#include <graphlab/util/timer.hpp>
+
+namespace graphlab {
+
+class distributed_control;
+
+namespace dc_impl {
+
+/**
+ * \ingroup rpc
+ * \internal
+ * RPC statistics of one process, kept by distributed_control when
+ * constructed with the rpc_stats=1 option.
+ *
+ * For each dispatch function, the number of calls received, their bytes
+ * and a histogram of the cycles spent in the handler. A dispatch function
+ * is instantiated per class and function signature, so member functions
+ * of a class sharing a signature share an entry. For each peer, a
+ * histogram of the request round trip cycles, from the construction of
+ * the reply container to the arrival of the reply.
+ *
+ * Cycles are converted to microseconds when reported.
+ */
+class rpc_stats {
+ public:
+  /// Number of dispatch functions tracked. Beyond that, calls go to "other"
+  static const size_t MAX_FUNCTIONS = 256;
+
+  explicit rpc_stats(procid_t numprocs);
+
+  /// Records the call of a dispatch function
+  inline void record_call(size_t dispatch, size_t len, uint64_t cycles) {
+    function_stats& fn = functions[find_function(dispatch)];
+    fn.calls.inc();
+    fn.bytes.inc(len);
+    fn.handler_cycles.add(cycles);
+  }
+
+  /// Records the round trip of a request to a peer
+  inline void record_round_trip(procid_t peer, uint64_t cycles) {
+    round_trip[peer].add(cycles);
+  }
+
+  /// rdtsc cycles per microsecond, measured since construction
+  double cycles_per_usec() const;
+
+  /**
+   * The statistics of this process as a json object, together with the
+   * per peer call and byte counts of dc.
+   */
+  std::string to_json(const distributed_control& dc) const;
+
+  /// Prints the busiest functions and the round trips to every peer
+  void print(std::ostream& out, const distributed_control& dc) const;
+
+ private:
+  struct function_stats {
+    /// The dispatch function. 0 if the entry is unused
+    volatile size_t dispatch;
+    atomic<size_t> calls;
+    atomic<size_t> bytes;
+    latency_histogram handler_cycles;
+    function_stats() : dispatch(0) { }
+  };
+
+  /// Open addressing table of MAX_FUNCTIONS + 1 entries, the last is "other"
+  std::vector<function_stats> functions;
+  std::vector<latency_histogram> round_trip;
+
+  unsigned long long start_cycles;
+  size_t start_usec;
+
+  /// Returns the entry of a dispatch function, claiming one if new
+  inline size_t find_function(size_t dispatch) {
+    size_t h = (dispatch >> 4) * 0x9E3779B97F4A7C15ULL;
+    for (size_t probe = 0; probe < MAX_FUNCTIONS; ++probe) {
+      const size_t i = (h + probe) % MAX_FUNCTIONS;
+      const size_t cur = functions[i].dispatch;
+      if (cur == dispatch) return i;
+      if (cur == 0) {
+        if (__sync_bool_compare_and_swap(&functions[i].dispatch, 0, dispatch) ||
+            functions[i].dispatch == dispatch) {
+          return i;
+        }
+      }
+    }
+    return MAX_FUNCTIONS;
+  }
+
+  /// The demangled name of a dispatch function
+  static std::string function_name(size_t dispatch);
+};
+
+} // namespace dc_impl
+} // namespace graphlab
+#endif
@@ -0,0 +1,358 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sched.h>
+#include <errno.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <cstring>
+#include <vector>
+#include <string>
+#include <map>
+
+#include <boost/bind.hpp>
+#include <graphlab/logger/logger.hpp>
+#include <graphlab/rpc/dc_shm_comm.hpp>
+#include <graphlab/rpc/dc_compile_parameters.hpp>
+
+namespace graphlab {
+
+  namespace dc_impl {
+
+    /// "GLSHMCM1" in little endian
+    static const uint64_t SHM_SEGMENT_MAGIC = 0x314d434d48534c47ULL;
+
+    /**
+     * The sender given to dc_tcp_comm for the machines reached through
+     * shared memory. It never has data, so tcp leaves those sockets idle.
+     */
+    class dc_null_send: public dc_send {
+     public:
+      void register_send_buffer(thread_local_buffer* buffer) { }
+      void unregister_send_buffer(thread_local_buffer* buffer) { }
+      size_t bytes_sent() { return 0; }
+      void flush() { }
+      void flush_soon() { }
+      void write_to_buffer(char* c, size_t len) { ASSERT_TRUE(false); }
+      size_t get_outgoing_data(circular_iovec_buffer& outdata) { return 0; }
+    };
+
+    /// Resolves the address part of "[IP]:[portnumber]"
+    static uint32_t machine_address(const std::string& machine) {
+      size_t pos = machine.find(":");
+      ASSERT_NE(pos, std::string::npos);
+      std::string address = machine.substr(0, pos);
+      struct hostent* ent = gethostbyname(address.c_str());
+      ASSERT_TRUE(ent != NULL);
+      ASSERT_EQ(ent->h_length, 4);
+      return *reinterpret_cast<uint32_t*>(ent->h_addr_list[0]);
+    }
+
+    std::vector<procid_t>
+    dc_shm_comm::colocated(const std::vector<std::string> &machines,
+                           procid_t curmachineid) {
+      std::vector<procid_t> ret;
+      const uint32_t myaddr = machine_address(machines[curmachineid]);
+      for (size_t i = 0;i < machines.size(); ++i) {
+        if (i == curmachineid || machine_address(machines[i]) == myaddr) {
+          ret.push_back(i);
+        }
+      }
+      return ret;
+    }
+
+    std::string dc_shm_comm::get_segment_name(const std::string& machine) {
+      // the port is bound by a single process of the host
+      size_t pos = machine.find(":");
+      ASSERT_NE(pos, std::string::npos);
+      return "/graphlab_shm_comm_" + machine.substr(pos + 1);
+    }
+
+    void dc_shm_comm::init(const std::vector<std::string> &machines,
+                           const std::map<std::string,std::string> &initopts,
+                           procid_t curmachineid,
+                           std::vector<dc_receive*> receiver_,
+                           std::vector<dc_send*> sender_) {
+      receiver = receiver_;
+      sender = sender_;
+      buffered_len = 0;
+      shm_bytessent = 0;
+      shm_bytesreceived = 0;
+      done = false;
+
+      std::vector<procid_t> local = colocated(machines, curmachineid);
+      peer_index.assign(machines.size(), -1);
+      size_t myslot = 0;
+      for (size_t i = 0;i < local.size(); ++i) {
+        local_peer* peer = new local_peer;
+        peer->id = local[i];
+        peer->outsegment = NULL;
+        peer->outsegment_size = 0;
+        peer->triggered = false;
+        peers.push_back(peer);
+        peer_index[local[i]] = i;
+        if (local[i] == curmachineid) myslot = i;
+      }
+
+      // create the segment holding the rings to this process. A segment
+      // left by an earlier run on the same port is replaced.
+      segment_name = get_segment_name(machines[curmachineid]);
+      segment_size = sizeof(segment_header) +
+          peers.size() * shm_ring::memory_size(SHM_RING_SIZE);
+      shm_unlink(segment_name.c_str());
+      int fd = shm_open(segment_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      if (fd < 0) {
+        logstream(LOG_FATAL) << "Unable to create shared memory segment "
+                             << segment_name << ": " << strerror(errno) << std::endl;
+      }
+      if (ftruncate(fd, segment_size) != 0) {
+        logstream(LOG_FATAL) << "Unable to size shared memory segment "
+                             << segment_name << ": " << strerror(errno) << std::endl;
+      }
+      void* mem = mmap(NULL, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (mem == MAP_FAILED) {
+        logstream(LOG_FATAL) << "Unable to map shared memory segment "
+                             << segment_name << ": " << strerror(errno) << std::endl;
+      }
+      // the new segment is zeroed, so all the rings are empty
+      segment = reinterpret_cast<segment_header*>(mem);
+      segment->nrings = peers.size();
+      segment->ring_capacity = SHM_RING_SIZE;
+      for (size_t i = 0;i < peers.size(); ++i) {
+        peers[i]->inring.attach(reinterpret_cast<char*>(mem) + sizeof(segment_header) +
+                                i * shm_ring::memory_size(SHM_RING_SIZE),
+                                SHM_RING_SIZE);
+      }
+      __sync_synchronize();
+      segment->magic = SHM_SEGMENT_MAGIC;
+
+      // establish the TCP connections. Once it returns, every process
+      // has connected, so the segments of the local peers exist.
+      null_sender = new dc_null_send;
+      std::vector<dc_send*> tcp_sender(sender);
+      for (size_t i = 0;i < peers.size(); ++i) tcp_sender[peers[i]->id] = null_sender;
+      tcp.init(machines, initopts, curmachineid, receiver, tcp_sender);
+
+      for (size_t i = 0;i < peers.size(); ++i) {
+        open_peer_segment(*peers[i], get_segment_name(machines[peers[i]->id]), myslot);
+      }
+      logstream(LOG_INFO) << "Proc " << curmachineid << " reaches " << peers.size() - 1
+                          << " other processes through shared memory" << std::endl;
+
+      threads.launch(boost::bind(&dc_shm_comm::receive_loop, this));
+      threads.launch(boost::bind(&dc_shm_comm::send_loop, this));
+      is_closed = false;
+    }
+
+    void dc_shm_comm::open_peer_segment(local_peer& peer, const std::string& name,
+                                        size_t myslot) {
+      int fd = shm_open(name.c_str(), O_RDWR, 0600);
+      if (fd < 0) {
+        logstream(LOG_FATAL) << "Unable to open shared memory segment "
+                             << name << ": " << strerror(errno) << std::endl;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(segment_header)) {
+        logstream(LOG_FATAL) << "Shared memory segment " << name
+                             << " is too short" << std::endl;
+      }
+      peer.outsegment_size = st.st_size;
+      void* mem = mmap(NULL, peer.outsegment_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (mem == MAP_FAILED) {
+        logstream(LOG_FATAL) << "Unable to map shared memory segment "
+                             << name << ": " << strerror(errno) << std::endl;
+      }
+      peer.outsegment = reinterpret_cast<segment_header*>(mem);
+      if (peer.outsegment->magic != SHM_SEGMENT_MAGIC ||
+          peer.outsegment->nrings != peers.size() ||
+          peer.outsegment->ring_capacity != SHM_RING_SIZE ||
+          peer.outsegment_size != segment_size) {
+        logstream(LOG_FATAL) << "Shared memory segment " << name
+                             << " does not match this process" << std::endl;
+      }
+      peer.outring.attach(reinterpret_cast<char*>(mem) + sizeof(segment_header) +
+                          myslot * shm_ring::memory_size(SHM_RING_SIZE),
+                          SHM_RING_SIZE);
+    }
+
+    void dc_shm_comm::trigger_send_timeout(procid_t target, bool urgent) {
+      if (peer_index[target] < 0) {
+        tcp.trigger_send_timeout(target, urgent);
+      } else if (urgent) {
+        process_peer(*peers[peer_index[target]]);
+      } else {
+        local_peer& peer = *peers[peer_index[target]];
+        if (peer.triggered == false) {
+          peer.triggered = true;
+          send_lock.lock();
+          send_cond.signal();
+          send_lock.unlock();
+        }
+      }
+    }
+
+    bool dc_shm_comm::process_peer(local_peer& peer) {
+      // like process_sock, whoever holds the lock does the work
+      if (!peer.m.try_lock()) return false;
+      buffered_len.inc(sender[peer.id]->get_outgoing_data(peer.outvec));
+      size_t written = 0;
+      bool full = false;
+      struct msghdr data;
+      while(!peer.outvec.empty() && !full) {
+        peer.outvec.fill_msghdr(data);
+        size_t len = 0;
+        for (size_t i = 0;i < data.msg_iovlen && !full; ++i) {
+          const size_t n = peer.outring.write((char*)data.msg_iov[i].iov_base,
+                                              data.msg_iov[i].iov_len);
+          len += n;
+          full = n < data.msg_iov[i].iov_len;
+        }
+        peer.outvec.sent(len);
+        written += len;
+      }
+      const bool pending = !peer.outvec.empty();
+      peer.m.unlock();
+      if (written > 0) {
+        shm_bytessent.inc(written);
+        ring_doorbell(peer.outsegment);
+      }
+      return pending;
+    }
+
+    void dc_shm_comm::ring_doorbell(segment_header* seg) {
+      // the ring head must be visible before waiting is read
+      __sync_synchronize();
+      if (seg->waiting) {
+        __sync_fetch_and_add(&seg->doorbell, 1);
+#ifdef __linux__
+        syscall(SYS_futex, &seg->doorbell, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+      }
+    }
+
+    void dc_shm_comm::receive_loop() {
+      size_t idle = 0;
+      while(!done) {
+        bool received = false;
+        for (size_t i = 0;i < peers.size(); ++i) {
+          local_peer& peer = *peers[i];
+          if (peer.inring.read_available() == 0) continue;
+          dc_receive* recv = receiver[peer.id];
+          size_t buflength;
+          char* c = recv->get_buffer(buflength);
+          while(1) {
+            size_t n = peer.inring.read(c, buflength);
+            if (n == 0) break;
+            shm_bytesreceived.inc(n);
+            c = recv->advance_buffer(c, n, buflength);
+          }
+          received = true;
+        }
+        if (received) {
+          idle = 0;
+          continue;
+        }
+        // poll a little before sleeping, since replies often follow soon
+        if (++idle < SHM_SPIN_COUNT) {
+          sched_yield();
+          continue;
+        }
+        const uint32_t bell = segment->doorbell;
+        segment->waiting = 1;
+        __sync_synchronize();
+        bool empty = true;
+        for (size_t i = 0;i < peers.size(); ++i) {
+          empty = empty && peers[i]->inring.read_available() == 0;
+        }
+        if (empty && !done) {
+          // the timeout bounds the wait should a wake up be missed
+#ifdef __linux__
+          struct timespec timeout = {0, SEND_POLL_TIMEOUT * 1000};
+          syscall(SYS_futex, &segment->doorbell, FUTEX_WAIT, bell,
+                  &timeout, NULL, 0);
+#else
+          usleep(SEND_POLL_TIMEOUT / 10);
+#endif
+        }
+        segment->waiting = 0;
+        idle = 0;
+      }
+    }
+
+    void dc_shm_comm::send_loop() {
+      while(!done) {
+        bool pending = false;
+        for (size_t i = 0;i < peers.size(); ++i) {
+          peers[i]->triggered = false;
+          pending |= process_peer(*peers[i]);
+        }
+        send_lock.lock();
+        bool triggered = false;
+        for (size_t i = 0;i < peers.size(); ++i) {
+          triggered = triggered || peers[i]->triggered;
+        }
+        if (!triggered && !done) {
+          // retry soon when a ring was full
+          send_cond.timedwait_ms(send_lock, pending ? 1 : SEND_POLL_TIMEOUT / 1000);
+        }
+        send_lock.unlock();
+      }
+    }
+
+    void dc_shm_comm::close() {
+      if (is_closed) return;
+      logstream(LOG_INFO) << "Closing shared memory rings" << std::endl;
+      done = true;
+      send_lock.lock();
+      send_cond.signal();
+      send_lock.unlock();
+      segment->waiting = 1;
+      ring_doorbell(segment);
+      threads.join();
+      tcp.close();
+
+      for (size_t i = 0;i < peers.size(); ++i) {
+        munmap(peers[i]->outsegment, peers[i]->outsegment_size);
+        delete peers[i];
+      }
+      peers.clear();
+      munmap(segment, segment_size);
+      shm_unlink(segment_name.c_str());
+      delete null_sender;
+      is_closed = true;
+    }
+  }; // end of namespace dc_impl
+}; // end of namespace graphlab
@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef DC_SHM_COMM_HPP
+#define DC_SHM_COMM_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <map>
+
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/rpc/dc_types.hpp>
+#include <graphlab/rpc/dc_internal_types.hpp>
+#include <graphlab/rpc/dc_comm_base.hpp>
+#include <graphlab/rpc/dc_tcp_comm.hpp>
+#include <graphlab/rpc/shm_ring.hpp>
+#include <graphlab/rpc/circular_iovec_buffer.hpp>
+
+namespace graphlab {
+namespace dc_impl {
+
+/**
+ \ingroup rpc
+ \internal
+Communication subsystem for several processes per host. Data between
+processes on the same host goes through lock free rings in shared
+memory, and data to the other hosts through a dc_tcp_comm.
+
+Each process creates one shared memory segment holding a ring from
+every process on its host, including itself, and a doorbell on which
+its receiving thread sleeps when all the rings are empty. The segments
+are created before the TCP connections are established, and opened
+by the other processes of the host once they are.
+*/
+class dc_shm_comm:public dc_comm_base {
+ public:
+
+  inline dc_shm_comm() {
+    is_closed = true;
+  }
+
+  size_t capabilities() const {
+    return COMM_STREAM;
+  }
+
+  /**
+   * Returns the ids of the machines whose address resolves to the same
+   * host as machines[curmachineid], including curmachineid, in
+   * ascending order.
+   */
+  static std::vector<procid_t> colocated(const std::vector<std::string> &machines,
+                                         procid_t curmachineid);
+
+  /**
+   machines: a vector of strings where each string is of the form [IP]:[portnumber].
+             Machines with the same address use shared memory.
+   initopts: passed to dc_tcp_comm.
+  */
+  void init(const std::vector<std::string> &machines,
+            const std::map<std::string,std::string> &initopts,
+            procid_t curmachineid,
+            std::vector<dc_receive*> receiver,
+            std::vector<dc_send*> senders);
+
+  /** shuts down the rings and the TCP connections */
+  void close();
+
+  ~dc_shm_comm() {
+    close();
+  }
+
+  inline procid_t numprocs() const {
+    return tcp.numprocs();
+  }
+
+  inline procid_t procid() const {
+    return tcp.procid();
+  }
+
+  /// Returns the total number of bytes sent, over TCP and shared memory
+  inline size_t network_bytes_sent() const {
+    return tcp.network_bytes_sent() + shm_bytessent.value;
+  }
+
+  /// Returns the total number of bytes received, over TCP and shared memory
+  inline size_t network_bytes_received() const {
+    return tcp.network_bytes_received() + shm_bytesreceived.value;
+  }
+
+  inline size_t send_queue_length() const {
+    return tcp.send_queue_length() +
+        (buffered_len.value - shm_bytessent.value);
+  }
+
+  void trigger_send_timeout(procid_t target, bool urgent);
+
+ private:
+  /// The header of the shared memory segment of a process
+  struct segment_header {
+    uint64_t magic;
+    uint64_t nrings;
+    uint64_t ring_capacity;
+    /// Incremented and woken by the writers when waiting is set
+    volatile uint32_t doorbell;
+    /// Set by the reader before sleeping on the doorbell
+    volatile uint32_t waiting;
+    char pad[64 - 3 * sizeof(uint64_t) - 2 * sizeof(uint32_t)];
+  };
+
+  /// A process on this host
+  struct local_peer {
+    procid_t id;
+    /// The ring from this peer in the segment of this process
+    shm_ring inring;
+    /// The ring to this peer in its segment
+    shm_ring outring;
+    segment_header* outsegment;
+    size_t outsegment_size;
+    /// Data taken from the sender but not yet written to outring
+    circular_iovec_buffer outvec;
+    mutex m;
+    /// Whether a send to this peer was requested
+    volatile bool triggered;
+  };
+
+  dc_tcp_comm tcp;
+  bool is_closed;
+
+  std::vector<dc_receive*> receiver;
+  std::vector<dc_send*> sender;
+  /// Stands in for the senders of the local peers in tcp
+  dc_send* null_sender;
+
+  std::vector<local_peer*> peers;
+  /// peer_index[i] is the index in peers of machine i, or -1 if remote
+  std::vector<int> peer_index;
+
+  std::string segment_name;
+  segment_header* segment;
+  size_t segment_size;
+
+  atomic<size_t> buffered_len;
+  atomic<size_t> shm_bytessent;
+  atomic<size_t> shm_bytesreceived;
+
+  volatile bool done;
+  mutex send_lock;
+  conditional send_cond;
+  thread_group threads;
+
+  /// The name of the segment of the process listening on this address
+  static std::string get_segment_name(const std::string& machine);
+
+  /// Maps the segment of the peer, created by the peer, as its outring
+  void open_peer_segment(local_peer& peer, const std::string& name,
+                         size_t myslot);
+
+  /**
+   * Moves the data queued for the peer into its ring. Returns true if
+   * some of it did not fit.
+   */
+  bool process_peer(local_peer& peer);
+
+  /// Wakes the receiving thread of the process owning the segment
+  static void ring_doorbell(segment_header* seg);
+
+  /// Reads the rings of this process until closed
+  void receive_loop();
+  /// Flushes the triggered peers and periodically all of them
+  void send_loop();
+};
+
+} // namespace dc_impl
+} // namespace graphlab
+
+#endif
@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include <graphlab/rpc/dc.hpp>
 #include <graphlab/rpc/dc_internal_types.hpp>
 #include <graphlab/rpc/dc_stream_receive.hpp>
@@ -42,50 +43,51 @@ char* dc_stream_receive::get_buffer(size_t& retbuflength) {
 
 char* dc_stream_receive::advance_buffer(char* c, size_t wrotelength, 
                             size_t& retbuflength) {
-  // find the last complete message we have read
   write_buffer_written += wrotelength;
-  if (write_buffer_written >= sizeof(packet_hdr)) {
-    size_t offset = 0;
-    packet_hdr* hdr = reinterpret_cast<packet_hdr*>(writebuffer);
-    // keep pushing the header until I reach a point where there is insufficient
-    // room to read a header, or the message is not large enough
-    while(offset + sizeof(packet_hdr) <= write_buffer_written &&
-          offset + hdr->len + sizeof(packet_hdr) <= write_buffer_written) {
-      offset += hdr->len + sizeof(packet_hdr);
-      hdr = reinterpret_cast<packet_hdr*>(writebuffer + offset);
-    }
-
-    if (offset > 0) {
-      // ok. everything before the offset is good
-      // since we are going to give this buffer away, we need to prepare a new buffer
-
-      // allocate whatever it is going to take to hold next message
-      // have we read the incomplete message's header?
-      size_t incomplete_message_len = 0;
-      if (offset + sizeof(packet_hdr) <= write_buffer_written) incomplete_message_len = hdr->len;
+  // find the end of the last complete message we have read
+  size_t offset = write_buffer_start;
+  while(offset + sizeof(packet_hdr) <= write_buffer_written) {
+    packet_hdr* hdr = reinterpret_cast<packet_hdr*>(writebuffer + offset);
+    if (offset + sizeof(packet_hdr) + hdr->len > write_buffer_written) break;
+    offset += sizeof(packet_hdr) + hdr->len;
+  }
 
-      size_t new_buflen = std::max<size_t>(sizeof(packet_hdr) + incomplete_message_len, RECEIVE_BUFFER_SIZE);
-      char* new_writebuffer = (char*)malloc(new_buflen);
+  if (offset > write_buffer_start) {
+    // give the complete messages away to dc as a slice of the buffer.
+    // They are deserialized in place, and we keep receiving after them.
+    receive_buffer_pool::acquire(writebuffer);
+    dc->deferred_function_call_chunk(writebuffer,
+                                     writebuffer + write_buffer_start,
+                                     offset - write_buffer_start,
+                                     associated_proc);
+    write_buffer_start = offset;
+  }
 
-      if (write_buffer_len - offset > 0) {
-        // copy over to the new buffer everything we will not use
-        memcpy(new_writebuffer, writebuffer + offset, write_buffer_written - offset);
-      }
-      // if we reach here, we have an available block
-      // give away the buffer to dc
-      dc->deferred_function_call_chunk(writebuffer, offset, associated_proc);
-      writebuffer = new_writebuffer;
-      write_buffer_written -= offset;
-      write_buffer_len = new_buflen;
-    } else {
-      // nothing ready yet
-      // do we have enough room though?
-      if (hdr->len + sizeof(packet_hdr) > write_buffer_len) {
-        size_t newlen = hdr->len + sizeof(packet_hdr);
-        writebuffer = (char*)realloc(writebuffer, newlen);
-        write_buffer_len = newlen;
-      }
+  // how much room the incomplete message needs. Its length is only known
+  // once its header has been read.
+  size_t incomplete_message_len = sizeof(packet_hdr);
+  if (write_buffer_start + sizeof(packet_hdr) <= write_buffer_written) {
+    incomplete_message_len +=
+        reinterpret_cast<packet_hdr*>(writebuffer + write_buffer_start)->len;
+  }
+  // Move to a new buffer if the message will not fit, or if there is
+  // nothing pending and little room left. Only the bytes of the incomplete
+  // message are copied.
+  if (write_buffer_start + incomplete_message_len > write_buffer_len ||
+      (write_buffer_start == write_buffer_written &&
+       write_buffer_len - write_buffer_written < RECEIVE_BUFFER_SIZE / 8)) {
+    size_t pending = write_buffer_written - write_buffer_start;
+    size_t new_buflen = std::max<size_t>(incomplete_message_len,
+                                         RECEIVE_BUFFER_SIZE);
+    char* new_writebuffer = receive_buffer_pool::allocate(new_buflen);
+    if (pending > 0) {
+      memcpy(new_writebuffer, writebuffer + write_buffer_start, pending);
     }
+    receive_buffer_pool::release(writebuffer);
+    writebuffer = new_writebuffer;
+    write_buffer_start = 0;
+    write_buffer_written = pending;
+    write_buffer_len = new_buflen;
   }
   return get_buffer(retbuflength);
 }
@@ -29,6 +29,7 @@
 #include <graphlab/rpc/dc_types.hpp>
 #include <graphlab/rpc/dc_compile_parameters.hpp>
 #include <graphlab/rpc/dc_receive.hpp>
+#include <graphlab/rpc/receive_buffer_pool.hpp>
 #include <graphlab/parallel/atomic.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/logger/logger.hpp>
@@ -51,15 +52,24 @@ class dc_stream_receive: public dc_receive{
  public:
   
   dc_stream_receive(distributed_control* dc, procid_t associated_proc): 
-                  writebuffer(NULL), write_buffer_written(0), dc(dc), 
+                  writebuffer(NULL), write_buffer_start(0),
+                  write_buffer_written(0), dc(dc),
                   associated_proc(associated_proc) { 
-    writebuffer = (char*)malloc(RECEIVE_BUFFER_SIZE);
+    writebuffer = receive_buffer_pool::allocate(RECEIVE_BUFFER_SIZE);
     write_buffer_len = RECEIVE_BUFFER_SIZE;
   }
 
+  ~dc_stream_receive() {
+    receive_buffer_pool::release(writebuffer);
+  }
+
  private:
 
+  /// The buffer received into. Complete messages are dispatched as
+  /// slices of it, which share its reference count.
   char* writebuffer;
+  /// Start of the bytes which have not been dispatched yet
+  size_t write_buffer_start;
   size_t write_buffer_written;
   size_t write_buffer_len;
   
@@ -31,6 +31,9 @@
 #include <netinet/tcp.h>
 #include <ifaddrs.h>
 #include <poll.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <limits>
 #include <vector>
@@ -74,7 +77,16 @@ namespace graphlab {
       // insert machines into the address map
       all_addrs.resize(nprocs);
       portnums.resize(nprocs);
-      assert(triggered_timeouts.size() >= nprocs);
+      // tuning options
+      tcp_nodelay = true;
+      tcp_zerocopy = false;
+      std::map<std::string, std::string>::const_iterator opt =
+        initopts.find("tcp_nodelay");
+      if (opt != initopts.end()) tcp_nodelay = atoi(opt->second.c_str()) != 0;
+      opt = initopts.find("tcp_zerocopy");
+      if (opt != initopts.end()) tcp_zerocopy = atoi(opt->second.c_str()) != 0;
+
+      triggered_timeouts.resize(nprocs);
       triggered_timeouts.clear();
       // fill all the socks
       sock.resize(nprocs);
@@ -93,6 +105,9 @@ namespace graphlab {
         sock[i].data.msg_flags = 0;
         sock[i].data.msg_iovlen = 0;
         sock[i].data.msg_iov = NULL;
+        sock[i].zerocopy = false;
+        sock[i].zerocopy_sent = 0;
+        sock[i].zerocopy_completed = 0;
       }
 
       program_md5 = get_current_process_hash();
@@ -271,6 +286,10 @@ namespace graphlab {
           ::close(sock[i].outsock);
           sock[i].outsock = -1;
         }
+        while (!sock[i].zerocopy_pending.empty()) {
+          free(sock[i].zerocopy_pending.front().second);
+          sock[i].zerocopy_pending.pop_front();
+        }
       }
 
       // clear the inevent loop
@@ -300,7 +319,22 @@ namespace graphlab {
       BEGIN_TRACEPOINT(tcp_send_call);
       while(!sockinfo.outvec.empty()) {
         sockinfo.outvec.fill_msghdr(sockinfo.data);
-        ssize_t ret = sendmsg(sockinfo.outsock, &sockinfo.data, 0);
+        int flags = 0;
+#ifdef MSG_ZEROCOPY
+        if (sockinfo.zerocopy) {
+          size_t len = 0;
+          for (size_t i = 0;i < sockinfo.data.msg_iovlen; ++i) {
+            len += sockinfo.data.msg_iov[i].iov_len;
+          }
+          if (len >= ZEROCOPY_SEND_THRESHOLD) flags = MSG_ZEROCOPY;
+        }
+#endif
+        ssize_t ret = sendmsg(sockinfo.outsock, &sockinfo.data, flags);
+        if (ret < 0 && flags != 0 && errno == ENOBUFS) {
+          // the kernel cannot pin more pages for now. Copy instead.
+          flags = 0;
+          ret = sendmsg(sockinfo.outsock, &sockinfo.data, 0);
+        }
         if (ret < 0) {
           END_TRACEPOINT(tcp_send_call);
           if (errno == EWOULDBLOCK || errno == EAGAIN) {
@@ -317,12 +351,65 @@ namespace graphlab {
         logstream(LOG_INFO) << ret << " bytes --> " << sockinfo.id << std::endl;
 #endif
         network_bytessent.inc(ret);
-        sockinfo.outvec.sent(ret);
+        if (sockinfo.zerocopy) {
+          if (flags != 0) ++sockinfo.zerocopy_sent;
+          sockinfo.outvec.sent(ret, &sockinfo.retired);
+          retire_sent_buffers(sockinfo);
+        } else {
+          sockinfo.outvec.sent(ret);
+        }
       }
       END_TRACEPOINT(tcp_send_call);
       return true;
     }
 
+    void dc_tcp_comm::retire_sent_buffers(socket_info& sockinfo) {
+      for (size_t i = 0;i < sockinfo.retired.size(); ++i) {
+        if (sockinfo.zerocopy_sent == sockinfo.zerocopy_completed) {
+          free(sockinfo.retired[i]);
+        } else {
+          // conservatively wait for the last zero copy send issued
+          sockinfo.zerocopy_pending.push_back(
+              std::make_pair(sockinfo.zerocopy_sent - 1, sockinfo.retired[i]));
+        }
+      }
+      sockinfo.retired.clear();
+    }
+
+    void dc_tcp_comm::reap_zerocopy(socket_info& sockinfo) {
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+      if (sockinfo.zerocopy_pending.empty()) return;
+      // each notification reports the range of sends ee_info to ee_data.
+      // TCP completes them in order.
+      char control[256];
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      while(1) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sockinfo.outsock, &msg, MSG_ERRQUEUE) < 0) break;
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+          if (cm->cmsg_level != SOL_IP || cm->cmsg_type != IP_RECVERR) continue;
+          struct sock_extended_err* serr =
+            reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+          if (serr->ee_errno != 0 ||
+              serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+          uint32_t completed = serr->ee_data + 1;
+          if (int32_t(completed - sockinfo.zerocopy_completed) > 0) {
+            sockinfo.zerocopy_completed = completed;
+          }
+        }
+      }
+      while (!sockinfo.zerocopy_pending.empty() &&
+             int32_t(sockinfo.zerocopy_pending.front().first -
+                     sockinfo.zerocopy_completed) < 0) {
+        free(sockinfo.zerocopy_pending.front().second);
+        sockinfo.zerocopy_pending.pop_front();
+      }
+#endif
+    }
+
     int dc_tcp_comm::sendtosock(int sockfd, const char* buf, size_t len) {
       size_t numsent = 0;
       BEGIN_TRACEPOINT(tcp_send_call);
@@ -354,6 +441,21 @@ namespace graphlab {
       // set nonblocking
     }
 
+    bool dc_tcp_comm::set_zerocopy(int fd) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+      int flag = 1;
+      if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &flag, sizeof(int)) == 0) {
+        return true;
+      }
+      logstream(LOG_WARNING) << "Unable to set SO_ZEROCOPY: " << strerror(errno)
+                             << ". Sending with copies." << std::endl;
+#else
+      logstream(LOG_WARNING) << "MSG_ZEROCOPY is not supported on this platform."
+                             << " Sending with copies." << std::endl;
+#endif
+      return false;
+    }
+
     void dc_tcp_comm::set_non_blocking(int fd) {
       int flag = fcntl(fd, F_GETFL);
       if (flag < 0) {
@@ -420,7 +522,7 @@ namespace graphlab {
         return;
       } else {
         int newsock = socket(AF_INET, SOCK_STREAM, 0);
-        set_tcp_no_delay(newsock);
+        if (tcp_nodelay) set_tcp_no_delay(newsock);
         sockaddr_in serv_addr;
         serv_addr.sin_family = AF_INET;
         // set the target port
@@ -447,7 +549,7 @@ namespace graphlab {
                create a new socket before attempting to reconnect. */
             ::close(newsock);
             newsock = socket(AF_INET, SOCK_STREAM, 0);
-            set_tcp_no_delay(newsock);
+            if (tcp_nodelay) set_tcp_no_delay(newsock);
           } else {
             // send the initial message
             initial_message msg; 
@@ -463,6 +565,7 @@ namespace graphlab {
           logstream(LOG_FATAL) << "Failed to establish connection" << std::endl;
         }
         // remember the socket
+        if (tcp_zerocopy) sock[target].zerocopy = set_zerocopy(newsock);
         sock[target].outsock = newsock;
         logstream(LOG_INFO) << "connection from " << curid << " to " << target
                             << " established." << std::endl;
@@ -500,7 +603,7 @@ namespace graphlab {
             break;
           }
           // set the socket options and inform the
-          set_tcp_no_delay(newsock);
+          if (tcp_nodelay) set_tcp_no_delay(newsock);
           // before accepting the socket, get the machine number
           initial_message remote_message;
           ssize_t msglen = 0;
@@ -605,6 +708,7 @@ namespace graphlab {
       if (sockinfo->m.try_lock()) {
         dc_tcp_comm* comm = sockinfo->owner;
         // get a direct pointer to my receiver
+        if (sockinfo->zerocopy) comm->reap_zerocopy(*sockinfo);
         if (sockinfo->wouldblock == false) {
           comm->check_for_new_data(*sockinfo);
           if (!sockinfo->outvec.empty()) {
@@ -28,6 +28,7 @@
 #include <netinet/in.h>
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <map>
 
@@ -80,7 +81,8 @@ class dc_tcp_comm:public dc_comm_base {
    attached receiver
 
    machines: a vector of strings where each string is of the form [IP]:[portnumber]
-   initopts: unused
+   initopts: tcp_nodelay=0 leaves Nagle's algorithm enabled.
+             tcp_zerocopy=1 sends large buffers with MSG_ZEROCOPY.
    curmachineid: The ID of the current machine. machines[curmachineid] will be
                  the listening address of this machine
 
@@ -153,6 +155,9 @@ class dc_tcp_comm:public dc_comm_base {
   /// Sets TCP_NO_DELAY on the socket passed in fd
   void set_tcp_no_delay(int fd);
 
+  /// Sets SO_ZEROCOPY on the socket passed in fd. Returns false on failure
+  bool set_zerocopy(int fd);
+
   void set_non_blocking(int fd);
 
   /// called when listener receives an incoming socket request
@@ -179,6 +184,9 @@ class dc_tcp_comm:public dc_comm_base {
   procid_t nprocs;  /// number of processors
   bool is_closed;   /// whether this socket is closed
 
+  bool tcp_nodelay;   /// whether Nagle's algorithm is disabled
+  bool tcp_zerocopy;  /// whether large sends use MSG_ZEROCOPY
+
   std::string program_md5;  /// MD5 hash of current program
 
 
@@ -212,6 +220,16 @@ class dc_tcp_comm:public dc_comm_base {
 
     circular_iovec_buffer outvec;  /// outgoing data
     struct msghdr data;
+
+    bool zerocopy;  /// whether SO_ZEROCOPY is set on outsock
+    /// Number of sends issued and completed with MSG_ZEROCOPY. The
+    /// kernel numbers them from 0 and may wrap around.
+    uint32_t zerocopy_sent;
+    uint32_t zerocopy_completed;
+    /// Sent buffers which the kernel may still be reading, with the
+    /// number of the last zero copy send which could have read them
+    std::deque<std::pair<uint32_t, void*> > zerocopy_pending;
+    std::vector<void*> retired;
   };
 
   mutex insock_lock; /// locks the insock field in socket_info
@@ -232,6 +250,10 @@ class dc_tcp_comm:public dc_comm_base {
    */
   void send_all(socket_info& sockinfo);
   bool send_till_block(socket_info& sockinfo);
+  /// Frees buffers which were completely sent, once the kernel is done
+  void retire_sent_buffers(socket_info& sockinfo);
+  /// Reads the completed zero copy sends and frees their buffers
+  void reap_zerocopy(socket_info& sockinfo);
   void check_for_new_data(socket_info& sockinfo);
   void construct_events();
 
@@ -260,7 +282,7 @@ class dc_tcp_comm:public dc_comm_base {
   timeout_event send_triggered_timeout;
   timeout_event send_all_timeout;
 
-  fixed_dense_bitset<256> triggered_timeouts;
+  dense_bitset triggered_timeouts;
   ////////////       Listening Sockets     //////////////////////
   int listensock;
   thread listenthread;
@@ -0,0 +1,310 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_RPC_EXCHANGE_COMPRESSION_HPP
+#define GRAPHLAB_RPC_EXCHANGE_COMPRESSION_HPP
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/rpc/dc_dist_object.hpp>
+#include <graphlab/parallel/atomic.hpp>
+
+namespace graphlab {
+
+  /**
+   * \ingroup rpc
+   * When the blocks of graphlab::buffered_exchange and
+   * graphlab::fiber_buffered_exchange are compressed.
+   */
+  enum exchange_compression_mode {
+    /// Blocks are sent as they are
+    EXCHANGE_COMPRESSION_OFF,
+    /// Every large enough block is compressed
+    EXCHANGE_COMPRESSION_ON,
+    /// Blocks are compressed while the network falls behind, that is
+    /// while more than EXCHANGE_COMPRESSION_BACKLOG bytes wait in the
+    /// socket send queues.
+    EXCHANGE_COMPRESSION_ADAPTIVE
+  };
+
+namespace dc_impl {
+
+  /**
+   * \internal
+   * \ingroup rpc
+   * A compression codec for exchange blocks.
+   */
+  class exchange_codec {
+   public:
+    virtual ~exchange_codec() { }
+
+    /// An upper bound on the compressed size of len bytes
+    virtual size_t max_compressed_size(size_t len) const = 0;
+
+    /**
+     * Compresses len bytes from src into dst, which has room for
+     * max_compressed_size(len) bytes. Returns the compressed size.
+     */
+    virtual size_t compress(const char* src, size_t len, char* dst) const = 0;
+
+    /**
+     * Decompresses len bytes from src into exactly dstlen bytes at dst.
+     * Returns false if the data is corrupt.
+     */
+    virtual bool decompress(const char* src, size_t len,
+                            char* dst, size_t dstlen) const = 0;
+  };
+
+
+  /**
+   * \internal
+   * \ingroup rpc
+   * A fast LZ77 codec in the spirit of LZ4. It finds the repeats of 4
+   * bytes or more within the last 64KB with a hash table, and does well
+   * on the repeated values and high id bytes of exchange blocks.
+   *
+   * The output is a sequence of runs, each a token byte holding the
+   * number of literals (high 4 bits) and the match length - 4 (low 4
+   * bits), then the literals, then the 2 byte offset of the match. A
+   * count of 15 continues in the following bytes, 255 at a time. The
+   * last run has no match.
+   */
+  class lz_exchange_codec: public exchange_codec {
+   public:
+    size_t max_compressed_size(size_t len) const {
+      return len + len / 255 + 16;
+    }
+
+    size_t compress(const char* src, size_t len, char* dst) const {
+      const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+      unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+      uint32_t table[HASH_SIZE];
+      memset(table, 0, sizeof(table));
+      size_t anchor = 0, pos = 0;
+      while (pos + MIN_MATCH <= len) {
+        const uint32_t h = hash(in + pos);
+        const size_t candidate = table[h];
+        table[h] = uint32_t(pos);
+        if (candidate >= pos || pos - candidate > MAX_OFFSET ||
+            memcmp(in + candidate, in + pos, MIN_MATCH) != 0) {
+          ++pos;
+          continue;
+        }
+        size_t matchlen = MIN_MATCH;
+        while (pos + matchlen < len &&
+               in[candidate + matchlen] == in[pos + matchlen]) ++matchlen;
+        out = write_run(out, in + anchor, pos - anchor, matchlen - MIN_MATCH);
+        const size_t offset = pos - candidate;
+        *out++ = (unsigned char)(offset & 0xff);
+        *out++ = (unsigned char)(offset >> 8);
+        out = write_count(out, matchlen - MIN_MATCH);
+        pos += matchlen;
+        anchor = pos;
+      }
+      out = write_run(out, in + anchor, len - anchor, 0);
+      return out - reinterpret_cast<unsigned char*>(dst);
+    }
+
+    bool decompress(const char* src, size_t len,
+                    char* dst, size_t dstlen) const {
+      const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+      const unsigned char* end = in + len;
+      unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+      size_t written = 0;
+      while (1) {
+        // every run but the last ends with a match
+        if (in == end) return false;
+        const unsigned char token = *in++;
+        size_t nliterals = token >> 4;
+        if (nliterals == 15 && !read_count(in, end, nliterals)) return false;
+        if (size_t(end - in) < nliterals || dstlen - written < nliterals) {
+          return false;
+        }
+        memcpy(out + written, in, nliterals);
+        in += nliterals;
+        written += nliterals;
+        if (in == end) return written == dstlen;
+        if (end - in < 2) return false;
+        const size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+        in += 2;
+        size_t matchlen = token & 15;
+        if (matchlen == 15 && !read_count(in, end, matchlen)) return false;
+        matchlen += MIN_MATCH;
+        if (offset == 0 || offset > written || dstlen - written < matchlen) {
+          return false;
+        }
+        // the match may overlap the bytes it produces
+        const unsigned char* from = out + written - offset;
+        for (size_t i = 0; i < matchlen; ++i) out[written + i] = from[i];
+        written += matchlen;
+      }
+    }
+
+   private:
+    static const size_t MIN_MATCH = 4;
+    static const size_t MAX_OFFSET = 65535;
+    static const size_t HASH_BITS = 13;
+    static const size_t HASH_SIZE = 1 << HASH_BITS;
+
+    static inline uint32_t hash(const unsigned char* p) {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      return (v * 2654435761U) >> (32 - HASH_BITS);
+    }
+
+    static inline unsigned char* write_count(unsigned char* out, size_t count) {
+      if (count < 15) return out;
+      for (count -= 15; count >= 255; count -= 255) *out++ = 255;
+      *out++ = (unsigned char)count;
+      return out;
+    }
+
+    static inline unsigned char* write_run(unsigned char* out,
+                                           const unsigned char* literals,
+                                           size_t nliterals, size_t matchcount) {
+      *out++ = (unsigned char)((std::min<size_t>(nliterals, 15) << 4) |
+                               std::min<size_t>(matchcount, 15));
+      out = write_count(out, nliterals);
+      memcpy(out, literals, nliterals);
+      return out + nliterals;
+    }
+
+    static inline bool read_count(const unsigned char*& in,
+                                  const unsigned char* end, size_t& count) {
+      unsigned char c;
+      do {
+        if (in == end) return false;
+        c = *in++;
+        count += c;
+      } while (c == 255);
+      return true;
+    }
+  }; // end of lz_exchange_codec
+
+
+  /**
+   * \internal
+   * \ingroup rpc
+   * Compresses the blocks of an exchange. The compressed block is sent as
+   * a split call to a separate handler, which restores the block and
+   * passes it on to the usual one:
+   * \code
+   *   void rpc_recv_compressed(size_t len, wild_pointer w) {
+   *     char* block; size_t blocklen;
+   *     compressor.decompress(len, w, block, blocklen);
+   *     wild_pointer blockptr; blockptr.ptr = block;
+   *     rpc_recv(blocklen, blockptr);
+   *     free(block);
+   *   }
+   * \endcode
+   *
+   * In the adaptive mode, the compression is also suspended for a while
+   * after a block which did not shrink by at least 1/8.
+   */
+  class exchange_compressor {
+   public:
+    explicit exchange_compressor(
+        exchange_compression_mode mode = EXCHANGE_COMPRESSION_ADAPTIVE,
+        const exchange_codec* codec = NULL) :
+      mode(mode), codec(codec == NULL ? &default_codec() : codec),
+      skip_blocks(0) { }
+
+    void set_mode(exchange_compression_mode newmode) { mode = newmode; }
+
+    /// Uses codec, which must be the same on all machines, from now on
+    void set_codec(const exchange_codec* newcodec) { codec = newcodec; }
+
+    /**
+     * Returns the split call to send in place of oarc, which is either
+     * oarc, or a split call to compressed_handler carrying the compressed
+     * block. In the latter case oarc is cancelled.
+     */
+    template <typename T>
+    oarchive* compress(dc_dist_object<T>& rpc, oarchive* oarc,
+                       void (T::*compressed_handler)(size_t, wild_pointer)) {
+      // the block follows the size_t which split_call_end fills in
+      const size_t begin = *reinterpret_cast<size_t*>(oarc->buf) + sizeof(size_t);
+      const size_t len = oarc->off - begin;
+      if (!should_compress(rpc.dc(), len)) return oarc;
+
+      oarchive* comparc = rpc.split_call_begin(compressed_handler);
+      (*comparc) << len;
+      comparc->expand_buf(codec->max_compressed_size(len));
+      const size_t complen = codec->compress(oarc->buf + begin, len,
+                                             comparc->buf + comparc->off);
+      comparc->off += complen;
+      if (complen + complen / 8 > len) {
+        // not worth it. Send the original and back off when adapting
+        if (mode == EXCHANGE_COMPRESSION_ADAPTIVE) skip_blocks.value = SKIP_BLOCKS;
+        rpc.split_call_cancel(comparc);
+        return oarc;
+      }
+      rpc.split_call_cancel(oarc);
+      return comparc;
+    }
+
+    /**
+     * Decompresses the contents of a call to the compressed handler into
+     * a new buffer, to be freed by the caller.
+     */
+    void decompress(size_t len, wild_pointer w,
+                    char*& block, size_t& blocklen) const {
+      iarchive iarc(reinterpret_cast<const char*>(w.ptr), len);
+      iarc >> blocklen;
+      block = reinterpret_cast<char*>(malloc(blocklen));
+      if (!codec->decompress(reinterpret_cast<const char*>(w.ptr) + iarc.off,
+                             len - iarc.off, block, blocklen)) {
+        logstream(LOG_FATAL) << "Corrupt compressed exchange block" << std::endl;
+      }
+    }
+
+   private:
+    /// Blocks smaller than this are sent as they are
+    static const size_t MIN_BLOCK_SIZE = 1024;
+    /// The number of blocks sent as they are after one which did not shrink
+    static const int SKIP_BLOCKS = 64;
+
+    exchange_compression_mode mode;
+    const exchange_codec* codec;
+    /// Shared by the sending threads. Races only shift the adaptation.
+    atomic<int> skip_blocks;
+
+    bool should_compress(distributed_control& dc, size_t len) {
+      if (mode == EXCHANGE_COMPRESSION_OFF || len < MIN_BLOCK_SIZE) return false;
+      if (mode == EXCHANGE_COMPRESSION_ON) return true;
+      if (skip_blocks.value > 0 && skip_blocks.dec() >= 0) return false;
+      return dc.send_queue_length() >= EXCHANGE_COMPRESSION_BACKLOG;
+    }
+
+    static const exchange_codec& default_codec() {
+      static lz_exchange_codec codec;
+      return codec;
+    }
+  }; // end of exchange_compressor
+
+} // namespace dc_impl
+} // namespace graphlab
+#endif
@@ -24,10 +24,12 @@
 #ifndef GRAPHLAB_FIBER_BUFFERED_EXCHANGE_HPP
 #define GRAPHLAB_FIBER_BUFFERED_EXCHANGE_HPP
 
+#include <boost/function.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/parallel/fiber_control.hpp>
 #include <graphlab/rpc/dc.hpp>
 #include <graphlab/rpc/dc_dist_object.hpp>
+#include <graphlab/rpc/exchange_compression.hpp>
 #include <graphlab/util/mpi_tools.hpp>
 
 
@@ -114,6 +116,10 @@ namespace graphlab {
     std::vector<std::vector<send_record> > send_buffers;
     const size_t max_buffer_size;
 
+    dc_impl::exchange_compressor compressor;
+
+    boost::function<void(void)> recv_callback;
+
 
     /**
      * Flushes the send buffer local to worker id "wid" and going to process proc
@@ -122,7 +128,9 @@ namespace graphlab {
       if(send_buffers[wid][proc].oarc) {
         // write the length at the end of the buffere are returning
         send_buffers[wid][proc].oarc->write(reinterpret_cast<char*>(&send_buffers[wid][proc].numinserts), sizeof(size_t));
-        rpc.split_call_end(proc, send_buffers[wid][proc].oarc);
+        rpc.split_call_end(proc, compressor.compress(
+            rpc, send_buffers[wid][proc].oarc,
+            &fiber_buffered_exchange::rpc_recv_compressed));
 //         logstream(LOG_DEBUG) << rpc.procid() << ": Sending exchange of length " 
 //                              << send_buffers[wid][proc].oarc->off << " to " 
 //                              << proc << std::endl;
@@ -283,7 +291,39 @@ namespace graphlab {
     void clear() { }
 
     void barrier() { rpc.barrier(); }
+
+    /**
+     * Sets a function called after each block is received, for instance
+     * to wake up the fibers receiving them.
+     */
+    void set_recv_callback(const boost::function<void(void)>& callback) {
+      recv_callback = callback;
+    }
+
+    /**
+     * Sets when the blocks sent are compressed. Defaults to
+     * EXCHANGE_COMPRESSION_ADAPTIVE.
+     */
+    void set_compression(exchange_compression_mode mode) {
+      compressor.set_mode(mode);
+    }
+
+    /**
+     * Compresses the blocks with codec, which must outlive the exchange
+     * and be used by all machines.
+     */
+    void set_compression_codec(const dc_impl::exchange_codec* codec) {
+      compressor.set_codec(codec);
+    }
   private:
+    void rpc_recv_compressed(size_t len, wild_pointer w) {
+      char* block; size_t blocklen;
+      compressor.decompress(len, w, block, blocklen);
+      wild_pointer blockptr; blockptr.ptr = block;
+      rpc_recv(blocklen, blockptr);
+      free(block);
+    } // end of rpc recv compressed
+
     void rpc_recv(size_t len, wild_pointer w) {
       buffer_type tmp;
       iarchive iarc(reinterpret_cast<const char*>(w.ptr), len);
@@ -310,6 +350,7 @@ namespace graphlab {
       rec.proc = src_proc;
       rec.buffer.swap(tmp);
       lock.unlock();
+      if (recv_callback) recv_callback();
     } // end of rpc rcv
 
 
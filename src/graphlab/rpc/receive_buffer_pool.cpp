@@ -0,0 +1,95 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#include <cstdlib>
+#include <vector>
+#include <graphlab/rpc/dc_compile_parameters.hpp>
+#include <graphlab/rpc/receive_buffer_pool.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/logger/assertions.hpp>
+
+namespace graphlab {
+namespace dc_impl {
+
+namespace {
+  /// Precedes the bytes of each buffer, keeping the alignment of malloc
+  struct buffer_header {
+    atomic<size_t> refcount;
+    size_t len;
+  };
+
+  inline buffer_header* header_of(char* buf) {
+    return reinterpret_cast<buffer_header*>(buf - sizeof(buffer_header));
+  }
+
+  mutex pool_lock;
+  std::vector<char*> pool;
+} // anonymous namespace
+
+
+char* receive_buffer_pool::allocate(size_t len) {
+  char* buf = NULL;
+  if (len <= RECEIVE_BUFFER_SIZE) {
+    len = RECEIVE_BUFFER_SIZE;
+    pool_lock.lock();
+    if (!pool.empty()) {
+      buf = pool.back();
+      pool.pop_back();
+    }
+    pool_lock.unlock();
+  }
+  if (buf == NULL) {
+    buffer_header* hdr =
+        reinterpret_cast<buffer_header*>(malloc(sizeof(buffer_header) + len));
+    ASSERT_TRUE(hdr != NULL);
+    hdr->len = len;
+    buf = reinterpret_cast<char*>(hdr) + sizeof(buffer_header);
+  }
+  header_of(buf)->refcount.value = 1;
+  return buf;
+}
+
+
+void receive_buffer_pool::acquire(char* buf) {
+  header_of(buf)->refcount.inc();
+}
+
+
+void receive_buffer_pool::release(char* buf) {
+  buffer_header* hdr = header_of(buf);
+  if (hdr->refcount.dec() > 0) return;
+  if (hdr->len == RECEIVE_BUFFER_SIZE) {
+    pool_lock.lock();
+    if (pool.size() < RECEIVE_BUFFER_POOL_SIZE) {
+      pool.push_back(buf);
+      buf = NULL;
+    }
+    pool_lock.unlock();
+  }
+  if (buf != NULL) free(hdr);
+}
+
+} // namespace dc_impl
+} // namespace graphlab
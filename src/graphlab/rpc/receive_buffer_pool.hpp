@@ -0,0 +1,56 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_RPC_RECEIVE_BUFFER_POOL_HPP
+#define GRAPHLAB_RPC_RECEIVE_BUFFER_POOL_HPP
+#include <cstddef>
+namespace graphlab {
+namespace dc_impl {
+
+/**
+ * \ingroup rpc
+ * \internal
+ * Reference counted receive buffers.
+ *
+ * The receiver recv()s into a buffer and hands the complete messages to
+ * the RPC handlers as slices of it, which are deserialized in place. Each
+ * slice holds a reference on the buffer, as does the receiver while it
+ * writes into the rest of the buffer. The buffer is returned to the pool
+ * by the last release(). Only buffers of RECEIVE_BUFFER_SIZE bytes are
+ * pooled; larger ones hold a single large message and are freed.
+ */
+struct receive_buffer_pool {
+  /// Returns a buffer of at least len bytes with a reference count of 1
+  static char* allocate(size_t len);
+
+  /// Adds a reference to a buffer returned by allocate
+  static void acquire(char* buf);
+
+  /// Drops a reference, recycling or freeing the buffer on the last one
+  static void release(char* buf);
+};
+
+} // namespace dc_impl
+} // namespace graphlab
+#endif
@@ -27,9 +27,15 @@
 
 namespace graphlab {
 
+bool dc_impl::ireply_container::track_issue_time = false;
+
 void request_reply_handler(distributed_control &dc, procid_t src, 
                            size_t ptr, dc_impl::blob ret) {
   dc_impl::ireply_container* a = reinterpret_cast<dc_impl::ireply_container*>(ptr);
+  // the container may be freed as soon as it receives
+  if (dc.get_rpc_stats() != NULL) {
+    dc.get_rpc_stats()->record_round_trip(src, rdtsc() - a->issue_time);
+  }
   a->receive(src, ret);
 }
 
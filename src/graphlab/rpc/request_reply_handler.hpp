@@ -27,6 +27,7 @@
 #include <graphlab/parallel/atomic.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/rpc/dc_internal_types.hpp>
+#include <graphlab/util/timer.hpp>
 namespace graphlab {
 
 class distributed_control;
@@ -81,7 +82,12 @@ struct blob {
  * Abstract class for where the result of a request go into.
  */
 struct ireply_container {
-  ireply_container() { }
+  /// When the request was issued, in rdtsc cycles. Only taken when
+  /// track_issue_time is set
+  unsigned long long issue_time;
+  /// Set by distributed_control while the rpc_stats option is on
+  static bool track_issue_time;
+  ireply_container(): issue_time(track_issue_time ? rdtsc() : 0) { }
   virtual ~ireply_container() { }
   virtual void wait() = 0;
   virtual void receive(procid_t source, blob b) = 0;
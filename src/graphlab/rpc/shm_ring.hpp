@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_RPC_SHM_RING_HPP
+#define GRAPHLAB_RPC_SHM_RING_HPP
+
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <graphlab/logger/assertions.hpp>
+
+namespace graphlab {
+namespace dc_impl {
+
+/**
+ * \ingroup rpc
+ * \internal
+ * A lock free ring of bytes with a single writer and a single reader,
+ * which may be in different processes sharing the memory. The ring
+ * only holds positions and data, so it can be placed in shared memory
+ * as is. The positions count all the bytes ever written and read, and
+ * are on separate cache lines.
+ */
+class shm_ring {
+ public:
+  struct header {
+    /// Bytes written. Only changed by the writer
+    volatile uint64_t head;
+    char pad0[64 - sizeof(uint64_t)];
+    /// Bytes read. Only changed by the reader
+    volatile uint64_t tail;
+    char pad1[64 - sizeof(uint64_t)];
+  };
+
+  /// The bytes of shared memory taken by a ring of this capacity
+  static size_t memory_size(size_t capacity) {
+    return sizeof(header) + capacity;
+  }
+
+  shm_ring() : hdr(NULL), data(NULL), capacity(0) { }
+
+  /**
+   * Uses the memory_size(capacity) bytes at mem, which must be zeroed
+   * before either side first attaches. capacity must be a power of 2.
+   */
+  void attach(void* mem, size_t capacity_) {
+    ASSERT_EQ(capacity_ & (capacity_ - 1), 0);
+    hdr = reinterpret_cast<header*>(mem);
+    data = reinterpret_cast<char*>(mem) + sizeof(header);
+    capacity = capacity_;
+  }
+
+  /// Writes up to len bytes. Returns the number written.
+  size_t write(const char* buf, size_t len) {
+    const uint64_t head = hdr->head;
+    const uint64_t tail = hdr->tail;
+    // the reads of tail must complete before overwriting the space
+    __sync_synchronize();
+    const size_t n = std::min<size_t>(len, capacity - (head - tail));
+    if (n == 0) return 0;
+    const size_t pos = head & (capacity - 1);
+    const size_t first = std::min(n, capacity - pos);
+    memcpy(data + pos, buf, first);
+    memcpy(data, buf + first, n - first);
+    // the data must be visible before the new head
+    __sync_synchronize();
+    hdr->head = head + n;
+    return n;
+  }
+
+  /// Reads up to len bytes. Returns the number read.
+  size_t read(char* buf, size_t len) {
+    const uint64_t tail = hdr->tail;
+    const uint64_t head = hdr->head;
+    // the data must not be read before the head
+    __sync_synchronize();
+    const size_t n = std::min<size_t>(len, head - tail);
+    if (n == 0) return 0;
+    const size_t pos = tail & (capacity - 1);
+    const size_t first = std::min(n, capacity - pos);
+    memcpy(buf, data + pos, first);
+    memcpy(buf + first, data, n - first);
+    // the data must be read before the writer may reuse the space
+    __sync_synchronize();
+    hdr->tail = tail + n;
+    return n;
+  }
+
+  /// Number of bytes which can be read
+  size_t read_available() const {
+    return hdr->head - hdr->tail;
+  }
+
+ private:
+  header* hdr;
+  char* data;
+  size_t capacity;
+};
+
+} // namespace dc_impl
+} // namespace graphlab
+#endif
@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <cmath>
+#include <limits>
+#include <graphlab/parallel/fiber_control.hpp>
+#include <graphlab/scheduler/bucket_scheduler.hpp>
+
+#include <graphlab/macros_def.hpp>
+namespace graphlab {
+
+const int64_t bucket_scheduler::NO_BUCKET;
+
+void bucket_scheduler::set_options(const graphlab_options& opts) {
+  ncpus = opts.get_ncpus();
+  std::vector<std::string> keys = opts.get_scheduler_args().get_option_keys();
+  foreach(std::string opt, keys) {
+    if (opt == "delta") {
+      opts.get_scheduler_args().get_option("delta", delta);
+      if (!(delta > 0)) {
+        logstream(LOG_FATAL) << "delta must be positive" << std::endl;
+      }
+    } else if (opt == "sync") {
+      opts.get_scheduler_args().get_option("sync", sync);
+    } else {
+      logstream(LOG_FATAL) << "Unexpected Scheduler Option: " << opt << std::endl;
+    }
+  }
+}
+
+// Initializes the internal datastructures
+void bucket_scheduler::initialize_data_structures() {
+  shards.resize(ncpus);
+  locks.resize(ncpus);
+  vertex_bucket.resize(num_vertices, NO_BUCKET);
+}
+
+bucket_scheduler::bucket_scheduler(size_t num_vertices,
+                                   const graphlab_options& opts):
+    current_bucket(std::numeric_limits<int64_t>::min()), delta(1.0), sync(true),
+    num_vertices(num_vertices) {
+  ASSERT_GE(opts.get_ncpus(), 1);
+  set_options(opts);
+  initialize_data_structures();
+}
+
+void bucket_scheduler::set_num_vertices(const lvid_type numv) {
+  num_vertices = numv;
+  vertex_bucket.resize(numv, NO_BUCKET);
+}
+
+int64_t bucket_scheduler::bucket_of(double priority) const {
+  // small enough for the rounds to hold the buckets exactly as doubles
+  const double limit = double(int64_t(1) << 52);
+  const double b = std::floor(-priority / delta);
+  if (b != b) return 0;
+  return int64_t(std::max(-limit, std::min(b, limit)));
+}
+
+int64_t bucket_scheduler::lowest_bucket() const {
+  int64_t lowest = NO_BUCKET;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    lowest = std::min(lowest, int64_t(shards[i].min_bucket));
+  }
+  return lowest;
+}
+
+void bucket_scheduler::schedule(const lvid_type vid, double priority) {
+  if (vid >= num_vertices) return;
+  const int64_t b = bucket_of(priority);
+  // only move a vertex to a lower bucket
+  while(1) {
+    const int64_t old = vertex_bucket[vid];
+    if (b >= old) return;
+    if (__sync_bool_compare_and_swap(&vertex_bucket[vid], old, b)) break;
+  }
+  const size_t workerid = fiber_control::get_worker_id();
+  const size_t idx = workerid < shards.size() ? workerid :
+      random::fast_uniform(size_t(0), shards.size() - 1);
+  locks[idx].lock();
+  shards[idx].buckets[b].push_back(vid);
+  if (b < shards[idx].min_bucket) shards[idx].min_bucket = b;
+  locks[idx].unlock();
+}
+
+bool bucket_scheduler::pop_from(size_t idx, lvid_type& ret_vid) {
+  shard_type& shard = shards[idx];
+  bool good = false;
+  locks[idx].lock();
+  while (!good && shard.min_bucket <= current_bucket) {
+    std::map<int64_t, std::vector<lvid_type> >::iterator it =
+        shard.buckets.begin();
+    const int64_t b = it->first;
+    ret_vid = it->second.back();
+    it->second.pop_back();
+    if (it->second.empty()) {
+      shard.buckets.erase(it);
+      shard.min_bucket = shard.buckets.empty() ?
+          NO_BUCKET : shard.buckets.begin()->first;
+    }
+    // skip the entries of vertices which were moved to a lower bucket
+    // or already popped
+    good = ret_vid < num_vertices &&
+        __sync_bool_compare_and_swap(&vertex_bucket[ret_vid], b, NO_BUCKET);
+  }
+  locks[idx].unlock();
+  return good;
+}
+
+/** Get the next element in the queue */
+sched_status::status_enum bucket_scheduler::get_next(const size_t cpuid,
+                                                     lvid_type& ret_vid) {
+  const size_t home = cpuid % shards.size();
+  while(1) {
+    for (size_t i = 0; i < shards.size(); ++i) {
+      const size_t idx = (home + i) % shards.size();
+      if (shards[idx].min_bucket > current_bucket) continue;
+      if (pop_from(idx, ret_vid)) return sched_status::NEW_TASK;
+    }
+    if (sync) return sched_status::EMPTY;
+    // advance to the lowest bucket held on this machine
+    const int64_t lowest = lowest_bucket();
+    if (lowest == NO_BUCKET) return sched_status::EMPTY;
+    int64_t cur = current_bucket;
+    while (cur < lowest &&
+           !__sync_bool_compare_and_swap(&current_bucket, cur, lowest)) {
+      cur = current_bucket;
+    }
+  }
+} // end of get_next_task
+
+bool bucket_scheduler::empty() {
+  return lowest_bucket() == NO_BUCKET;
+}
+
+bool bucket_scheduler::next_round(double& round) {
+  const int64_t lowest = lowest_bucket();
+  if (lowest == NO_BUCKET) return false;
+  round = double(lowest);
+  return true;
+}
+
+void bucket_scheduler::start_round(double round) {
+  current_bucket = std::max(int64_t(current_bucket), int64_t(round));
+}
+
+} // end of namespace graphlab
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_BUCKET_SCHEDULER_HPP
+#define GRAPHLAB_BUCKET_SCHEDULER_HPP
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
+
+#include <graphlab/util/random.hpp>
+#include <graphlab/scheduler/ischeduler.hpp>
+
+#include <graphlab/options/graphlab_options.hpp>
+
+namespace graphlab {
+
+  /**
+   * \ingroup group_schedulers
+   *
+   * A delta-stepping scheduler. The priority of a vertex is quantized
+   * into buckets of width delta, bucket floor(-priority / delta), and
+   * the vertices of the lowest buckets run first in no particular order.
+   * Programs such as SSSP which use the negated distance as the priority
+   * thus relax the vertices within delta of the frontier together, and
+   * avoid most of the relaxations FIFO order wastes on long paths.
+   *
+   * Vertices are held in buckets up to a current bucket, which is only
+   * advanced once every bucket up to it is drained. With sync=1 (the
+   * default) the advance is global: the engine waits for the termination
+   * consensus, which sees every machine idle and no messages in flight,
+   * and then opens the lowest bucket held on any machine (see
+   * ischeduler::next_round()). With sync=0 each machine advances on its
+   * own as soon as it is locally out of work.
+   *
+   * The global advance is expensive: every bucket costs a full termination
+   * consensus, an all_reduce, a barrier and a relaunch of all the nfibers
+   * fibers of the engine. With the default delta=1 on a weighted graph
+   * there can be thousands of buckets, so either use a delta of the order
+   * of the typical edge weight or set sync=0.
+   *
+   * Scheduling a vertex which is already scheduled moves it to the new
+   * bucket if that is lower, and is otherwise ignored.
+   */
+  class bucket_scheduler : public ischeduler {
+
+  private:
+    // the bucket of a vertex which is not scheduled
+    static const int64_t NO_BUCKET = 0x7fffffffffffffffLL;
+
+    struct shard_type {
+      // the vertices of each bucket
+      std::map<int64_t, std::vector<lvid_type> > buckets;
+      // the lowest bucket held, or NO_BUCKET. Only written while
+      // holding the lock, and read without it.
+      volatile int64_t min_bucket;
+      char pad[64 - sizeof(std::map<int64_t, std::vector<lvid_type> >) -
+               sizeof(int64_t)];
+      shard_type() : min_bucket(NO_BUCKET) { }
+    };
+
+    // the bucket each vertex is scheduled in, or NO_BUCKET. Entries of
+    // the shards with another bucket are stale.
+    std::vector<int64_t> vertex_bucket;
+    // the buckets, split into shards to reduce contention
+    std::vector<shard_type> shards;
+    // a parallel datastructure to shards containing all the locks
+    std::vector<padded_simple_spinlock> locks;
+    // the buckets up to this one may be run
+    volatile int64_t current_bucket;
+
+    // the number of CPUs
+    size_t ncpus;
+    // the width of a bucket
+    double delta;
+    // whether the buckets are advanced across machines together
+    bool sync;
+    // the number of vertices in the graph
+    size_t num_vertices;
+
+    void set_options(const graphlab_options& opts);
+
+    // Initializes the internal datastructures
+    void initialize_data_structures();
+
+    int64_t bucket_of(double priority) const;
+
+    // the lowest bucket held by any shard, or NO_BUCKET
+    int64_t lowest_bucket() const;
+
+    // pops a vertex of a bucket up to current_bucket from the shard
+    bool pop_from(size_t idx, lvid_type& ret_vid);
+
+  public:
+
+    bucket_scheduler(size_t num_vertices, const graphlab_options& opts);
+
+    void set_num_vertices(const lvid_type numv);
+
+    void schedule(const lvid_type vid, double priority = 1);
+
+    /** Get the next element in the queue */
+    sched_status::status_enum get_next(const size_t cpuid,
+                                       lvid_type& ret_vid);
+
+    bool empty();
+
+    bool next_round(double& round);
+
+    void start_round(double round);
+
+    static void print_options_help(std::ostream& out) {
+      out << "\t delta = [width of a priority bucket. Default = 1].\n"
+          << "\t sync = [advance the buckets of all the machines together. "
+          << "Each bucket then costs a global barrier. Default = 1].\n";
+    }
+  };
+
+
+} // end of namespace graphlab
+
+#endif
@@ -38,6 +38,7 @@
 #include <ostream>
 
 #include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/serialization/is_pod.hpp>
 
 #include <graphlab/options/graphlab_options.hpp>
 
@@ -101,6 +102,19 @@ namespace graphlab {
     /// returns true if the scheduler is empty. Need not be consistent.
     virtual bool empty() = 0;
 
+    /**
+     * Schedulers which hold vertices back until every machine has
+     * drained the current round return true, and the lowest round
+     * holding vertices in round. get_next() does not return the held
+     * back vertices, so the engine calls this when it terminates, takes
+     * the lowest round over all the machines and calls start_round()
+     * with it before running again.
+     */
+    virtual bool next_round(double& round) { return false; }
+
+    /// Releases the vertices of all the rounds up to round.
+    virtual void start_round(double round) { }
+
     /**
      * Print a help string describing the options that this scheduler
      * accepts.
@@ -109,6 +123,49 @@ namespace graphlab {
 
   };
 
+
+  namespace scheduler_impl {
+    /// The lowest round held back by the scheduler of any machine
+    struct next_round_type: public IS_POD_TYPE {
+      bool pending;
+      double round;
+      bool stop;
+      next_round_type& operator+=(const next_round_type& other) {
+        if (other.pending && (!pending || other.round < round)) {
+          round = other.round;
+        }
+        pending |= other.pending;
+        stop |= other.stop;
+        return *this;
+      }
+    };
+  } // namespace scheduler_impl
+
+  /**
+   * \internal
+   * Called by one thread on every machine when an engine runs out of
+   * work. Starts the lowest round held back by the scheduler on any
+   * machine (see ischeduler::next_round()), and returns false if there
+   * is none or if stop is true on any machine. The engine must then
+   * restart its termination detection and workers before running the
+   * round.
+   *
+   * Each round thus costs a termination consensus, an all_reduce, a
+   * barrier and a relaunch of the workers of the engine.
+   */
+  template <typename RPCType>
+  bool start_next_scheduler_round(RPCType& rmi, ischeduler& sched,
+                                  bool stop) {
+    scheduler_impl::next_round_type next;
+    next.round = 0;
+    next.pending = sched.next_round(next.round);
+    next.stop = stop;
+    rmi.all_reduce(next);
+    if (!next.pending || next.stop) return false;
+    sched.start_round(next.round);
+    return true;
+  }
+
 }
 #endif
 
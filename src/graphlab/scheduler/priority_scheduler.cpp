@@ -21,7 +21,9 @@
  */
 
 
+#include <graphlab/parallel/fiber_control.hpp>
 #include <graphlab/scheduler/priority_scheduler.hpp>
+
 #include <graphlab/macros_def.hpp>
 namespace graphlab {
 
@@ -31,6 +33,8 @@ void priority_scheduler::set_options(const graphlab_options& opts) {
   foreach(std::string opt, keys) {
     if (opt == "multi") {
       opts.get_scheduler_args().get_option("multi", multi);
+    } else if (opt == "batch") {
+      opts.get_scheduler_args().get_option("batch", batch);
     } else if (opt == "min_priority") {
       opts.get_scheduler_args().get_option("min_priority", min_priority);
     }  else {
@@ -41,16 +45,18 @@ void priority_scheduler::set_options(const graphlab_options& opts) {
 
 // Initializes the internal datastructures
 void priority_scheduler::initialize_data_structures() {
-  current_queue.resize(ncpus, 0);
-  size_t nqueues = std::max(multi * current_queue.size(), size_t(1));
-  queues.resize(nqueues);
-  locks.resize(nqueues);
+  size_t nheaps = std::max(multi * ncpus, size_t(1));
+  heaps.resize(nheaps);
+  locks.resize(nheaps);
+  buffers.resize(ncpus);
+  buffer_locks.resize(ncpus);
+  for (size_t i = 0; i < buffers.size(); ++i) buffers[i].reserve(batch);
   vertex_is_scheduled.resize(num_vertices);
 }
 
 priority_scheduler::priority_scheduler(size_t num_vertices,
                                        const graphlab_options& opts):
-    multi(3), 
+    multi(2), batch(16),
     min_priority(-std::numeric_limits<double>::max()),
     num_vertices(num_vertices) { 
   ASSERT_GE(opts.get_ncpus(), 1);
@@ -64,72 +70,128 @@ void priority_scheduler::set_num_vertices(const lvid_type numv) {
   vertex_is_scheduled.resize(numv);
 }
 
+void priority_scheduler::insert(const entry_type* begin,
+                                const entry_type* end) {
+  // M.D. Mitzenmacher The Power of Two Choices in Randomized
+  // Load Balancing (1991)
+  // http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.
+  size_t idx = 0;
+  while(1) {
+    if (heaps.size() > 1) {
+      const size_t r1 = random::fast_uniform(size_t(0), heaps.size() - 1);
+      const size_t r2 = random::fast_uniform(size_t(0), heaps.size() - 1);
+      idx = heaps[r1].entries.size() < heaps[r2].entries.size() ? r1 : r2;
+      if (!locks[idx].try_lock()) continue;
+    } else {
+      locks[idx].lock();
+    }
+    break;
+  }
+  std::vector<entry_type>& entries = heaps[idx].entries;
+  for (const entry_type* e = begin; e != end; ++e) {
+    entries.push_back(*e);
+    std::push_heap(entries.begin(), entries.end());
+  }
+  heaps[idx].top_priority = entries.front().first;
+  locks[idx].unlock();
+}
+
+void priority_scheduler::flush_buffer(size_t idx) {
+  std::vector<entry_type> entries;
+  buffer_locks[idx].lock();
+  entries.swap(buffers[idx]);
+  buffers[idx].reserve(batch);
+  buffer_locks[idx].unlock();
+  if (entries.empty()) return;
+  insert(&entries[0], &entries[0] + entries.size());
+  buffered.dec(entries.size());
+}
+
 void priority_scheduler::schedule(const lvid_type vid, double priority) {
   if (vid < num_vertices && !vertex_is_scheduled.set_bit(vid)) {
-    /* "Randomize" the task queue task is put in. Note that we do
-       not care if this counter is corrupted in race conditions
-       Find first queue that is not locked and put task there (or
-       after iteration limit) Choose two random queues and use the
-       one which has smaller size */
-    // M.D. Mitzenmacher The Power of Two Choices in Randomized
-    // Load Balancing (1991)
-    // http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.
-    size_t idx = 0;
-    if(queues.size() > 1) {
-      const uint32_t prod = 
-          random::fast_uniform(uint32_t(0), 
-                               uint32_t(queues.size() * queues.size() - 1));
-      const uint32_t r1 = prod / queues.size();
-      const uint32_t r2 = prod % queues.size();
-      idx = (queues[r1].size() < queues[r2].size()) ? r1 : r2;  
+    const entry_type entry(priority, vid);
+    // a fiber worker runs one fiber at a time, and fibers do not yield
+    // inside the scheduler, so its buffer lock is rarely contended
+    const size_t workerid = fiber_control::get_worker_id();
+    if (batch > 1 && workerid < buffers.size()) {
+      buffer_locks[workerid].lock();
+      buffers[workerid].push_back(entry);
+      const bool full = buffers[workerid].size() >= batch;
+      buffered.inc();
+      buffer_locks[workerid].unlock();
+      if (full) flush_buffer(workerid);
+    } else {
+      insert(&entry, &entry + 1);
+    }
+  }
+}
+
+bool priority_scheduler::pop_from(size_t idx, bool wait, lvid_type& ret_vid) {
+  if (wait) locks[idx].lock();
+  else if (!locks[idx].try_lock()) return false;
+  bool good = false;
+  std::vector<entry_type>& entries = heaps[idx].entries;
+  while(!entries.empty() && entries.front().first >= min_priority) {
+    // not empty, pop and verify
+    ret_vid = entries.front().second;
+    std::pop_heap(entries.begin(), entries.end());
+    entries.pop_back();
+    if (ret_vid < num_vertices) {
+      good = vertex_is_scheduled.clear_bit(ret_vid);
+      if (good) break;
     }
-    locks[idx].lock(); 
-    queues[idx].push_or_update(vid, priority); 
-    locks[idx].unlock();
   }
+  heaps[idx].top_priority = entries.empty() ?
+      -std::numeric_limits<double>::infinity() : entries.front().first;
+  locks[idx].unlock();
+  return good;
 }
 
 /** Get the next element in the queue */
 sched_status::status_enum priority_scheduler::get_next(const size_t cpuid,
                                                        lvid_type& ret_vid) {
-  /* Check all of my queues for a task */
-  // begin scanning from the machine's current queue
-  size_t initial_idx = (current_queue[cpuid] % multi) + cpuid * multi;
-  for(size_t i = 0; i < queues.size(); ++i) {
-    const size_t idx = (initial_idx + i) % queues.size();
-    // increment the current queue as long as I am scanning with in the 
-    // queues owned by this machine
-    current_queue[cpuid] += (i < multi);
-
-    // pick up the lock
-    bool good = false;
-    locks[idx].lock();
-    while(!queues[idx].empty() && queues[idx].top().second >= min_priority) {
-      // not empty, pop and verify
-      ret_vid = queues[idx].pop().first;
-      if (ret_vid < num_vertices) {
-        good = vertex_is_scheduled.clear_bit(ret_vid);
-        if (good) break;
-      }
-      else continue;
-    }
-    locks[idx].unlock();
-    // managed to retrieve a task
-    if(good) {
-      return sched_status::NEW_TASK;
+  const size_t workerid = fiber_control::get_worker_id();
+  if (workerid < buffers.size() && !buffers[workerid].empty()) {
+    flush_buffer(workerid);
+  }
+  // pop from the better of two random heaps. Give up after a few
+  // attempts which find both empty or locked.
+  if (heaps.size() > 1) {
+    for (size_t i = 0; i < 2 * heaps.size(); ++i) {
+      const size_t r1 = random::fast_uniform(size_t(0), heaps.size() - 1);
+      const size_t r2 = random::fast_uniform(size_t(0), heaps.size() - 1);
+      const size_t idx = 
+          heaps[r1].top_priority > heaps[r2].top_priority ? r1 : r2;
+      if (heaps[idx].top_priority < min_priority) continue;
+      if (pop_from(idx, false, ret_vid)) return sched_status::NEW_TASK;
     }
   }
+  // the vertices left behind in the buffers of the other workers are
+  // only seen here. A flush in progress elsewhere may hide some
+  // vertices, so only give up once the buffers are seen empty.
+  const size_t initial_idx = cpuid % heaps.size();
+  do {
+    if (buffered.value > 0) {
+      for (size_t i = 0; i < buffers.size(); ++i) flush_buffer(i);
+    }
+    /* Check all the heaps for a task */
+    for(size_t i = 0; i < heaps.size(); ++i) {
+      const size_t idx = (initial_idx + i) % heaps.size();
+      if (heaps[idx].top_priority < min_priority) continue;
+      // managed to retrieve a task
+      if (pop_from(idx, true, ret_vid)) return sched_status::NEW_TASK;
+    }
+  } while (buffered.value > 0);
   return sched_status::EMPTY;     
 } // end of get_next_task
 
 
 bool priority_scheduler::empty() {
-  for (size_t i = 0;i < queues.size(); ++i) {
-    if (!queues[i].empty() && queues[i].top().second >= min_priority) {
-      return false;
-    }
+  if (buffered.value > 0) return false;
+  for (size_t i = 0;i < heaps.size(); ++i) {
+    if (heaps[i].top_priority >= min_priority) return false;
   }
   return true;
 }
 
-}
+} // end of namespace graphlab
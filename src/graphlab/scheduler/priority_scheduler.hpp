@@ -25,64 +25,98 @@
 #define GRAPHLAB_PRIORITY_SCHEDULER_HPP
 
 #include <algorithm>
-#include <queue>
+#include <limits>
+#include <vector>
+#include <utility>
 
 #include <graphlab/graph/graph_basic_types.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/parallel/atomic.hpp>
 
 #include <graphlab/util/random.hpp>
-#include <graphlab/util/mutable_queue.hpp>
 #include <graphlab/scheduler/ischeduler.hpp>
 #include <graphlab/util/dense_bitset.hpp>
 
 #include <graphlab/options/graphlab_options.hpp>
 
-#include <graphlab/macros_def.hpp>
 namespace graphlab {
 
   /**
    * \ingroup group_schedulers 
    *
-   * This class defines a multiple queue approximate priority scheduler.
-   * Each processor has its own in_queue which it puts new tasks in
-   * and out_queue which it pulls tasks from.  Once a processors
-   * in_queue gets too large, the entire queue is placed at the end of
-   * the shared master queue.  Once a processors out queue is empty it
-   * grabs the next out_queue from the master.
+   * A relaxed concurrent priority scheduler (a MultiQueue). The
+   * vertices are spread over multi * ncpus binary heaps, each behind
+   * its own spinlock. A pop looks at the tops of two random heaps and
+   * takes the vertex with the higher priority, so the order of
+   * execution is close to the global priority order while threads
+   * rarely contend for the same lock.
+   *
+   * Vertices scheduled by a fiber worker are first collected in a
+   * buffer of the worker and inserted into a single heap, batch at a
+   * time. The buffer is flushed whenever the worker asks for a vertex.
+   * Threads which are not fiber workers insert directly.
+   *
+   * A vertex is in at most one heap or buffer at once: scheduling a
+   * vertex which is already scheduled is ignored.
    */
   class priority_scheduler : public ischeduler {
   
   public:
 
-    typedef mutable_queue<lvid_type, double> queue_type;
+    // the heaps hold (priority, vertex) pairs
+    typedef std::pair<double, lvid_type> entry_type;
 
   private:
+    struct heap_type {
+      std::vector<entry_type> entries;
+      // the priority of the top entry, or -inf. Only written while
+      // holding the lock, and read without it to pick a heap.
+      volatile double top_priority;
+      char pad[64 - sizeof(std::vector<entry_type>) - sizeof(double)];
+      heap_type() : top_priority(-std::numeric_limits<double>::infinity()) { }
+    };
 
     // a bitset denoting if a vertex is scheduled
     dense_bitset vertex_is_scheduled;
-    // a collection of priority queues
-    std::vector<queue_type> queues;
-    // a parallel datastructure to queues containing all the locks
-    std::vector<padded_simple_spinlock>   locks;
-    // the index of the queue currently accessed by a given CPU
-    // when used, this is modded so that it ranges from 0 to multi - 1
-    std::vector<size_t>   current_queue; 
-
+    // a collection of binary heaps
+    std::vector<heap_type> heaps;
+    // a parallel datastructure to heaps containing all the locks
+    std::vector<padded_simple_spinlock> locks;
+    // the insertion buffer of each fiber worker
+    std::vector<std::vector<entry_type> > buffers;
+    // a parallel datastructure to buffers containing all the locks
+    std::vector<padded_simple_spinlock> buffer_locks;
+    // the number of vertices in the buffers
+    atomic<size_t> buffered;
 
     // the number of CPUs
     size_t ncpus;
-    // The queue to CPU ratio
+    // The heap to CPU ratio
     size_t multi;
+    // the number of vertices buffered before they are inserted
+    size_t batch;
+
     double min_priority; 
+
     // the number of vertices in the graph
     size_t num_vertices;
-    
-  
-    void set_options(const graphlab_options& opts);
+
+    void set_options(const graphlab_options& opts); 
 
     // Initializes the internal datastructures
     void initialize_data_structures();
+
+    // inserts the entries into a heap which is not locked, preferring
+    // the smaller of two random heaps
+    void insert(const entry_type* begin, const entry_type* end);
+
+    // moves the entries of a buffer into a heap
+    void flush_buffer(size_t idx);
+
+    // pops a vertex of at least min_priority from the heap, if its lock
+    // can be taken without waiting (or always when wait is set)
+    bool pop_from(size_t idx, bool wait, lvid_type& ret_vid);
+
   public:
 
     priority_scheduler(size_t num_vertices, const graphlab_options& opts);
@@ -90,7 +124,7 @@ namespace graphlab {
     void set_num_vertices(const lvid_type numv);
 
     void schedule(const lvid_type vid, double priority = 1);
-
+      
     /** Get the next element in the queue */
     sched_status::status_enum get_next(const size_t cpuid,
                                        lvid_type& ret_vid);
@@ -98,17 +132,17 @@ namespace graphlab {
     bool empty();
 
     static void print_options_help(std::ostream& out) {
-      out << "\t multi = [number of queues per thread. Default = 3].\n"
+      out << "\t multi = [number of heaps per thread. Default = 2].\n"
+          << "\t batch = [number of vertices a worker buffers before \n"
+          << "\t inserting them, 1 inserts at once. Default = 16].\n"
           << "min_priority = [double, minimum priority required to receive \n"
           << "\t a message, default = -inf]\n";
     }
 
-
   }; 
 
 
 } // end of namespace graphlab
-#include <graphlab/macros_undef.hpp>
 
 #endif
 
@@ -37,18 +37,29 @@
     "very fast dynamic scheduler. Scans all vertices in sequence, "     \
     "running all update tasks on each vertex evaluated."))              \
   (("priority", priority_scheduler,                                     \
-    "Standard Priority queue, poor parallelism, but task evaluation "   \
-    "sequence is highly predictable. Useful for debugging"))            \
+    "Relaxed priority queue. Pops the better of the tops of two "       \
+    "random heaps out of multi * ncpus, and inserts in batches. Close " \
+    "to global priority order with little lock contention."))           \
   (("queued_fifo", queued_fifo_scheduler,                               \
     "This scheduler maintains a shared FIFO queue of FIFO queues. "     \
     "Each thread maintains its own smaller in and out queues. When a "  \
     "threads out queue is too large (greater than \"queuesize\") then " \
-    "the thread puts its out queue at the end of the master queue."))   
+    "the thread puts its out queue at the end of the master queue."))   \
+  (("work_stealing", work_stealing_scheduler,                           \
+    "Each worker pushes and pops its own vertices on a lock free "      \
+    "deque, and steals batches of vertices from random workers, of "    \
+    "its own NUMA node first, when its deque is empty."))               \
+  (("bucket", bucket_scheduler,                                         \
+    "Delta-stepping scheduler. Runs the vertices in buckets of width "  \
+    "\"delta\" of the priority, highest first. With \"sync\" the "      \
+    "buckets advance on all the machines together."))
 
 #include <graphlab/scheduler/fifo_scheduler.hpp>
 #include <graphlab/scheduler/sweep_scheduler.hpp>
 #include <graphlab/scheduler/priority_scheduler.hpp>
 #include <graphlab/scheduler/queued_fifo_scheduler.hpp>
+#include <graphlab/scheduler/work_stealing_scheduler.hpp>
+#include <graphlab/scheduler/bucket_scheduler.hpp>
 
 
 namespace graphlab {
@@ -0,0 +1,239 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <dirent.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <graphlab/parallel/fiber_control.hpp>
+#include <graphlab/scheduler/work_stealing_scheduler.hpp>
+
+#include <graphlab/macros_def.hpp>
+namespace graphlab {
+
+/**
+ * Returns the NUMA node of a CPU from sysfs, or 0 if unknown.
+ */
+static size_t numa_node_of_cpu(size_t cpu) {
+  char path[64];
+  sprintf(path, "/sys/devices/system/cpu/cpu%lu", (unsigned long)cpu);
+  DIR* dir = opendir(path);
+  if (dir == NULL) return 0;
+  size_t node = 0;
+  struct dirent* ent;
+  while ((ent = readdir(dir)) != NULL) {
+    if (strncmp(ent->d_name, "node", 4) == 0 &&
+        ent->d_name[4] >= '0' && ent->d_name[4] <= '9') {
+      node = atoi(ent->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+void work_stealing_scheduler::set_options(const graphlab_options& opts) {
+  ncpus = opts.get_ncpus();
+  std::vector<std::string> keys = opts.get_scheduler_args().get_option_keys();
+  foreach(std::string opt, keys) {
+    if (opt == "steal_batch") {
+      opts.get_scheduler_args().get_option("steal_batch", steal_batch);
+      steal_batch = std::max(steal_batch, size_t(1));
+    } else if (opt == "numa") {
+      opts.get_scheduler_args().get_option("numa", numa);
+    } else {
+      logstream(LOG_FATAL) << "Unexpected Scheduler Option: " << opt << std::endl;
+    }
+  }
+}
+
+// Initializes the internal datastructures
+void work_stealing_scheduler::initialize_data_structures() {
+  deques.resize(ncpus);
+  for (size_t i = 0; i < ncpus; ++i) deques[i] = new deque_type;
+  inboxes.resize(ncpus);
+  inbox_locks.resize(ncpus);
+  vertex_is_scheduled.resize(num_vertices);
+
+  // fiber worker i is pinned to CPU i
+  worker_node.resize(ncpus);
+  const size_t ncores = std::max(thread::cpu_count(), size_t(1));
+  for (size_t i = 0; i < ncpus; ++i) {
+    worker_node[i] = numa ? numa_node_of_cpu(i % ncores) : 0;
+    if (worker_node[i] >= node_workers.size()) {
+      node_workers.resize(worker_node[i] + 1);
+    }
+    node_workers[worker_node[i]].push_back(i);
+  }
+}
+
+work_stealing_scheduler::work_stealing_scheduler(size_t num_vertices,
+                                                 const graphlab_options& opts):
+    steal_batch(32), numa(true), num_vertices(num_vertices) {
+  ASSERT_GE(opts.get_ncpus(), 1);
+  set_options(opts);
+  initialize_data_structures();
+}
+
+work_stealing_scheduler::~work_stealing_scheduler() {
+  for (size_t i = 0; i < deques.size(); ++i) delete deques[i];
+}
+
+void work_stealing_scheduler::set_num_vertices(const lvid_type numv) {
+  num_vertices = numv;
+  vertex_is_scheduled.resize(numv);
+}
+
+size_t work_stealing_scheduler::owned_deque() const {
+  // a fiber worker runs one fiber at a time, and fibers do not yield
+  // inside the scheduler, so the worker is the only user of its deque
+  const size_t workerid = fiber_control::get_worker_id();
+  return workerid < deques.size() ? workerid : size_t(-1);
+}
+
+void work_stealing_scheduler::schedule(const lvid_type vid, double priority) {
+  if (vid < num_vertices && !vertex_is_scheduled.set_bit(vid)) {
+    const size_t owner = owned_deque();
+    if (owner != size_t(-1)) {
+      deques[owner]->push(vid);
+    } else {
+      const size_t idx = inboxes.size() > 1 ?
+          random::fast_uniform(size_t(0), inboxes.size() - 1) : 0;
+      inbox_locks[idx].lock();
+      inboxes[idx].push_back(vid);
+      inbox_locks[idx].unlock();
+      inbox_size.inc();
+    }
+  }
+}
+
+bool work_stealing_scheduler::drain_inbox(size_t idx, size_t owner,
+                                          lvid_type& ret_vid) {
+  if (inboxes[idx].empty()) return false;
+  std::vector<lvid_type> vids;
+  bool found = false;
+  inbox_locks[idx].lock();
+  if (owner == size_t(-1)) {
+    // without a deque to keep the rest in, take a single vertex
+    while (!found && !inboxes[idx].empty()) {
+      lvid_type vid = inboxes[idx].back();
+      inboxes[idx].pop_back();
+      inbox_size.dec();
+      found = claim(vid);
+      if (found) ret_vid = vid;
+    }
+  } else {
+    vids.swap(inboxes[idx]);
+  }
+  inbox_locks[idx].unlock();
+  if (vids.empty()) return found;
+  inbox_size.dec(vids.size());
+  foreach(lvid_type vid, vids) {
+    if (found) {
+      deques[owner]->push(vid);
+    } else if (claim(vid)) {
+      ret_vid = vid;
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool work_stealing_scheduler::steal_from(size_t victim, size_t owner,
+                                         lvid_type& ret_vid) {
+  deque_type& from = *deques[victim];
+  // take up to half of the victim's vertices
+  size_t n = owner == size_t(-1) ? 1 :
+      std::min(steal_batch, (from.size() + 1) / 2);
+  bool found = false;
+  for (size_t i = 0; i < n; ++i) {
+    lvid_type vid;
+    if (!from.steal(vid)) break;
+    if (found) {
+      deques[owner]->push(vid);
+    } else if (claim(vid)) {
+      ret_vid = vid;
+      found = true;
+    }
+  }
+  return found;
+}
+
+/** Get the next element in the queue */
+sched_status::status_enum work_stealing_scheduler::get_next(const size_t cpuid,
+                                                            lvid_type& ret_vid) {
+  const size_t owner = owned_deque();
+  if (owner != size_t(-1)) {
+    lvid_type vid;
+    while (deques[owner]->pop(vid)) {
+      if (claim(vid)) {
+        ret_vid = vid;
+        return sched_status::NEW_TASK;
+      }
+    }
+  }
+  const size_t home = owner != size_t(-1) ? owner : cpuid % deques.size();
+  // a steal may fail because another thread took the vertex, so only
+  // give up once every deque was seen empty
+  while(1) {
+    bool all_empty = true;
+    if (inbox_size.value > 0) {
+      for (size_t i = 0; i < inboxes.size(); ++i) {
+        if (drain_inbox((home + i) % inboxes.size(), owner, ret_vid)) {
+          return sched_status::NEW_TASK;
+        }
+      }
+    }
+    // try the workers of the same NUMA node first
+    if (numa && node_workers.size() > 1) {
+      const std::vector<size_t>& local = node_workers[worker_node[home]];
+      const size_t start = random::fast_uniform(size_t(0), local.size() - 1);
+      for (size_t i = 0; i < local.size(); ++i) {
+        const size_t victim = local[(start + i) % local.size()];
+        if (victim == owner || deques[victim]->empty()) continue;
+        if (steal_from(victim, owner, ret_vid)) return sched_status::NEW_TASK;
+      }
+    }
+    const size_t start = deques.size() > 1 ?
+        random::fast_uniform(size_t(0), deques.size() - 1) : 0;
+    for (size_t i = 0; i < deques.size(); ++i) {
+      const size_t victim = (start + i) % deques.size();
+      if (victim == owner || deques[victim]->empty()) continue;
+      all_empty = false;
+      if (steal_from(victim, owner, ret_vid)) return sched_status::NEW_TASK;
+    }
+    if (all_empty && inbox_size.value == 0) break;
+  }
+  return sched_status::EMPTY;
+} // end of get_next_task
+
+
+bool work_stealing_scheduler::empty() {
+  if (inbox_size.value > 0) return false;
+  for (size_t i = 0; i < deques.size(); ++i) {
+    if (!deques[i]->empty()) return false;
+  }
+  return true;
+}
+
+} // end of namespace graphlab
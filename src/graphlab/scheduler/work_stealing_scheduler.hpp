@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_WORK_STEALING_SCHEDULER_HPP
+#define GRAPHLAB_WORK_STEALING_SCHEDULER_HPP
+
+#include <vector>
+
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+
+#include <graphlab/util/random.hpp>
+#include <graphlab/util/chase_lev_deque.hpp>
+#include <graphlab/scheduler/ischeduler.hpp>
+#include <graphlab/util/dense_bitset.hpp>
+
+#include <graphlab/options/graphlab_options.hpp>
+
+namespace graphlab {
+
+  /**
+   * \ingroup group_schedulers
+   *
+   * A work stealing scheduler. Each fiber worker owns a lock free
+   * deque. Vertices scheduled by a worker are pushed on its own deque
+   * and popped in LIFO order, which keeps the neighborhood of a vertex
+   * warm in the cache. A worker whose deque is empty steals a batch of
+   * the oldest vertices of a random victim, trying the workers of its
+   * own NUMA node first.
+   *
+   * The owner of a deque is the fiber worker thread, found with
+   * fiber_control::get_worker_id(). Threads which own no deque, such as
+   * the thread scheduling the initial vertices, put vertices into
+   * spinlocked inboxes which the workers drain.
+   */
+  class work_stealing_scheduler : public ischeduler {
+  
+  public:
+
+    typedef chase_lev_deque<lvid_type> deque_type;
+
+  private:
+    // a bitset denoting if a vertex is scheduled
+    dense_bitset vertex_is_scheduled;
+    // the deque of each worker
+    std::vector<deque_type*> deques;
+    // the vertices scheduled by threads which own no deque
+    std::vector<std::vector<lvid_type> > inboxes;
+    // a parallel datastructure to inboxes containing all the locks
+    std::vector<padded_simple_spinlock> inbox_locks;
+    // the approximate number of vertices in the inboxes
+    atomic<size_t> inbox_size;
+    // the NUMA node of each worker
+    std::vector<size_t> worker_node;
+    // the workers of each NUMA node
+    std::vector<std::vector<size_t> > node_workers;
+
+    // the number of CPUs
+    size_t ncpus;
+    // the most vertices taken from a victim at once
+    size_t steal_batch;
+    // whether victims are chosen within the NUMA node first
+    bool numa;
+    // the number of vertices in the graph
+    size_t num_vertices;
+
+    void set_options(const graphlab_options& opts); 
+
+    // Initializes the internal datastructures
+    void initialize_data_structures();
+
+    // the deque owned by the calling thread, or -1
+    size_t owned_deque() const;
+
+    // takes a vertex from an inbox. The others are moved to the deque
+    // of owner if there is one.
+    bool drain_inbox(size_t idx, size_t owner, lvid_type& ret_vid);
+
+    // steals up to steal_batch vertices from victim. The first is
+    // returned, the others pushed on the deque of owner if there is one.
+    bool steal_from(size_t victim, size_t owner, lvid_type& ret_vid);
+
+    // claims a vertex popped from a deque
+    inline bool claim(lvid_type vid) {
+      return vid < num_vertices && vertex_is_scheduled.clear_bit(vid);
+    }
+
+  public:
+
+    work_stealing_scheduler(size_t num_vertices,
+                            const graphlab_options& opts);
+
+    ~work_stealing_scheduler();
+
+    void set_num_vertices(const lvid_type numv);
+
+    void schedule(const lvid_type vid, double priority = 1 /* ignored */ );
+
+    /** Get the next element in the queue */
+    sched_status::status_enum get_next(const size_t cpuid,
+                                       lvid_type& ret_vid);
+
+    bool empty();
+
+    static void print_options_help(std::ostream& out) {
+      out << "\t steal_batch = [most vertices stolen at once. Default = 32].\n"
+          << "\t numa = [steal within the NUMA node first. Default = 1].\n";
+    }
+  }; 
+
+
+} // end of namespace graphlab
+
+#endif
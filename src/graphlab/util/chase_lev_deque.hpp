@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_CHASE_LEV_DEQUE_HPP
+#define GRAPHLAB_CHASE_LEV_DEQUE_HPP
+#include <stdint.h>
+#include <vector>
+#include <graphlab/logger/assertions.hpp>
+
+namespace graphlab {
+
+/**
+ * \ingroup util
+ * A lock free work stealing deque (Chase and Lev, "Dynamic Circular
+ * Work-Stealing Deque", SPAA 2005; with the fences of Le et al.,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP
+ * 2013).
+ *
+ * A single owner thread pushes and pops at the bottom, while any thread
+ * may steal from the top. The buffer grows as needed. Grown out buffers
+ * are kept until destruction since a thief may still be reading them.
+ *
+ * T must be a scalar, such as an integer id.
+ */
+template <typename T>
+class chase_lev_deque {
+ public:
+  explicit chase_lev_deque(size_t initial_capacity = 64)
+      : top(0), bottom(0) {
+    size_t capacity = 1;
+    while (capacity < initial_capacity) capacity *= 2;
+    buffer = new ring(capacity);
+  }
+
+  ~chase_lev_deque() {
+    delete buffer;
+    for (size_t i = 0; i < retired.size(); ++i) delete retired[i];
+  }
+
+  /// Adds an element at the bottom. Owner only.
+  void push(const T& value) {
+    const int64_t b = bottom;
+    const int64_t t = top;
+    ring* a = buffer;
+    if (b - t >= (int64_t)a->capacity) a = grow(a, b, t);
+    a->put(b, value);
+    // the element must be visible before the new bottom
+    release_fence();
+    bottom = b + 1;
+  }
+
+  /// Removes the last element pushed. Owner only.
+  bool pop(T& ret) {
+    const int64_t b = bottom - 1;
+    ring* a = buffer;
+    bottom = b;
+    // the new bottom must be visible before top is read
+    __sync_synchronize();
+    int64_t t = top;
+    if (t > b) {
+      // empty
+      bottom = b + 1;
+      return false;
+    }
+    ret = a->get(b);
+    if (t == b) {
+      // the last element. race the thieves for it
+      const bool won = __sync_bool_compare_and_swap(&top, t, t + 1);
+      bottom = b + 1;
+      return won;
+    }
+    return true;
+  }
+
+  /**
+   * Removes the oldest element. May be called by any thread. Returns
+   * false if the deque is empty or if another thread won the element.
+   */
+  bool steal(T& ret) {
+    const int64_t t = top;
+    // top must be read before bottom
+    __sync_synchronize();
+    const int64_t b = bottom;
+    if (t >= b) return false;
+    ring* a = buffer;
+    ret = a->get(t);
+    return __sync_bool_compare_and_swap(&top, t, t + 1);
+  }
+
+  /// The number of elements. Only approximate while in use.
+  size_t size() const {
+    const int64_t n = bottom - top;
+    return n > 0 ? n : 0;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+ private:
+  struct ring {
+    size_t capacity;
+    volatile T* data;
+    explicit ring(size_t capacity)
+        : capacity(capacity), data(new T[capacity]) { }
+    ~ring() { delete [] data; }
+    inline T get(int64_t i) const { return data[i & (capacity - 1)]; }
+    inline void put(int64_t i, const T& v) { data[i & (capacity - 1)] = v; }
+  };
+
+  static inline void release_fence() {
+#if defined(__i386__) || defined(__x86_64__)
+    // stores are not reordered with other stores
+    asm volatile ("" : : : "memory");
+#else
+    __sync_synchronize();
+#endif
+  }
+
+  ring* grow(ring* a, int64_t b, int64_t t) {
+    ring* bigger = new ring(a->capacity * 2);
+    for (int64_t i = t; i < b; ++i) bigger->put(i, a->get(i));
+    retired.push_back(a);
+    release_fence();
+    buffer = bigger;
+    return bigger;
+  }
+
+  volatile int64_t top;
+  char pad0[64 - sizeof(int64_t)];
+  volatile int64_t bottom;
+  ring* volatile buffer;
+  char pad1[64 - sizeof(int64_t) - sizeof(ring*)];
+  /// Buffers replaced by grow(). Owner only
+  std::vector<ring*> retired;
+
+  // not copyable
+  chase_lev_deque(const chase_lev_deque&);
+  chase_lev_deque& operator=(const chase_lev_deque&);
+};
+
+} // namespace graphlab
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_FRONTIER_BITSET_HPP
+#define GRAPHLAB_FRONTIER_BITSET_HPP
+
+#include <vector>
+#include <algorithm>
+#include <graphlab/util/dense_bitset.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+
+namespace graphlab {
+
+  /**  \ingroup util
+   * An atomic dense bitset which additionally records the positions of
+   * the bits it sets while only few bits are set.
+   *
+   * Every bit newly set by set_bit() is appended to a preallocated list
+   * of positions as long as the number of set bits stays below
+   * size() * density_threshold. While the list has not overflowed the
+   * set bits can be enumerated and cleared in time proportional to the
+   * number of set bits rather than to size(). Once it overflows the
+   * bitset behaves like a plain dense_bitset until the next clear().
+   *
+   * Set bits are enumerated by several threads at once using a
+   * parallel_iterator sharing a common counter, after the bits to be
+   * enumerated are fixed with begin_iteration(). A bit which is cleared
+   * with clear_bit() and set again before the next clear() may be
+   * enumerated twice.
+   */
+  class frontier_bitset {
+  public:
+
+    /// Constructs an empty bitset. The sparse list is disabled.
+    frontier_bitset() : density_threshold(0), capacity(0),
+                        iter_sparse(false), iter_end(0) { }
+
+    /// Resizes the bitset to n bits. Existing bits are kept.
+    inline void resize(size_t n) {
+      bits.resize(n);
+      update_capacity();
+    }
+
+    /**
+     * Sets the fraction of bits below which the positions of the
+     * set bits are tracked. A threshold of 0 disables the sparse list.
+     * Existing bits are kept.
+     */
+    inline void set_density_threshold(double threshold) {
+      density_threshold = threshold;
+      update_capacity();
+    }
+
+    /// Returns the number of bits.
+    inline size_t size() const { return bits.size(); }
+
+    /// Returns true if the positions of all set bits are known.
+    inline bool is_sparse() const { return num_listed.value <= capacity; }
+
+    /// Returns the value of the bit b
+    inline bool get(size_t b) const { return bits.get(b); }
+
+    //! Atomically sets the bit at position b to true returning the old value
+    inline bool set_bit(size_t b) {
+      if (bits.set_bit(b)) return true;
+      const size_t idx = num_listed.inc_ret_last();
+      if (idx < capacity) listed[idx] = b;
+      return false;
+    }
+
+    //! Atomically sets the bit b to false returning the old value
+    inline bool clear_bit(size_t b) { return bits.clear_bit(b); }
+
+    /// Sets all bits to 0. Not thread safe.
+    inline void clear() {
+      if (is_sparse()) {
+        for (size_t i = 0;i < num_listed.value; ++i) {
+          if (listed[i] != none()) {
+            bits.clear_bit_unsync(listed[i]);
+            listed[i] = none();
+          }
+        }
+      } else {
+        bits.clear();
+        std::fill(listed.begin(), listed.end(), none());
+      }
+      num_listed = 0;
+    }
+
+    /// Sets all bits to 1. Not thread safe.
+    inline void fill() {
+      bits.fill();
+      mark_dense();
+    }
+
+    /**
+     * Fixes the range enumerated by the parallel iterators constructed
+     * afterwards. Must be called while no bits are being set, before
+     * the threads construct their iterators. Not thread safe.
+     */
+    inline void begin_iteration() {
+      iter_sparse = is_sparse();
+      iter_end = iter_sparse ? num_listed.value : size();
+    }
+
+    /// Returns the underlying dense bitset
+    inline const dense_bitset& dense() const { return bits; }
+
+    inline void save(oarchive& oarc) const {
+      oarc << bits;
+    }
+
+    /// A loaded bitset is dense until the next clear()
+    inline void load(iarchive& iarc) {
+      iarc >> bits;
+      update_capacity();
+    }
+
+    /**
+     * Enumerates the set bits on several threads at once. Each thread
+     * constructs its own iterator over the same bitset and counter,
+     * where the counter must be zeroed and begin_iteration() called
+     * before the enumeration starts. Every set bit is returned to
+     * exactly one of the threads. Bits set while the enumeration is in
+     * progress may or may not be returned.
+     *
+     * \code
+     * frontier.begin_iteration();
+     * shared_counter = 0;
+     * // on every thread
+     * frontier_bitset::parallel_iterator iter(frontier, shared_counter);
+     * size_t b;
+     * while (iter.next(b)) {
+     *   ...
+     * }
+     * \endcode
+     */
+    class parallel_iterator {
+    public:
+      parallel_iterator(frontier_bitset& frontier,
+                        atomic<size_t>& counter) :
+        frontier(frontier), counter(counter),
+        sparse(frontier.iter_sparse), end(frontier.iter_end),
+        block_start(0), cursor(0), block_end(0), word(0) { }
+
+      /// Returns the next set bit in b. Returns false when done.
+      inline bool next(size_t& b) {
+        return sparse ? next_sparse(b) : next_dense(b);
+      }
+
+    private:
+      frontier_bitset& frontier;
+      atomic<size_t>& counter;
+      const bool sparse;
+      const size_t end;
+      size_t block_start, cursor, block_end;
+      size_t word;
+
+      inline bool next_dense(size_t& b) {
+        while (word == 0) {
+          // increment by a word at a time
+          block_start = counter.inc_ret_last(8 * sizeof(size_t));
+          if (block_start >= end) return false;
+          word = frontier.bits.containing_word(block_start);
+        }
+        b = block_start + (size_t)__builtin_ctzl(word);
+        // clear the lowest set bit
+        word &= word - 1;
+        return b < end;
+      }
+
+      inline bool next_sparse(size_t& b) {
+        while (1) {
+          while (cursor < block_end) {
+            b = frontier.listed[cursor++];
+            if (b != none() && frontier.bits.get(b)) return true;
+          }
+          // claim 64 list entries at a time
+          block_start = counter.inc_ret_last(64);
+          if (block_start >= end) return false;
+          cursor = block_start;
+          block_end = std::min<size_t>(block_start + 64, end);
+        }
+      }
+    }; // end of parallel_iterator
+
+  private:
+    /// Marks an unused entry of the list
+    static size_t none() { return size_t(-1); }
+
+    dense_bitset bits;
+    double density_threshold;
+    /// The number of positions the list can hold
+    size_t capacity;
+    /// The positions of the set bits. Unused entries are none().
+    std::vector<size_t> listed;
+    /// The number of bits newly set since the last clear
+    atomic<size_t> num_listed;
+    /// The range fixed by begin_iteration()
+    bool iter_sparse;
+    size_t iter_end;
+
+    inline void mark_dense() {
+      num_listed = capacity + 1;
+    }
+
+    /// Reallocates the list. The bitset is dense until the next clear.
+    inline void update_capacity() {
+      capacity = size_t(density_threshold * bits.size());
+      listed.clear();
+      listed.resize(capacity, none());
+      mark_dense();
+      iter_sparse = false;
+      iter_end = 0;
+    }
+
+    friend class parallel_iterator;
+  }; // end of frontier_bitset
+
+} // namespace graphlab
+
+#endif
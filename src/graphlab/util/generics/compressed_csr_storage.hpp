@@ -0,0 +1,259 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+#ifndef GRAPHLAB_COMPRESSED_CSR_STORAGE
+#define GRAPHLAB_COMPRESSED_CSR_STORAGE
+
+#include <iterator>
+#include <vector>
+
+#include <graphlab/logger/assertions.hpp>
+#include <graphlab/serialization/iarchive.hpp>
+#include <graphlab/serialization/oarchive.hpp>
+
+namespace graphlab {
+  /**
+   * A Compressed Sparse Row storage of unsigned integer values in which
+   * the values of each key are sorted and stored as varint encoded gaps.
+   * Lists of nearby vertex ids typically take 1-2 bytes per value
+   * instead of sizeof(valuetype).
+   *
+   * The values of a key are read with an iterator which decodes them on
+   * the fly. Moving it forward by one value is cheap while moving it
+   * backwards or by more than one value decodes from the first value of
+   * the key. Every value has a position in [0, num_values()),
+   * values of key i preceding those of key i+1, returned by
+   * iterator::index(). It can be used to index per value data stored
+   * alongside.
+   */
+  template <typename valuetype, typename sizetype=size_t>
+  class compressed_csr_storage {
+   public:
+     typedef valuetype value_type;
+
+     class iterator {
+      public:
+       typedef std::random_access_iterator_tag iterator_category;
+       typedef valuetype value_type;
+       typedef ptrdiff_t difference_type;
+       typedef const valuetype* pointer;
+       typedef const valuetype& reference;
+
+       iterator() : row_ptr(NULL), ptr(NULL), cur(0),
+                    row_idx(0), idx(0), end_idx(0) { }
+       /// An iterator at position idx of the values starting at row_idx
+       iterator(const unsigned char* row_ptr, sizetype row_idx,
+                sizetype idx, sizetype end_idx) :
+         row_ptr(row_ptr), ptr(row_ptr), cur(0),
+         row_idx(row_idx), idx(row_idx), end_idx(end_idx) {
+         if (idx == end_idx) this->idx = end_idx;
+         else seek(idx);
+       }
+
+       inline reference operator*() const { return cur; }
+       inline pointer operator->() const { return &cur; }
+
+       /// The position of the current value in the storage
+       inline sizetype index() const { return idx; }
+
+       inline iterator& operator++() {
+         if (++idx < end_idx) cur += decode();
+         return *this;
+       }
+       inline iterator operator++(int) {
+         iterator ret = *this;
+         ++(*this);
+         return ret;
+       }
+       /// Takes time linear in the distance from the first value of the key
+       inline iterator& operator--() {
+         seek(idx - 1);
+         return *this;
+       }
+       /// Takes time linear in n, or in the position within the key if n < 0
+       inline iterator& operator+=(difference_type n) {
+         if (n >= 0) {
+           for (; n > 0 && idx < end_idx; --n) ++(*this);
+         } else {
+           seek(idx + n);
+         }
+         return *this;
+       }
+       inline bool operator==(const iterator& other) const {
+         return idx == other.idx;
+       }
+       inline bool operator!=(const iterator& other) const {
+         return idx != other.idx;
+       }
+       inline difference_type operator-(const iterator& other) const {
+         return difference_type(idx) - difference_type(other.idx);
+       }
+
+      private:
+       const unsigned char* row_ptr;
+       const unsigned char* ptr;
+       valuetype cur;
+       sizetype row_idx;
+       sizetype idx;
+       sizetype end_idx;
+
+       inline valuetype decode() {
+         valuetype ret = (*ptr) & 0x7f;
+         size_t shift = 7;
+         while (*ptr++ & 0x80) {
+           ret |= valuetype(*ptr & 0x7f) << shift;
+           shift += 7;
+         }
+         return ret;
+       }
+
+       /// Decodes the values of the key from the first up to position i
+       inline void seek(sizetype i) {
+         ptr = row_ptr; idx = row_idx; cur = 0;
+         if (idx < end_idx) cur = decode();
+         while (idx < i) ++(*this);
+       }
+     }; // end of iterator
+     typedef iterator const_iterator;
+
+   public:
+     compressed_csr_storage() { }
+
+     /**
+      * Encodes the values given in the layout of csr_storage::wrap.
+      * The values of key i are value_vec[valueptr_vec[i]] up to
+      * value_vec[valueptr_vec[i+1]] (or the end for the last key) and
+      * must be in ascending order. Keys past the end of valueptr_vec
+      * have no values. num_keys is the number of keys to store.
+      */
+     void build(size_t num_keys,
+                const std::vector<sizetype>& valueptr_vec,
+                const std::vector<valuetype>& value_vec) {
+       clear();
+       value_ptrs.resize(num_keys + 1);
+       byte_ptrs.resize(num_keys + 1);
+       // at most one byte per value when the gaps are small
+       bytes.reserve(value_vec.size() + value_vec.size() / 4);
+       for (size_t i = 0; i < num_keys; ++i) {
+         const size_t begin = i < valueptr_vec.size() ?
+             valueptr_vec[i] : value_vec.size();
+         const size_t end = (i + 1) < valueptr_vec.size() ?
+             valueptr_vec[i + 1] : value_vec.size();
+         value_ptrs[i] = begin;
+         byte_ptrs[i] = bytes.size();
+         valuetype prev = 0;
+         for (size_t j = begin; j < end; ++j) {
+           ASSERT_GE(value_vec[j], prev);
+           encode(value_vec[j] - prev);
+           prev = value_vec[j];
+         }
+       }
+       value_ptrs[num_keys] = value_vec.size();
+       byte_ptrs[num_keys] = bytes.size();
+       std::vector<unsigned char>(bytes).swap(bytes);
+     }
+
+     /// Number of keys in the storage.
+     inline size_t num_keys() const {
+       return value_ptrs.empty() ? 0 : value_ptrs.size() - 1;
+     }
+
+     /// Number of values in the storage.
+     inline size_t num_values() const {
+       return value_ptrs.empty() ? 0 : value_ptrs.back();
+     }
+
+     /// Number of values with key == id
+     inline size_t num_values(size_t id) const {
+       return id < num_keys() ? value_ptrs[id + 1] - value_ptrs[id] : 0;
+     }
+
+     /// Return iterator to the begining value with key == id
+     inline iterator begin(size_t id) const {
+       if (id >= num_keys()) return end_iterator();
+       return iterator(bytes_begin() + byte_ptrs[id], value_ptrs[id],
+                       value_ptrs[id], value_ptrs[id + 1]);
+     }
+
+     /// Return iterator to the ending+1 value with key == id
+     inline iterator end(size_t id) const {
+       if (id >= num_keys()) return end_iterator();
+       return iterator(bytes_begin() + byte_ptrs[id], value_ptrs[id],
+                       value_ptrs[id + 1], value_ptrs[id + 1]);
+     }
+
+     void swap(compressed_csr_storage& other) {
+       value_ptrs.swap(other.value_ptrs);
+       byte_ptrs.swap(other.byte_ptrs);
+       bytes.swap(other.bytes);
+     }
+
+     void clear() {
+       std::vector<sizetype>().swap(value_ptrs);
+       std::vector<size_t>().swap(byte_ptrs);
+       std::vector<unsigned char>().swap(bytes);
+     }
+
+     void load(iarchive& iarc) {
+       clear();
+       iarc >> value_ptrs
+            >> byte_ptrs
+            >> bytes;
+     }
+     void save(oarchive& oarc) const {
+       oarc << value_ptrs
+            << byte_ptrs
+            << bytes;
+     }
+
+     size_t estimate_sizeof() const {
+       return sizeof(value_ptrs) + sizeof(byte_ptrs) + sizeof(bytes) +
+           sizeof(sizetype) * value_ptrs.capacity() +
+           sizeof(size_t) * byte_ptrs.capacity() + bytes.capacity();
+     }
+
+   private:
+     /// The position of the first value of each key, plus the total
+     std::vector<sizetype> value_ptrs;
+     /// The offset in bytes of the first value of each key, plus the total
+     std::vector<size_t> byte_ptrs;
+     /// The gaps between consecutive values, 7 bits per byte, low bits
+     /// first. The high bit is set on all but the last byte of a gap.
+     std::vector<unsigned char> bytes;
+
+     inline const unsigned char* bytes_begin() const {
+       return bytes.empty() ? NULL : &bytes[0];
+     }
+
+     inline iterator end_iterator() const {
+       return iterator(NULL, num_values(), num_values(), num_values());
+     }
+
+     inline void encode(valuetype gap) {
+       while (gap >= 0x80) {
+         bytes.push_back((unsigned char)(gap & 0x7f) | 0x80);
+         gap >>= 7;
+       }
+       bytes.push_back((unsigned char)gap);
+     }
+  }; // end of class
+} // end of graphlab
+#endif
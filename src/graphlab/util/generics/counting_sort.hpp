@@ -27,6 +27,7 @@
 #endif
 
 #include <vector>
+#include <algorithm>
 #include <graphlab/parallel/atomic.hpp>
 
 namespace graphlab {
@@ -75,6 +76,173 @@ namespace graphlab {
         }
       }
     }
+
+
+    /**
+     *  Replaces each element of vec by the sum of the elements before it,
+     *  in parallel blocks. Returns the sum of all the elements.
+     **/
+    template <typename T>
+    T parallel_exclusive_prefix_sum(std::vector<T>& vec) {
+#ifdef _OPENMP
+      const size_t nblocks = omp_get_max_threads();
+#else
+      const size_t nblocks = 1;
+#endif
+      const size_t block_size = (vec.size() + nblocks - 1) / nblocks;
+      std::vector<T> block_sum(nblocks + 1, 0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (ssize_t b = 0; b < ssize_t(nblocks); ++b) {
+        const size_t begin = std::min(b * block_size, vec.size());
+        const size_t end = std::min(begin + block_size, vec.size());
+        T sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += vec[i];
+        block_sum[b + 1] = sum;
+      }
+      for (size_t b = 1; b <= nblocks; ++b) block_sum[b] += block_sum[b - 1];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (ssize_t b = 0; b < ssize_t(nblocks); ++b) {
+        const size_t begin = std::min(b * block_size, vec.size());
+        const size_t end = std::min(begin + block_size, vec.size());
+        T sum = block_sum[b];
+        for (size_t i = begin; i < end; ++i) {
+          const T val = vec[i];
+          vec[i] = sum;
+          sum += val;
+        }
+      }
+      return block_sum[nblocks];
+    }
+
+    /// The smallest number of values given to a thread by
+    /// parallel_counting_scatter
+    static const size_t COUNTING_SCATTER_MIN_CHUNK = 1 << 14;
+
+    /**
+     *  Stable counting sort of value_vec in parallel which, instead of
+     *  building a permutation, calls output(i, pos) with the position pos
+     *  of every value_vec[i] in ascending order, equal values keeping
+     *  their relative order. Fills prefix_array like counting_sort.
+     *
+     *  The values are split into contiguous chunks which are counted and
+     *  placed by one thread each without atomic operations. Each chunk
+     *  works on its own copy of output and calls it for increasing i.
+     *  There is a chunk per thread, but chunks have at least
+     *  COUNTING_SCATTER_MIN_CHUNK values so that small inputs are not
+     *  split into chunks dominated by their per key counters. Every chunk
+     *  has a counter per key, so there are at most nvals / nkeys chunks:
+     *  the counters never outnumber the values, whatever the number of
+     *  threads.
+     **/
+    template <typename valuetype, typename sizetype, typename OutputFn>
+    void parallel_counting_scatter(const std::vector<valuetype>& value_vec,
+                                   std::vector<sizetype>& prefix_array,
+                                   const OutputFn& output) {
+      prefix_array.clear();
+      const size_t nvals = value_vec.size();
+      if(nvals == 0) return;
+
+      valuetype maxval = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(max : maxval)
+#endif
+      for (ssize_t i = 0; i < ssize_t(nvals); ++i) {
+        maxval = std::max(maxval, value_vec[i]);
+      }
+      const size_t nkeys = size_t(maxval) + 1;
+#ifdef _OPENMP
+      size_t nchunks = omp_get_max_threads();
+#else
+      size_t nchunks = 1;
+#endif
+      nchunks = std::min(nchunks, nvals / COUNTING_SCATTER_MIN_CHUNK);
+      nchunks = std::max(size_t(1), std::min(nchunks, nvals / nkeys));
+      const size_t chunk_size = (nvals + nchunks - 1) / nchunks;
+
+      // counts[c * nkeys + k] is the number of values k in chunk c, and
+      // then the position of the next of them in the sorted order.
+      std::vector<sizetype> counts(nchunks * nkeys, 0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (ssize_t c = 0; c < ssize_t(nchunks); ++c) {
+        sizetype* chunk_counts = &counts[c * nkeys];
+        const size_t end = std::min((c + 1) * chunk_size, nvals);
+        for (size_t i = c * chunk_size; i < end; ++i) {
+          ++chunk_counts[value_vec[i]];
+        }
+      }
+
+      prefix_array.resize(nkeys);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (ssize_t k = 0; k < ssize_t(nkeys); ++k) {
+        sizetype total = 0;
+        for (size_t c = 0; c < nchunks; ++c) total += counts[c * nkeys + k];
+        prefix_array[k] = total;
+      }
+      parallel_exclusive_prefix_sum(prefix_array);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (ssize_t k = 0; k < ssize_t(nkeys); ++k) {
+        sizetype pos = prefix_array[k];
+        for (size_t c = 0; c < nchunks; ++c) {
+          const sizetype count = counts[c * nkeys + k];
+          counts[c * nkeys + k] = pos;
+          pos += count;
+        }
+      }
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (ssize_t c = 0; c < ssize_t(nchunks); ++c) {
+        OutputFn chunk_output(output);
+        sizetype* cursor = &counts[c * nkeys];
+        const size_t end = std::min((c + 1) * chunk_size, nvals);
+        for (size_t i = c * chunk_size; i < end; ++i) {
+          chunk_output(i, cursor[value_vec[i]]++);
+        }
+      }
+    }
+
+    namespace counting_sort_impl {
+      /// Writes each index at its position in the sorted order
+      template <typename sizetype>
+      struct permute_output {
+        std::vector<sizetype>* permute_index;
+        permute_output(std::vector<sizetype>* permute_index) :
+          permute_index(permute_index) { }
+        inline void operator()(size_t i, size_t pos) {
+          (*permute_index)[pos] = i;
+        }
+      };
+    } // end of counting_sort_impl
+
+    /**
+     *  Same as counting_sort, but stable and computed by
+     *  parallel_counting_scatter: the indices of equal values are in
+     *  ascending order in permute_index, independently of the number of
+     *  threads.
+     **/
+    template <typename valuetype, typename sizetype>
+    void parallel_counting_sort(const std::vector<valuetype>& value_vec,
+                                std::vector<sizetype>& permute_index,
+                                std::vector<sizetype>* prefix_array = NULL) {
+      std::vector<sizetype> local_prefix;
+      permute_index.resize(value_vec.size());
+      parallel_counting_scatter(value_vec,
+                                prefix_array != NULL ? *prefix_array
+                                                     : local_prefix,
+                                counting_sort_impl::permute_output<sizetype>(
+                                    &permute_index));
+    }
 } // end of graphlab
 
 #endif
@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_LATENCY_HISTOGRAM_HPP
+#define GRAPHLAB_LATENCY_HISTOGRAM_HPP
+
+#include <stdint.h>
+#include <cstring>
+#include <cmath>
+#include <graphlab/serialization/iarchive.hpp>
+#include <graphlab/serialization/oarchive.hpp>
+
+namespace graphlab {
+
+/**
+ * \ingroup util
+ * A histogram of non negative integer values, such as latencies in
+ * cycles, with a bounded relative error in the style of HdrHistogram.
+ *
+ * Values below 16 have a bucket each. Above that, every power of two
+ * is split into 16 equal buckets, so a value is reported with an error
+ * of at most 1/16th. Values of 2^48 and above share the last bucket.
+ * The histogram is about 6KB and add() may be called concurrently.
+ */
+class latency_histogram {
+ public:
+  /// log2 of the number of buckets per power of two
+  static const size_t SUB_BUCKET_BITS = 4;
+  static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+  /// Values with a higher bit set share the last bucket
+  static const size_t MAX_EXPONENT = 47;
+  static const size_t NUM_BUCKETS =
+      (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+  latency_histogram() { clear(); }
+
+  latency_histogram(const latency_histogram& other) {
+    clear();
+    merge(other);
+  }
+
+  latency_histogram& operator=(const latency_histogram& other) {
+    if (this != &other) {
+      clear();
+      merge(other);
+    }
+    return *this;
+  }
+
+  /// Removes all values. Not safe concurrently with add()
+  void clear() {
+    memset((void*)counts, 0, sizeof(counts));
+    total = 0;
+    sum = 0;
+    maxval = 0;
+  }
+
+  /// Records a value
+  inline void add(uint64_t value) {
+    __sync_fetch_and_add(&counts[bucket_of(value)], 1);
+    __sync_fetch_and_add(&total, 1);
+    __sync_fetch_and_add(&sum, value);
+    uint64_t m = maxval;
+    while (value > m) {
+      if (__sync_bool_compare_and_swap(&maxval, m, value)) break;
+      m = maxval;
+    }
+  }
+
+  /// Adds all the values recorded in other
+  void merge(const latency_histogram& other) {
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+      if (other.counts[i]) __sync_fetch_and_add(&counts[i], other.counts[i]);
+    }
+    __sync_fetch_and_add(&total, other.total);
+    __sync_fetch_and_add(&sum, other.sum);
+    uint64_t m = maxval;
+    while (other.maxval > m) {
+      if (__sync_bool_compare_and_swap(&maxval, m, other.maxval)) break;
+      m = maxval;
+    }
+  }
+
+  /// Number of values recorded
+  inline uint64_t count() const { return total; }
+
+  /// Sum of the values recorded
+  inline uint64_t total_sum() const { return sum; }
+
+  /// Largest value recorded, or 0 if empty
+  inline uint64_t max() const { return maxval; }
+
+  /// Mean of the values recorded, or 0 if empty
+  inline double mean() const {
+    return total == 0 ? 0.0 : double(sum) / double(total);
+  }
+
+  /**
+   * Returns a value such that a fraction q of the values recorded are
+   * no larger, up to the bucket precision. q is in [0, 1]. Returns 0 if
+   * the histogram is empty.
+   */
+  uint64_t quantile(double q) const {
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)std::ceil(q * double(total));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        const uint64_t high = bucket_high(i);
+        return high < maxval ? high : maxval;
+      }
+    }
+    return maxval;
+  }
+
+  /// Returns the bucket of a value
+  static inline size_t bucket_of(uint64_t value) {
+    if (value < SUB_BUCKETS) return value;
+    size_t exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT) return NUM_BUCKETS - 1;
+    const size_t shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS +
+        ((value >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  /// Returns the smallest value of a bucket
+  static inline uint64_t bucket_low(size_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    const size_t shift = bucket / SUB_BUCKETS - 1;
+    return (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  }
+
+  /// Returns the largest value of a bucket
+  static inline uint64_t bucket_high(size_t bucket) {
+    if (bucket == NUM_BUCKETS - 1) return uint64_t(-1);
+    return bucket_low(bucket + 1) - 1;
+  }
+
+  /// Only the non empty buckets are written
+  void save(oarchive& oarc) const {
+    size_t nonempty = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) nonempty += (counts[i] != 0);
+    oarc << uint64_t(total) << uint64_t(sum) << uint64_t(maxval) << nonempty;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+      if (counts[i] != 0) oarc << i << uint64_t(counts[i]);
+    }
+  }
+
+  void load(iarchive& iarc) {
+    clear();
+    size_t nonempty = 0;
+    uint64_t t = 0, s = 0, m = 0;
+    iarc >> t >> s >> m >> nonempty;
+    total = t;
+    sum = s;
+    maxval = m;
+    for (size_t j = 0; j < nonempty; ++j) {
+      size_t i = 0;
+      uint64_t c = 0;
+      iarc >> i >> c;
+      if (i < NUM_BUCKETS) counts[i] = c;
+    }
+  }
+
+ private:
+  volatile uint64_t counts[NUM_BUCKETS];
+  volatile uint64_t total;
+  volatile uint64_t sum;
+  volatile uint64_t maxval;
+};
+
+} // namespace graphlab
+#endif
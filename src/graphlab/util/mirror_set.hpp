@@ -0,0 +1,404 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_MIRROR_SET_HPP
+#define GRAPHLAB_MIRROR_SET_HPP
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#include <graphlab/logger/assertions.hpp>
+#include <graphlab/serialization/iarchive.hpp>
+#include <graphlab/serialization/oarchive.hpp>
+
+namespace graphlab {
+
+  /**
+   * A set of process ids which takes 8 bytes whatever the number of
+   * processes, used for the mirrors of a vertex. The set is stored
+   * in one of three ways, in the spirit of small_set:
+   *
+   * \li as a bitset in the 8 bytes when all its ids are below
+   *     INLINE_BITS. This covers every set on clusters of up to
+   *     INLINE_BITS processes.
+   * \li as a sorted list of up to LIST_CAPACITY ids in the 8 bytes.
+   * \li as a bitset allocated on the heap otherwise.
+   *
+   * The interface is the part of fixed_dense_bitset used for mirrors.
+   * Unlike fixed_dense_bitset, set_bit and clear_bit are not atomic.
+   * Ids must be below 65536, the range of procid_t.
+   */
+  class mirror_set {
+   public:
+    /// Ids below this are stored in the inline bitset
+    static const size_t INLINE_BITS = 63;
+    /// The number of ids the inline list holds
+    static const size_t LIST_CAPACITY = 3;
+
+    mirror_set() : rep(BITS_TAG) { }
+
+    mirror_set(const mirror_set& other) : rep(BITS_TAG) {
+      copy_from(other);
+    }
+
+    mirror_set& operator=(const mirror_set& other) {
+      if (this != &other) {
+        clear();
+        copy_from(other);
+      }
+      return *this;
+    }
+
+    ~mirror_set() { clear(); }
+
+    /// Removes all the ids, releasing the heap bitset if any
+    inline void clear() {
+      if (is_heap()) free(heap());
+      rep = BITS_TAG;
+    }
+
+    inline bool empty() const {
+      return popcount() == 0;
+    }
+
+    inline bool get(size_t b) const {
+      if (rep & BITS_TAG) {
+        return b < INLINE_BITS && ((rep >> (b + 1)) & 1);
+      } else if (is_list()) {
+        for (size_t i = 0; i < list_count(); ++i) {
+          if (list_value(i) == b) return true;
+        }
+        return false;
+      } else {
+        const size_t* block = heap();
+        return (b / 64) < block[0] && ((block[1 + b / 64] >> (b % 64)) & 1);
+      }
+    }
+
+    /// Adds the id. Returns whether it was already in the set.
+    inline bool set_bit(size_t b) {
+      DASSERT_LT(b, size_t(65536));
+      if (rep & BITS_TAG) {
+        if (b < INLINE_BITS) {
+          const size_t mask = size_t(1) << (b + 1);
+          const bool ret = rep & mask;
+          rep |= mask;
+          return ret;
+        }
+        rebuild_with(b);
+        return false;
+      } else if (is_list()) {
+        if (get(b)) return true;
+        if (list_count() < LIST_CAPACITY) list_insert(b);
+        else rebuild_with(b);
+        return false;
+      } else {
+        size_t* block = heap();
+        if (b / 64 >= block[0]) {
+          const size_t nwords = block[0];
+          block = (size_t*)realloc(block, sizeof(size_t) * (b / 64 + 2));
+          ASSERT_TRUE(block != NULL);
+          memset(block + 1 + nwords, 0, sizeof(size_t) * (b / 64 + 1 - nwords));
+          block[0] = b / 64 + 1;
+          rep = reinterpret_cast<size_t>(block);
+        }
+        const size_t mask = size_t(1) << (b % 64);
+        const bool ret = block[1 + b / 64] & mask;
+        block[1 + b / 64] |= mask;
+        return ret;
+      }
+    }
+
+    /// Removes the id. Returns whether it was in the set.
+    inline bool clear_bit(size_t b) {
+      if (!get(b)) return false;
+      if (rep & BITS_TAG) {
+        rep &= ~(size_t(1) << (b + 1));
+      } else if (is_list()) {
+        size_t vals[LIST_CAPACITY];
+        size_t n = 0;
+        for (size_t i = 0; i < list_count(); ++i) {
+          if (list_value(i) != b) vals[n++] = list_value(i);
+        }
+        make_list(vals, n);
+      } else {
+        heap()[1 + b / 64] &= ~(size_t(1) << (b % 64));
+      }
+      return true;
+    }
+
+    /// The number of ids in the set
+    inline size_t popcount() const {
+      if (rep & BITS_TAG) {
+        return __builtin_popcountl(rep) - 1;
+      } else if (is_list()) {
+        return list_count();
+      } else {
+        const size_t* block = heap();
+        size_t ret = 0;
+        for (size_t i = 0; i < block[0]; ++i) {
+          ret += __builtin_popcountl(block[1 + i]);
+        }
+        return ret;
+      }
+    }
+
+    /// Sets b to the smallest id. Returns false if the set is empty.
+    inline bool first_bit(size_t& b) const {
+      if (rep & BITS_TAG) {
+        const size_t bits = rep >> 1;
+        if (bits == 0) return false;
+        b = __builtin_ctzl(bits);
+        return true;
+      } else if (is_list()) {
+        if (list_count() == 0) return false;
+        b = list_value(0);
+        return true;
+      } else {
+        return heap_next(0, b);
+      }
+    }
+
+    /**
+     * Sets b to the smallest id after b. Returns false if there is
+     * none, leaving b unchanged.
+     */
+    inline bool next_bit(size_t& b) const {
+      if (rep & BITS_TAG) {
+        if (b + 1 >= INLINE_BITS) return false;
+        const size_t bits = (rep >> 1) >> (b + 1);
+        if (bits == 0) return false;
+        b += 1 + __builtin_ctzl(bits);
+        return true;
+      } else if (is_list()) {
+        for (size_t i = 0; i < list_count(); ++i) {
+          if (list_value(i) > b) {
+            b = list_value(i);
+            return true;
+          }
+        }
+        return false;
+      } else {
+        return heap_next(b + 1, b);
+      }
+    }
+
+    /// Iterates over the ids in ascending order
+    struct bit_pos_iterator {
+      typedef std::forward_iterator_tag iterator_category;
+      typedef size_t value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const size_t reference;
+      typedef const size_t* pointer;
+      size_t pos;
+      const mirror_set* set;
+      bit_pos_iterator() : pos(-1), set(NULL) { }
+      bit_pos_iterator(const mirror_set* set, size_t pos) :
+        pos(pos), set(set) { }
+
+      size_t operator*() const { return pos; }
+      bit_pos_iterator& operator++() {
+        if (set->next_bit(pos) == false) pos = (size_t)(-1);
+        return *this;
+      }
+      bit_pos_iterator operator++(int) {
+        bit_pos_iterator ret = *this;
+        ++(*this);
+        return ret;
+      }
+      bool operator==(const bit_pos_iterator& other) const {
+        return pos == other.pos;
+      }
+      bool operator!=(const bit_pos_iterator& other) const {
+        return pos != other.pos;
+      }
+    };
+
+    typedef bit_pos_iterator iterator;
+    typedef bit_pos_iterator const_iterator;
+
+    bit_pos_iterator begin() const {
+      size_t pos;
+      if (first_bit(pos) == false) pos = size_t(-1);
+      return bit_pos_iterator(this, pos);
+    }
+
+    bit_pos_iterator end() const {
+      return bit_pos_iterator(this, (size_t)(-1));
+    }
+
+    mirror_set& operator|=(const mirror_set& other) {
+      for (iterator it = other.begin(); it != other.end(); ++it) set_bit(*it);
+      return *this;
+    }
+
+    mirror_set operator|(const mirror_set& other) const {
+      mirror_set ret(*this);
+      ret |= other;
+      return ret;
+    }
+
+    /// Compares the ids, whatever the representations
+    bool operator==(const mirror_set& other) const {
+      iterator a = begin(), b = other.begin();
+      while (a != end() && b != other.end()) {
+        if (*a != *b) return false;
+        ++a; ++b;
+      }
+      return a == end() && b == other.end();
+    }
+
+    bool operator!=(const mirror_set& other) const {
+      return !(*this == other);
+    }
+
+    void swap(mirror_set& other) {
+      std::swap(rep, other.rep);
+    }
+
+    void save(oarchive& oarc) const {
+      oarc << uint32_t(popcount());
+      for (iterator it = begin(); it != end(); ++it) oarc << uint16_t(*it);
+    }
+
+    void load(iarchive& iarc) {
+      clear();
+      uint32_t n;
+      iarc >> n;
+      for (size_t i = 0; i < n; ++i) {
+        uint16_t b;
+        iarc >> b;
+        set_bit(b);
+      }
+    }
+
+   private:
+    /**
+     * With the low bit set, bits 1 to INLINE_BITS hold the ids 0 to
+     * INLINE_BITS - 1. With the low bits 10, bits 2-3 hold the length of
+     * the list and its ids are the 16 bit fields from bit 16 up.
+     * Otherwise it points to the heap bitset, a word holding the number
+     * of words of bits followed by the bits.
+     */
+    size_t rep;
+
+    static const size_t BITS_TAG = 1;
+    static const size_t LIST_TAG = 2;
+
+    inline bool is_list() const { return (rep & 3) == LIST_TAG; }
+    inline bool is_heap() const { return (rep & 3) == 0; }
+    inline size_t* heap() const { return reinterpret_cast<size_t*>(rep); }
+
+    inline size_t list_count() const { return (rep >> 2) & 3; }
+    inline size_t list_value(size_t i) const {
+      return (rep >> (16 * (i + 1))) & 0xffff;
+    }
+
+    /// Stores the n ids, which must be in ascending order
+    inline void make_list(const size_t* vals, size_t n) {
+      rep = LIST_TAG | (n << 2);
+      for (size_t i = 0; i < n; ++i) rep |= vals[i] << (16 * (i + 1));
+    }
+
+    inline void list_insert(size_t b) {
+      size_t vals[LIST_CAPACITY];
+      size_t n = 0;
+      bool inserted = false;
+      for (size_t i = 0; i < list_count(); ++i) {
+        if (!inserted && b < list_value(i)) {
+          vals[n++] = b;
+          inserted = true;
+        }
+        vals[n++] = list_value(i);
+      }
+      if (!inserted) vals[n++] = b;
+      make_list(vals, n);
+    }
+
+    /**
+     * Moves an inline set to the smallest representation which holds
+     * its ids and b, which must not be in the set.
+     */
+    void rebuild_with(size_t b) {
+      size_t vals[INLINE_BITS + 1];
+      size_t n = 0, maxval = b;
+      bool inserted = false;
+      for (iterator it = begin(); it != end(); ++it) {
+        if (!inserted && b < *it) {
+          vals[n++] = b;
+          inserted = true;
+        }
+        vals[n++] = *it;
+        maxval = std::max(maxval, *it);
+      }
+      if (!inserted) vals[n++] = b;
+
+      if (n <= LIST_CAPACITY) {
+        make_list(vals, n);
+      } else if (maxval < INLINE_BITS) {
+        rep = BITS_TAG;
+        for (size_t i = 0; i < n; ++i) rep |= size_t(1) << (vals[i] + 1);
+      } else {
+        const size_t nwords = maxval / 64 + 1;
+        size_t* block = (size_t*)calloc(nwords + 1, sizeof(size_t));
+        ASSERT_TRUE(block != NULL);
+        block[0] = nwords;
+        for (size_t i = 0; i < n; ++i) {
+          block[1 + vals[i] / 64] |= size_t(1) << (vals[i] % 64);
+        }
+        rep = reinterpret_cast<size_t>(block);
+      }
+    }
+
+    /// Sets b to the first id of the heap bitset at or after start
+    inline bool heap_next(size_t start, size_t& b) const {
+      const size_t* block = heap();
+      for (size_t i = start / 64; i < block[0]; ++i) {
+        size_t word = block[1 + i];
+        if (i == start / 64) word &= ~((size_t(1) << (start % 64)) - 1);
+        if (word != 0) {
+          b = i * 64 + __builtin_ctzl(word);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    inline void copy_from(const mirror_set& other) {
+      if (other.is_heap()) {
+        const size_t bytes = sizeof(size_t) * (other.heap()[0] + 1);
+        size_t* block = (size_t*)malloc(bytes);
+        ASSERT_TRUE(block != NULL);
+        memcpy(block, other.heap(), bytes);
+        rep = reinterpret_cast<size_t>(block);
+      } else {
+        rep = other.rep;
+      }
+    }
+  }; // end of mirror_set
+
+} // end of graphlab
+
+#endif
@@ -581,6 +581,40 @@ namespace graphlab {
     }
 
 
+    /**
+     * \brief Returns the set of edges on which to run the gather
+     * function during a dense (pull) super-step of the direction
+     * optimizing synchronous engine. The default is graphlab::NO_EDGES.
+     *
+     * Push style programs (such as single source shortest path or
+     * connected components) propagate updates by signaling neighbors
+     * in scatter. When the synchronous engine is run with the
+     * \c direction_optimizing option and the frontier (the vertices
+     * which would scatter) touches a large fraction of the edges, the
+     * engine skips the scatter and instead runs every vertex, gathering
+     * over pull_edges() in place of gather_edges(). The gather over
+     * pull_edges() must therefore compute the same update that the
+     * messages of the scatter would have delivered, and the vertex
+     * program is initialized with a default message.
+     *
+     * This function is ignored by all other engines.
+     *
+     * \param [in,out] context The context is used to interact with
+     * the engine
+     *
+     * \param [in] vertex The vertex on which this vertex-program is
+     * running. Note that the vertex is constant and its value should
+     * not be modified.
+     *
+     * \return One of graphlab::NO_EDGES, graphlab::IN_EDGES,
+     * graphlab::OUT_EDGES, or graphlab::ALL_EDGES.
+     */
+    virtual edge_dir_type pull_edges(icontext_type& context,
+                                     const vertex_type& vertex) const {
+      return NO_EDGES;
+    }
+
+
     /**
      * \brief The gather function is called on all the 
      * \ref ivertex_program::gather_edges in parallel and returns the 
@@ -155,6 +155,76 @@ void test_all_neighbors(graphlab::distributed_control& dc,
 
 
 
+// Propagates the largest vertex id through each connected component.
+// Under vertex consistency the mirrors are updated lazily, so once the
+// engine terminates both ends of every edge must agree on every machine.
+struct max_gather : public graphlab::IS_POD_TYPE {
+  int value;
+  max_gather(int value = 0) : value(value) { }
+  max_gather& operator+=(const max_gather& other) {
+    value = std::max(value, other.value);
+    return *this;
+  }
+};
+
+class propagate_max :
+  public graphlab::ivertex_program<graph_type, max_gather>,
+  public graphlab::IS_POD_TYPE {
+public:
+  edge_dir_type
+  gather_edges(icontext_type& context, const vertex_type& vertex) const {
+    return graphlab::ALL_EDGES;
+  }
+  gather_type
+  gather(icontext_type& context, const vertex_type& vertex,
+         edge_type& edge) const {
+    return edge.source().id() == vertex.id() ?
+        edge.target().data() : edge.source().data();
+  }
+  void apply(icontext_type& context, vertex_type& vertex,
+             const gather_type& total) {
+    vertex.data() = std::max(vertex.data(), total.value);
+  }
+  edge_dir_type
+  scatter_edges(icontext_type& context, const vertex_type& vertex) const {
+    return graphlab::ALL_EDGES;
+  }
+  void scatter(icontext_type& context, const vertex_type& vertex,
+               edge_type& edge) const {
+    vertex_type other = edge.source().id() == vertex.id() ?
+        edge.target() : edge.source();
+    if (other.data() < vertex.data()) context.signal(other);
+  }
+}; // end of propagate max
+
+void set_vertex_to_id(graph_type::vertex_type vtx) {
+  vtx.data() = vtx.id();
+}
+
+size_t count_unequal_edges(graph_type::edge_type e) {
+  return e.source().data() != e.target().data();
+}
+
+void test_vertex_consistency(graphlab::distributed_control& dc,
+                             graphlab::command_line_options& clopts,
+                             graph_type& graph) {
+  std::cout << "Constructing a vertex consistent engine for max propagation"
+            << std::endl;
+  graphlab::command_line_options opts = clopts;
+  opts.get_engine_args().set_option("consistency", std::string("vertex"));
+  typedef graphlab::async_consistent_engine<propagate_max> engine_type;
+  engine_type engine(dc, graph, opts);
+  graph.transform_vertices(set_vertex_to_id);
+  std::cout << "Scheduling all vertices to propagate the max" << std::endl;
+  engine.signal_all();
+  std::cout << "Running!" << std::endl;
+  engine.start();
+  ASSERT_EQ(graph.map_reduce_edges<size_t>(count_unequal_edges), size_t(0));
+  std::cout << "Finished" << std::endl;
+}
+
+
+
 
 
 
@@ -328,6 +398,7 @@ int main(int argc, char** argv) {
   test_in_neighbors(dc, clopts, graph);
   test_out_neighbors(dc, clopts, graph);
   test_all_neighbors(dc, clopts, graph);
+  test_vertex_consistency(dc, clopts, graph);
   test_aggregator(dc, clopts, graph);
   graphlab::mpi_tools::finalize();
 } // end of main
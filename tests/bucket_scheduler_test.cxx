@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/scheduler/bucket_scheduler.hpp>
+#include "scheduler_rounds.hpp"
+using namespace graphlab;
+
+// each round of a vertex goes into a lower bucket
+double lower_bucket_priority(lvid_type v, size_t t) {
+  return double(v % 5 + t);
+}
+
+class BucketSchedulerTestSuite : public CxxTest::TestSuite {
+public:
+  void test_buckets(void) {
+    // without sync, each bucket is opened once the lower ones are drained
+    graphlab_options opts;
+    opts.set_ncpus(4);
+    opts.get_scheduler_args().set_option("delta", 10.0);
+    opts.get_scheduler_args().set_option("sync", false);
+    bucket_scheduler sched(NUM_VERTICES, opts);
+    for (size_t i = 0; i < NUM_VERTICES; ++i) sched.schedule(i, -double(i));
+    // moves to a lower bucket, not to a higher one
+    sched.schedule(1000, 0);
+    sched.schedule(0, -500);
+    lvid_type v;
+    TS_ASSERT_EQUALS(sched.get_next(0, v), sched_status::NEW_TASK);
+    std::vector<size_t> order(1, v);
+    while (sched.get_next(v % 4, v) == sched_status::NEW_TASK) {
+      order.push_back(v);
+    }
+    TS_ASSERT_EQUALS(order.size(), NUM_VERTICES);
+    std::vector<size_t> count(NUM_VERTICES, 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+      ++count[order[i]];
+      const size_t d = order[i] == 1000 ? 0 : order[i];
+      // vertices of a bucket run together, in increasing buckets
+      TS_ASSERT_EQUALS(d / 10, i < 11 ? 0 : (i - 1) / 10);
+    }
+    for (size_t i = 0; i < NUM_VERTICES; ++i) TS_ASSERT_EQUALS(count[i], 1);
+    TS_ASSERT(sched.empty());
+  }
+
+  void test_rounds(void) {
+    // with sync, the buckets are only opened by start_round()
+    graphlab_options opts;
+    opts.set_ncpus(2);
+    bucket_scheduler sched(NUM_VERTICES, opts);
+    double round = 0;
+    TS_ASSERT(!sched.next_round(round));
+    sched.schedule(3, -2.5);
+    sched.schedule(4, -2.1);
+    sched.schedule(5, -7);
+    lvid_type v;
+    TS_ASSERT_EQUALS(sched.get_next(0, v), sched_status::EMPTY);
+    TS_ASSERT(!sched.empty());
+    TS_ASSERT(sched.next_round(round));
+    TS_ASSERT_EQUALS(round, 2);
+    sched.start_round(round);
+    std::vector<size_t> count(NUM_VERTICES, 0);
+    while (sched.get_next(0, v) == sched_status::NEW_TASK) ++count[v];
+    TS_ASSERT_EQUALS(count[3] + count[4], 2);
+    TS_ASSERT_EQUALS(count[5], 0);
+    // a vertex of a lower bucket runs at once
+    sched.schedule(6, 100);
+    TS_ASSERT_EQUALS(sched.get_next(1, v), sched_status::NEW_TASK);
+    TS_ASSERT_EQUALS(v, 6);
+    TS_ASSERT(sched.next_round(round));
+    TS_ASSERT_EQUALS(round, 7);
+    sched.start_round(round);
+    TS_ASSERT_EQUALS(sched.get_next(1, v), sched_status::NEW_TASK);
+    TS_ASSERT_EQUALS(v, 5);
+    TS_ASSERT_EQUALS(sched.get_next(1, v), sched_status::EMPTY);
+    TS_ASSERT(!sched.next_round(round));
+    TS_ASSERT(sched.empty());
+  }
+
+  void test_scheduler_fibers(void) {
+    graphlab_options opts;
+    opts.get_scheduler_args().set_option("sync", false);
+    test_scheduler_rounds<bucket_scheduler>(opts, lower_bucket_priority, true);
+  }
+
+  void test_scheduler_threads(void) {
+    graphlab_options opts;
+    opts.get_scheduler_args().set_option("sync", false);
+    test_scheduler_rounds<bucket_scheduler>(opts, lower_bucket_priority, false);
+  }
+};
@@ -24,6 +24,7 @@
 
 #include <graphlab/util/generics/csr_storage.hpp>
 #include <graphlab/util/generics/dynamic_csr_storage.hpp>
+#include <graphlab/util/generics/compressed_csr_storage.hpp>
 #include <graphlab/util/generics/shuffle.hpp>
 #include <graphlab/logger/assertions.hpp>
 
@@ -80,6 +81,66 @@ class csr_storage_test : public CxxTest::TestSuite {
     printf("+ Pass test: csr_storage wrap :)\n\n");
   }
 
+  void test_compressed_csr_storage() {
+    std::cout << "Test compressed_csr_storage build" << std::endl;
+    typedef graphlab::compressed_csr_storage<size_t, sizetype> ccsr_t;
+    // key i holds the sorted values i, i + 3, i + 3 + 200, ... with gaps
+    // which need 1, 2 and 3 varint bytes.
+    const size_t nkeys = 50;
+    std::vector<sizetype> prefix;
+    std::vector<size_t> values;
+    for (size_t i = 0; i < nkeys; ++i) {
+      prefix.push_back(values.size());
+      size_t val = i * 100000;
+      for (size_t j = 0; j < i % 7; ++j) {
+        values.push_back(val);
+        val += (j % 3 == 0) ? 3 : (j % 3 == 1) ? 200 : 70000;
+      }
+    }
+    ccsr_t csr;
+    csr.build(nkeys + 2, prefix, values);
+    ASSERT_EQ(csr.num_keys(), nkeys + 2);
+    ASSERT_EQ(csr.num_values(), values.size());
+    for (size_t i = 0; i < nkeys + 2; ++i) {
+      const size_t begin = i < nkeys ? prefix[i] : values.size();
+      ASSERT_EQ(csr.num_values(i), (i < nkeys ? i % 7 : 0));
+      ASSERT_EQ(csr.end(i) - csr.begin(i), csr.num_values(i));
+      size_t j = begin;
+      for (ccsr_t::iterator it = csr.begin(i); it != csr.end(i); ++it, ++j) {
+        ASSERT_EQ(*it, values[j]);
+        ASSERT_EQ(it.index(), j);
+      }
+      // random access from the end of the key
+      for (size_t k = 0; k < csr.num_values(i); ++k) {
+        ccsr_t::iterator it = csr.end(i);
+        it += -(ptrdiff_t)(k + 1);
+        ASSERT_EQ(*it, values[begin + csr.num_values(i) - k - 1]);
+      }
+    }
+    printf("+ Pass test: compressed_csr_storage build :)\n\n");
+  }
+
+  void test_parallel_counting_sort() {
+    std::cout << "Test parallel_counting_sort" << std::endl;
+    // enough values to be split into several chunks, with about eight
+    // values per key
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < 400000; ++i) keys.push_back((i * 7919) % 50021);
+    std::vector<sizetype> permute_index, prefix;
+    std::vector<sizetype> expected_permute, expected_prefix;
+    graphlab::parallel_counting_sort(keys, permute_index, &prefix);
+    graphlab::counting_sort(keys, expected_permute, &expected_prefix);
+    ASSERT_TRUE(prefix == expected_prefix);
+    ASSERT_EQ(permute_index.size(), keys.size());
+    for (size_t i = 1; i < permute_index.size(); ++i) {
+      // sorted, and stable
+      const size_t prev = permute_index[i - 1], cur = permute_index[i];
+      ASSERT_TRUE(keys[prev] < keys[cur] ||
+                  (keys[prev] == keys[cur] && prev < cur));
+    }
+    printf("+ Pass test: parallel_counting_sort :)\n\n");
+  }
+
   template<typename csr_type>
   void dynamic_csr_storage_constructor_test() {
     std::cout << "Test dynamic csr_storage constructor" << std::endl;
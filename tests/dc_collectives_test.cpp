@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/util/mpi_tools.hpp>
+#include <graphlab/rpc/dc_init_from_mpi.hpp>
+#include <graphlab/util/timer.hpp>
+#include <graphlab/util/stl_util.hpp>
+using namespace graphlab;
+
+
+/*
+ * Checks broadcast, all_gather and all_reduce on any number of machines.
+ * Run it with a number of machines which is not a power of 2 (3, 5, 6)
+ * as well, since all_reduce folds in the machines past the largest
+ * power of 2 separately.
+ */
+
+// does not commute: the result depends on the order of the reduction
+struct concat_plus_equal {
+  void operator()(std::string& a, const std::string& b) const {
+    a += b;
+  }
+};
+
+
+class collectives_test {
+ public:
+  dc_dist_object<collectives_test> rmi;
+
+  collectives_test(distributed_control &dc):rmi(dc, this) {
+    rmi.barrier();
+  }
+
+  procid_t procid() const { return rmi.procid(); }
+  procid_t numprocs() const { return rmi.numprocs(); }
+
+  /// Every machine must hold the same value
+  template <typename U>
+  void check_identical(const U& val) {
+    std::vector<U> all(numprocs());
+    all[procid()] = val;
+    rmi.all_gather(all);
+    for (procid_t i = 0; i < numprocs(); ++i) {
+      ASSERT_TRUE(all[i] == val);
+    }
+  }
+
+  void test_all_gather(size_t iter, bool control) {
+    std::vector<std::string> data(numprocs());
+    data[procid()] = std::string(procid() + iter % 3 + 1, char('a' + procid()));
+    rmi.all_gather(data, control);
+    for (procid_t i = 0; i < numprocs(); ++i) {
+      ASSERT_EQ(data[i], std::string(i + iter % 3 + 1, char('a' + i)));
+    }
+  }
+
+  void test_broadcast(procid_t originator, size_t iter, bool control) {
+    std::vector<size_t> data;
+    if (procid() == originator) {
+      for (size_t i = 0; i < originator + 3; ++i) {
+        data.push_back(originator * 1000 + iter + i);
+      }
+    }
+    rmi.broadcast(data, procid() == originator, control);
+    ASSERT_EQ(data.size(), originator + 3);
+    for (size_t i = 0; i < data.size(); ++i) {
+      ASSERT_EQ(data[i], originator * 1000 + iter + i);
+    }
+  }
+
+  void test_all_reduce(size_t iter, bool control) {
+    size_t sum = procid() + iter;
+    rmi.all_reduce(sum, control);
+    const size_t n = numprocs();
+    ASSERT_EQ(sum, n * (n - 1) / 2 + n * iter);
+  }
+
+  /// Reductions which depend on the order of the values must still
+  /// give the same result on all machines
+  void test_all_reduce_identical() {
+    std::string order = tostr(procid()) + ",";
+    rmi.all_reduce2(order, concat_plus_equal());
+    // each machine appears exactly once
+    std::vector<std::string> ids = strsplit(order, ",");
+    std::set<std::string> distinct(ids.begin(), ids.end());
+    distinct.erase("");
+    ASSERT_EQ(distinct.size(), numprocs());
+    check_identical(order);
+
+    // floating point addition is not associative
+    double val = 1.0 / (procid() + 3) + (procid() % 2 ? 1e16 : -1e16);
+    rmi.all_reduce(val);
+    check_identical(val);
+  }
+
+  /// Runs the collectives back to back without barriers, with one machine
+  /// late in each iteration, so that the messages of a collective may
+  /// arrive before the previous one completes
+  void test_back_to_back(size_t niters) {
+    for (size_t i = 0; i < niters; ++i) {
+      const bool control = (i % 2 == 1);
+      if (procid() == i % numprocs()) timer::sleep_ms(1);
+      test_all_gather(i, control);
+      test_all_reduce(i, control);
+      test_all_reduce(i + 1, !control);
+      test_all_gather(i + 1, !control);
+      if (i % 4 == 0) test_broadcast(i % numprocs(), i, control);
+    }
+  }
+};
+
+
+int main(int argc, char ** argv) {
+  /** Initialization */
+  mpi_tools::init(argc, argv);
+  global_logger().set_log_level(LOG_INFO);
+
+  dc_init_param param;
+  if (init_param_from_mpi(param) == false) {
+    return 0;
+  }
+  distributed_control dc(param);
+  collectives_test test(dc);
+
+  test.test_all_gather(0, false);
+  test.test_all_reduce(0, false);
+  // every machine originates a broadcast in turn, machine 0 last
+  for (procid_t i = 1; i <= dc.numprocs(); ++i) {
+    test.test_broadcast(i % dc.numprocs(), 0, false);
+  }
+  test.test_all_reduce_identical();
+  test.test_back_to_back(200);
+
+  dc.full_barrier();
+  if (dc.procid() == 0) {
+    std::cout << "Collectives passed on " << dc.numprocs()
+              << " machines" << std::endl;
+  }
+  mpi_tools::finalize();
+}
@@ -43,6 +43,7 @@ std::vector<graphlab::vertex_id_type> lockable_vertices;
 boost::unordered_map<graphlab::vertex_id_type, size_t> demand_set;
 boost::unordered_map<graphlab::vertex_id_type, size_t> current_demand_set;
 boost::unordered_map<graphlab::vertex_id_type, size_t> locked_set;
+std::vector<bool> eating;
 size_t nlocksacquired ;
 
 size_t nlocks_to_acquire;
@@ -73,6 +74,15 @@ void callback(graphlab::vertex_id_type v) {
   //logstream(LOG_INFO) << "Locked " << ggraph->global_vid(v) << std::endl;
   mt.lock();
   ASSERT_EQ(current_demand_set[v], 1);
+  // no local neighbor may be eating at the same time
+  graph_type::local_vertex_type lvertex(ggraph->l_vertex(v));
+  foreach(graph_type::local_edge_type edge, lvertex.in_edges()) {
+    ASSERT_FALSE(eating[edge.source().id()]);
+  }
+  foreach(graph_type::local_edge_type edge, lvertex.out_edges()) {
+    ASSERT_FALSE(eating[edge.target().id()]);
+  }
+  eating[v] = true;
   locked_set[v]++;
   nlocksacquired++;
   mt.unlock();
@@ -81,12 +91,22 @@ void callback(graphlab::vertex_id_type v) {
 }
 
 
+// takes the fast path when it is available
+void acquire(graphlab::vertex_id_type v) {
+  if (locks->try_make_philosopher_eat(v)) callback(v);
+  else locks->make_philosopher_hungry(v);
+}
+
+
 void thread_stuff() {
   std::pair<graphlab::vertex_id_type, bool> deq;
   while(1) {
     deq = locked_elements.dequeue();
     if (deq.second == false) break;
     else {
+      mt.lock();
+      eating[deq.first] = false;
+      mt.unlock();
       locks->philosopher_stops_eating(deq.first);
       mt.lock();
       current_demand_set[deq.first] = 0;
@@ -115,7 +135,7 @@ void thread_stuff() {
           }
           mt.unlock();
         }
-        locks->make_philosopher_hungry(toacquire);
+        acquire(toacquire);
       }
     }
   }
@@ -250,6 +270,7 @@ int main(int argc, char** argv) {
   dc.barrier();
   locks = new graphlab::distributed_chandy_misra<graph_type>(dc, graph, callback);
   nlocksacquired = 0;
+  eating.resize(graph.num_local_vertices(), false);
   nlocks_to_acquire = INITIAL_NLOCKS_TO_ACQUIRE;
   dc.full_barrier();
   for (graphlab::vertex_id_type v = 0; v < graph.num_local_vertices(); ++v) {
@@ -267,7 +288,7 @@ int main(int argc, char** argv) {
   for (graphlab::vertex_id_type v = 0; v < graph.num_local_vertices(); ++v) {
     if (graph.l_get_vertex_record(v).owner == dc.procid()) {
       //std::cout << dc.procid() << ": Lock Req for " << graph.l_get_vertex_record(v).gvid << std::endl;
-      locks->make_philosopher_hungry(v);
+      acquire(v);
     }
   }
   mt.lock();
@@ -104,6 +104,22 @@ class distributed_graph_test  {
      }
    }
 
+   /**
+    * Test adding edges with streaming ingress. Enough edges are added
+    * for the received edges to be moved into the local graph before
+    * finalize.
+    */
+   void test_streaming_add_edge() {
+     graphlab::graphlab_options opts;
+     opts.get_graph_args().set_option("streaming_ingress", true);
+     graphlab::distributed_graph<vertex_data, edge_data> g(*dc, opts);
+     test_add_edge_impl(g, 200000);
+     if (g.is_dynamic()) {
+       test_add_edge_impl(g, 200000, true);
+     }
+     dc->cout() << "\n+ Pass test: graph streaming add edge. :) \n";
+   }
+
    /**
     * Test save load
     */
@@ -113,13 +129,15 @@ class distributed_graph_test  {
        g.add_edge(i, (i+1), edge_data(i, i+1));
      }
      g.finalize();
-     test_save_load_impl(g);
+     test_save_load_impl(g, "bin");
+     test_save_load_impl(g, "binmmap");
      if (g.is_dynamic()) {
        for (size_t i = 0; i < 10; ++i) {
          g.add_edge(i+1, (i), edge_data(i+1, i));
        }
        g.finalize();
-       test_save_load_impl(g);
+       test_save_load_impl(g, "bin");
+       test_save_load_impl(g, "binmmap");
      }
      dc->cout() << "\n+ Pass test: graph save load binary. :) \n";
    }
@@ -201,7 +219,7 @@ class distributed_graph_test  {
        }
 
    template<typename Graph>
-       void test_save_load_impl(Graph& g) {
+       void test_save_load_impl(Graph& g, const std::string& format) {
          typedef typename Graph::local_edge_type local_edge_type;
 
          using namespace boost::filesystem;
@@ -210,10 +228,10 @@ class distributed_graph_test  {
            path prefix = ph;
            prefix /= "test"; 
            dc->cout() << "Save to path: " << prefix.string() << std::endl;
-           g.save_binary(prefix.string());
+           g.save_format(prefix.string(), format);
 
            Graph g2(*dc);
-           g2.load_binary(prefix.string());
+           g2.load_format(prefix.string(), format);
            ASSERT_EQ(g.num_vertices(), g2.num_vertices());
            ASSERT_EQ(g.num_edges(), g2.num_edges());
 
@@ -505,6 +523,7 @@ int main(int argc, char** argv) {
   testsuit.test_add_vertex();
   testsuit.test_add_edge();
   testsuit.test_dynamic_add_edge();
+  testsuit.test_streaming_add_edge();
   testsuit.test_save_load();
 
   delete(dc);
@@ -0,0 +1,94 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+#include <cstdlib>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+
+#include <graphlab/rpc/exchange_compression.hpp>
+
+class exchange_compression_test : public CxxTest::TestSuite {
+ public:
+  void test_random_bytes() {
+    std::vector<char> data(100000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = rand();
+    round_trip(data);
+  }
+
+  void test_id_value_pairs() {
+    // (vertex id, value) pairs with increasing ids and repeated values
+    std::vector<char> data;
+    uint32_t id = 1000000;
+    double value = 0.15;
+    for (size_t i = 0; i < 20000; ++i) {
+      id += rand() % 8;
+      if (rand() % 4 == 0) value = rand() % 10;
+      data.insert(data.end(), (char*)&id, (char*)&id + sizeof(id));
+      data.insert(data.end(), (char*)&value, (char*)&value + sizeof(value));
+    }
+    size_t complen = round_trip(data);
+    TS_ASSERT_LESS_THAN(complen, data.size() / 2);
+  }
+
+  void test_long_runs() {
+    std::vector<char> data(70000, 'a');
+    data.push_back('b');
+    size_t complen = round_trip(data);
+    TS_ASSERT_LESS_THAN(complen, 1000);
+  }
+
+  void test_short_inputs() {
+    for (size_t len = 0; len < 20; ++len) {
+      std::vector<char> data(len, 'x');
+      round_trip(data);
+    }
+  }
+
+  void test_corrupt_input() {
+    std::vector<char> data(10000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = rand() % 4;
+    std::vector<char> compressed(codec.max_compressed_size(data.size()));
+    size_t complen = codec.compress(&data[0], data.size(), &compressed[0]);
+    std::vector<char> out(data.size());
+    // truncated
+    TS_ASSERT(!codec.decompress(&compressed[0], complen - 1,
+                                &out[0], out.size()));
+    // wrong length
+    TS_ASSERT(!codec.decompress(&compressed[0], complen,
+                                &out[0], out.size() - 1));
+  }
+
+ private:
+  graphlab::dc_impl::lz_exchange_codec codec;
+
+  size_t round_trip(const std::vector<char>& data) {
+    std::vector<char> compressed(codec.max_compressed_size(data.size()));
+    size_t complen = codec.compress(data.empty() ? NULL : &data[0],
+                                    data.size(), &compressed[0]);
+    TS_ASSERT_LESS_THAN_EQUALS(complen, compressed.size());
+    std::vector<char> out(data.size() + 1);
+    TS_ASSERT(codec.decompress(&compressed[0], complen,
+                               &out[0], data.size()));
+    out.resize(data.size());
+    TS_ASSERT(out == data);
+    return complen;
+  }
+};
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <set>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/util/frontier_bitset.hpp>
+#include <graphlab/macros_def.hpp>
+using namespace graphlab;
+
+class FrontierBitsetTestSuite : public CxxTest::TestSuite {
+public:
+
+  std::set<size_t> enumerate(frontier_bitset& f) {
+    std::set<size_t> ret;
+    atomic<size_t> counter(0);
+    f.begin_iteration();
+    frontier_bitset::parallel_iterator iter(f, counter);
+    size_t b;
+    while (iter.next(b)) {
+      TS_ASSERT(ret.count(b) == 0);
+      ret.insert(b);
+    }
+    return ret;
+  }
+
+  void test_sparse_and_dense(void) {
+    frontier_bitset f;
+    f.set_density_threshold(0.05);
+    f.resize(1000);
+    f.clear();
+    TS_ASSERT(f.is_sparse());
+    size_t probelocations[7] = {0, 10, 12, 50, 66, 810, 999};
+    for (size_t i = 0;i < 7; ++i) {
+      TS_ASSERT_EQUALS(f.set_bit(probelocations[i]), false);
+      // setting a bit twice does not list it twice
+      TS_ASSERT_EQUALS(f.set_bit(probelocations[i]), true);
+    }
+    TS_ASSERT(f.is_sparse());
+    std::set<size_t> expected(probelocations, probelocations + 7);
+    TS_ASSERT(enumerate(f) == expected);
+
+    // cleared bits are skipped
+    f.clear_bit(10);
+    expected.erase(10);
+    TS_ASSERT(enumerate(f) == expected);
+
+    // the sparse clear must reset every listed bit
+    f.clear();
+    for (size_t i = 0;i < 1000; ++i) TS_ASSERT_EQUALS(f.get(i), false);
+    TS_ASSERT(enumerate(f).empty());
+
+    // overflowing the list switches to the dense scan
+    expected.clear();
+    for (size_t i = 0;i < 1000; i += 7) {
+      f.set_bit(i);
+      expected.insert(i);
+    }
+    TS_ASSERT(!f.is_sparse());
+    TS_ASSERT(enumerate(f) == expected);
+    f.clear();
+    TS_ASSERT(f.is_sparse());
+    for (size_t i = 0;i < 1000; ++i) TS_ASSERT_EQUALS(f.get(i), false);
+
+    f.fill();
+    TS_ASSERT_EQUALS(enumerate(f).size(), 1000);
+  }
+
+  void test_serialization(void) {
+    frontier_bitset f;
+    f.set_density_threshold(0.05);
+    f.resize(100);
+    f.clear();
+    f.set_bit(3); f.set_bit(97);
+
+    std::stringstream strm;
+    graphlab::oarchive oarc(strm);
+    oarc << f;
+    strm.flush();
+    graphlab::iarchive iarc(strm);
+    frontier_bitset f2;
+    f2.set_density_threshold(0.05);
+    iarc >> f2;
+    TS_ASSERT_EQUALS(f2.size(), 100);
+    std::set<size_t> expected;
+    expected.insert(3); expected.insert(97);
+    TS_ASSERT(enumerate(f2) == expected);
+    // a loaded bitset is dense until cleared
+    f2.clear();
+    TS_ASSERT(enumerate(f2).empty());
+    TS_ASSERT_EQUALS(f2.get(97), false);
+  }
+};
+
+#include <graphlab/macros_undef.hpp>
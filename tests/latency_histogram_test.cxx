@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/util/latency_histogram.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+using namespace graphlab;
+
+void add_values(latency_histogram* h, size_t n) {
+  for (size_t i = 0; i < n; ++i) h->add(i);
+}
+
+class LatencyHistogramTestSuite : public CxxTest::TestSuite {
+public:
+  void test_buckets(void) {
+    // every value is within its bucket, and the buckets are contiguous
+    for (size_t b = 0; b + 1 < latency_histogram::NUM_BUCKETS; ++b) {
+      TS_ASSERT_EQUALS(latency_histogram::bucket_high(b) + 1,
+                       latency_histogram::bucket_low(b + 1));
+    }
+    srand(1);
+    for (size_t i = 0; i < 100000; ++i) {
+      uint64_t v = (uint64_t(rand()) << (rand() % 17)) + rand() % 16;
+      size_t b = latency_histogram::bucket_of(v);
+      TS_ASSERT(latency_histogram::bucket_low(b) <= v);
+      TS_ASSERT(v <= latency_histogram::bucket_high(b));
+      // the relative error is at most 1/16th
+      TS_ASSERT(latency_histogram::bucket_high(b) -
+                latency_histogram::bucket_low(b) <= v / 16);
+    }
+    TS_ASSERT_EQUALS(latency_histogram::bucket_of(uint64_t(-1)),
+                     latency_histogram::NUM_BUCKETS - 1);
+  }
+
+  void test_quantiles(void) {
+    latency_histogram h;
+    TS_ASSERT_EQUALS(h.quantile(0.5), 0);
+    std::vector<uint64_t> values;
+    srand(2);
+    for (size_t i = 0; i < 20000; ++i) {
+      uint64_t v = rand() % 1000000;
+      values.push_back(v);
+      h.add(v);
+    }
+    std::sort(values.begin(), values.end());
+    TS_ASSERT_EQUALS(h.count(), values.size());
+    TS_ASSERT_EQUALS(h.max(), values.back());
+    double qs[4] = {0.0, 0.5, 0.99, 1.0};
+    for (size_t i = 0; i < 4; ++i) {
+      size_t rank = std::max<size_t>(1, (size_t)std::ceil(qs[i] * values.size()));
+      uint64_t exact = values[rank - 1];
+      uint64_t approx = h.quantile(qs[i]);
+      TS_ASSERT(approx >= exact);
+      TS_ASSERT(approx <= exact + exact / 16);
+    }
+  }
+
+  void test_merge_and_serialize(void) {
+    latency_histogram a, b;
+    for (uint64_t i = 0; i < 1000; ++i) a.add(i * 7);
+    for (uint64_t i = 0; i < 500; ++i) b.add(i * 1000003);
+    latency_histogram c(a);
+    c.merge(b);
+    TS_ASSERT_EQUALS(c.count(), 1500);
+    TS_ASSERT_EQUALS(c.total_sum(), a.total_sum() + b.total_sum());
+    TS_ASSERT_EQUALS(c.max(), b.max());
+
+    std::stringstream strm;
+    oarchive oarc(strm);
+    oarc << c;
+    strm.flush();
+    iarchive iarc(strm);
+    latency_histogram d;
+    d.add(5);
+    iarc >> d;
+    TS_ASSERT_EQUALS(d.count(), c.count());
+    TS_ASSERT_EQUALS(d.max(), c.max());
+    TS_ASSERT_EQUALS(d.quantile(0.3), c.quantile(0.3));
+    TS_ASSERT_EQUALS(d.quantile(0.9), c.quantile(0.9));
+  }
+
+  void test_concurrent_add(void) {
+    latency_histogram h;
+    thread_group thr;
+    for (size_t i = 0; i < 4; ++i) {
+      thr.launch(boost::bind(add_values, &h, 100000));
+    }
+    thr.join();
+    TS_ASSERT_EQUALS(h.count(), 400000);
+    TS_ASSERT_EQUALS(h.total_sum(), 4 * (100000ULL * 99999 / 2));
+    TS_ASSERT_EQUALS(h.max(), 99999);
+  }
+};
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/**
+ * Measures the time of PageRank style gather sweeps over a local_graph
+ * whose vertices are numbered in arrival order, by decreasing degree and
+ * in reverse Cuthill-McKee order.
+ *
+ * Usage: local_graph_order_bench [nverts] [avg_degree] [sweeps]
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <graphlab/util/empty.hpp>
+#include <graphlab/graph/local_graph.hpp>
+#include <graphlab/util/random.hpp>
+#include <graphlab/util/timer.hpp>
+#include <graphlab/macros_def.hpp>
+
+typedef graphlab::local_graph<double, graphlab::empty> graph_type;
+
+/**
+ * A power-law graph in which every vertex has a few neighbors with
+ * nearby ids, scrambled by a random relabeling to mimic the order in
+ * which ingress assigns the lvids.
+ */
+void make_graph(size_t nverts, size_t avg_degree,
+                std::vector<graphlab::lvid_type>& src,
+                std::vector<graphlab::lvid_type>& dst) {
+  graphlab::random::seed(0);
+  std::vector<graphlab::lvid_type> scramble(nverts);
+  for (size_t i = 0; i < nverts; ++i) scramble[i] = i;
+  graphlab::random::shuffle(scramble);
+  std::vector<double> prob(nverts);
+  for (size_t i = 0; i < nverts; ++i) prob[i] = std::pow(double(i + 1), -2.1);
+  graphlab::random::pdf2cdf(prob);
+  for (size_t v = 0; v < nverts; ++v) {
+    for (size_t j = 0; j < avg_degree; ++j) {
+      // half local neighbors, half power-law hubs
+      size_t u = (j % 2 == 0) ?
+          (v + 1 + graphlab::random::fast_uniform<size_t>(0, 63)) % nverts :
+          graphlab::random::multinomial_cdf(prob);
+      if (u == v) continue;
+      src.push_back(scramble[v]);
+      dst.push_back(scramble[u]);
+    }
+  }
+}
+
+double run(const std::string& method,
+           const std::vector<graphlab::lvid_type>& src,
+           const std::vector<graphlab::lvid_type>& dst,
+           size_t nverts, size_t sweeps) {
+  graph_type g;
+  g.resize(nverts);
+  for (size_t i = 0; i < src.size(); ++i) g.add_edge(src[i], dst[i]);
+  graphlab::timer ti; ti.start();
+  std::vector<graphlab::lvid_type> new_lvid;
+  g.reorder_vertices(method, new_lvid);
+  g.finalize();
+  const double prepare_time = ti.current_time();
+  for (size_t v = 0; v < nverts; ++v) g.vertex_data(v) = 1.0;
+
+  ti.start();
+  std::vector<double> next(nverts);
+  for (size_t s = 0; s < sweeps; ++s) {
+    for (size_t v = 0; v < nverts; ++v) {
+      double sum = 0;
+      foreach(graph_type::edge_type e, g.in_edges(v)) {
+        sum += e.source().data();
+      }
+      next[v] = 0.15 + 0.85 * sum / (g.num_in_edges(v) + 1);
+    }
+    for (size_t v = 0; v < nverts; ++v) g.vertex_data(v) = next[v];
+  }
+  const double sweep_time = ti.current_time();
+  std::cout << method << ":\treorder+finalize " << prepare_time
+            << " s\t" << sweeps << " sweeps " << sweep_time << " s"
+            << std::endl;
+  return sweep_time;
+}
+
+int main(int argc, char** argv) {
+  size_t nverts = argc > 1 ? atol(argv[1]) : 2000000;
+  size_t avg_degree = argc > 2 ? atol(argv[2]) : 16;
+  size_t sweeps = argc > 3 ? atol(argv[3]) : 5;
+  global_logger().set_log_level(LOG_WARNING);
+
+  std::vector<graphlab::lvid_type> src, dst;
+  make_graph(nverts, avg_degree, src, dst);
+  std::cout << nverts << " vertices, " << src.size() << " edges" << std::endl;
+
+  const double base = run("none", src, dst, nverts, sweeps);
+  const char* methods[] = {"degree", "rcm"};
+  for (size_t i = 0; i < 2; ++i) {
+    const double t = run(methods[i], src, dst, nverts, sweeps);
+    std::cout << "\tspeedup over arrival order: " << base / t << std::endl;
+  }
+  return 0;
+}
+
+#include <graphlab/macros_undef.hpp>
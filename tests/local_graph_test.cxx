@@ -29,6 +29,7 @@
 #include <graphlab/graph/local_graph.hpp>
 #include <graphlab/graph/dynamic_local_graph.hpp>
 #include <graphlab/util/random.hpp>
+#include <graphlab/util/empty.hpp>
 #include <graphlab/macros_def.hpp>
 
 /**
@@ -131,7 +132,100 @@ public:
     std::cout << "\n+ Pass test: grid dynamic graph test. :) \n";
   }
 
+  void test_reorder_vertices() {
+    graphlab::local_graph<vertex_data, edge_data> g;
+    test_reorder_vertices_impl(g, "degree");
+    test_reorder_vertices_impl(g, "rcm");
+    std::cout << "\n+ Pass test: graph reorder vertices. :) \n";
+
+    graphlab::dynamic_local_graph<vertex_data, edge_data> g2;
+    test_reorder_vertices_impl(g2, "degree");
+    test_reorder_vertices_impl(g2, "rcm");
+    std::cout << "\n+ Pass test: dynamic graph reorder vertices. :) \n";
+  }
+
+  void test_empty_edge_data() {
+    typedef graphlab::local_graph<vertex_data, graphlab::empty> graph_type;
+    typedef graph_type::edge_type edge_type;
+    graph_type g;
+    const size_t nverts = 200;
+    for (size_t i = 0; i < nverts; ++i) g.add_vertex(i, vertex_data(i));
+    for (size_t i = 0; i < nverts; ++i) {
+      for (size_t j = 1; j < 20; j += 3) {
+        // descending targets so that the out edges are stored unsorted
+        g.add_edge(i, (i + nverts - j * 7) % nverts);
+        // and some duplicate edges
+        if (j % 2) g.add_edge(i, (i + nverts - j * 7) % nverts);
+      }
+    }
+    g.finalize();
+    // out edge ids are distinct, and every in edge reports the id of a
+    // distinct out edge with the same endpoints
+    typedef std::pair<size_t, size_t> key_type;
+    std::map<graphlab::edge_id_type, key_type> out_edges;
+    for (size_t i = 0; i < nverts; ++i) {
+      foreach(edge_type e, g.out_edges(i)) {
+        ASSERT_LT(e.id(), g.num_edges());
+        ASSERT_TRUE(out_edges.count(e.id()) == 0);
+        out_edges[e.id()] = key_type(e.source().id(), e.target().id());
+      }
+    }
+    std::vector<bool> used(g.num_edges(), false);
+    size_t nedges = 0;
+    for (size_t i = 0; i < nverts; ++i) {
+      foreach(edge_type e, g.in_edges(i)) {
+        ASSERT_EQ(e.target().id(), i);
+        ASSERT_TRUE(out_edges.count(e.id()) == 1);
+        ASSERT_TRUE(out_edges[e.id()] ==
+                    key_type(e.source().id(), e.target().id()));
+        ASSERT_FALSE(used[e.id()]);
+        used[e.id()] = true;
+        ++nedges;
+      }
+    }
+    ASSERT_EQ(nedges, g.num_edges());
+    std::cout << "\n+ Pass test: graph without edge data. :) \n";
+  }
+
 private: 
+  template<typename Graph>
+  void test_reorder_vertices_impl(Graph& g, const std::string& method) {
+    typedef typename Graph::edge_type edge_type;
+    g.clear();
+    const size_t nverts = 1000;
+    for (size_t i = 0; i < nverts; ++i) g.add_vertex(i, vertex_data(i));
+    // a few hubs connected to a ring
+    for (size_t i = 0; i < nverts; ++i) {
+      g.add_edge(i, (i + 1) % nverts, edge_data(i, (i + 1) % nverts));
+      if (i % 10 > 1) g.add_edge(i, i - i % 10, edge_data(i, i - i % 10));
+    }
+    std::vector<graphlab::lvid_type> new_lvid;
+    TS_ASSERT(!g.reorder_vertices("none", new_lvid));
+    TS_ASSERT(g.reorder_vertices(method, new_lvid));
+    g.finalize();
+    ASSERT_EQ(new_lvid.size(), nverts);
+    std::vector<bool> used(nverts, false);
+    for (size_t i = 0; i < nverts; ++i) {
+      ASSERT_LT(new_lvid[i], nverts);
+      ASSERT_FALSE(used[new_lvid[i]]);
+      used[new_lvid[i]] = true;
+      // the vertex data moved with the vertex
+      ASSERT_EQ(g.vertex_data(new_lvid[i]).value, i);
+    }
+    // every edge connects the renumbered endpoints
+    size_t nedges = 0;
+    for (size_t i = 0; i < nverts; ++i) {
+      foreach(edge_type e, g.out_edges(i)) {
+        ASSERT_EQ(new_lvid[e.data().from], e.source().id());
+        ASSERT_EQ(new_lvid[e.data().to], e.target().id());
+        ++nedges;
+      }
+    }
+    ASSERT_EQ(nedges, g.num_edges());
+    // the hubs come first
+    if (method == "degree") ASSERT_LT(new_lvid[0], nverts / 10);
+  }
+
   template<typename Graph>
   void test_add_vertex_impl(Graph& g, size_t nverts) {
     g.clear();
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <set>
+#include <vector>
+#include <cstdlib>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/util/mirror_set.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+#include <graphlab/macros_def.hpp>
+using namespace graphlab;
+
+class MirrorSetTestSuite : public CxxTest::TestSuite {
+public:
+  // checks every way of reading s against the ids in expected
+  void check(const mirror_set& s, const std::set<size_t>& expected,
+             size_t maxid) {
+    TS_ASSERT_EQUALS(s.popcount(), expected.size());
+    TS_ASSERT_EQUALS(s.empty(), expected.empty());
+    for (size_t i = 0; i < maxid; ++i) {
+      TS_ASSERT_EQUALS(s.get(i), expected.count(i) > 0);
+    }
+    std::vector<size_t> ids;
+    foreach(size_t id, s) ids.push_back(id);
+    TS_ASSERT(ids == std::vector<size_t>(expected.begin(), expected.end()));
+    size_t b = 0;
+    TS_ASSERT_EQUALS(s.first_bit(b), !expected.empty());
+    if (!expected.empty()) {
+      TS_ASSERT_EQUALS(b, *expected.begin());
+      size_t n = 1;
+      while (s.next_bit(b)) ++n;
+      TS_ASSERT_EQUALS(n, expected.size());
+      TS_ASSERT_EQUALS(b, *expected.rbegin());
+    }
+  }
+
+  void test_representations(void) {
+    // inline bitset
+    mirror_set s;
+    std::set<size_t> expected;
+    check(s, expected, 300);
+    size_t small_ids[6] = {0, 5, 17, 40, 61, 62};
+    for (size_t i = 0; i < 6; ++i) {
+      TS_ASSERT_EQUALS(s.set_bit(small_ids[i]), false);
+      expected.insert(small_ids[i]);
+    }
+    TS_ASSERT_EQUALS(s.set_bit(17), true);
+    check(s, expected, 300);
+    // a large id moves to the heap bitset
+    s.set_bit(250);
+    expected.insert(250);
+    check(s, expected, 300);
+    // which grows
+    s.set_bit(1000);
+    expected.insert(1000);
+    check(s, expected, 1100);
+    TS_ASSERT_EQUALS(s.clear_bit(1000), true);
+    TS_ASSERT_EQUALS(s.clear_bit(1000), false);
+    expected.erase(1000);
+    check(s, expected, 1100);
+
+    // inline list
+    mirror_set l;
+    expected.clear();
+    size_t large_ids[3] = {300, 64, 65535};
+    for (size_t i = 0; i < 3; ++i) {
+      l.set_bit(large_ids[i]);
+      expected.insert(large_ids[i]);
+      check(l, expected, 400);
+    }
+    TS_ASSERT_EQUALS(l.set_bit(64), true);
+    l.clear_bit(300);
+    expected.erase(300);
+    check(l, expected, 400);
+    // a fourth id which fits the inline bitset, and one which does not
+    l.clear_bit(65535);
+    l.set_bit(1);
+    l.set_bit(2);
+    expected.erase(65535);
+    expected.insert(1);
+    expected.insert(2);
+    check(l, expected, 400);
+    l.clear_bit(64);
+    l.set_bit(3);
+    l.set_bit(4);
+    expected.erase(64);
+    expected.insert(3);
+    expected.insert(4);
+    check(l, expected, 400);
+    l.set_bit(200);
+    expected.insert(200);
+    check(l, expected, 400);
+
+    l.clear();
+    check(l, std::set<size_t>(), 400);
+  }
+
+  void test_copy_compare_serialize(void) {
+    srand(1);
+    for (size_t trial = 0; trial < 200; ++trial) {
+      const size_t maxid = trial % 2 ? 64 : 512;
+      mirror_set a, b;
+      std::set<size_t> expected;
+      const size_t n = rand() % 8;
+      for (size_t i = 0; i < n; ++i) {
+        const size_t id = rand() % maxid;
+        a.set_bit(id);
+        expected.insert(id);
+      }
+      // the same ids inserted in the other order
+      for (std::set<size_t>::reverse_iterator it = expected.rbegin();
+           it != expected.rend(); ++it) {
+        b.set_bit(*it);
+      }
+      TS_ASSERT(a == b);
+      mirror_set c(a);
+      TS_ASSERT(c == a);
+      c.set_bit(maxid);
+      TS_ASSERT(c != a);
+      c = b;
+      TS_ASSERT(c == a);
+      check(c, expected, maxid + 1);
+
+      mirror_set u = a | c;
+      TS_ASSERT(u == a);
+      u |= mirror_set();
+      TS_ASSERT(u == a);
+
+      std::stringstream strm;
+      oarchive oarc(strm);
+      oarc << a;
+      strm.flush();
+      iarchive iarc(strm);
+      mirror_set d;
+      d.set_bit(7);
+      iarc >> d;
+      TS_ASSERT(d == a);
+      check(d, expected, maxid + 1);
+    }
+  }
+};
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/scheduler/priority_scheduler.hpp>
+#include "scheduler_rounds.hpp"
+using namespace graphlab;
+
+double vertex_priority(lvid_type v, size_t t) {
+  return v % 7;
+}
+
+class PrioritySchedulerTestSuite : public CxxTest::TestSuite {
+public:
+  void test_order(void) {
+    // a single heap pops in exact priority order
+    graphlab_options opts;
+    opts.set_ncpus(1);
+    opts.get_scheduler_args().set_option("multi", 1);
+    priority_scheduler sched(NUM_VERTICES, opts);
+    for (size_t i = 0; i < NUM_VERTICES; ++i) {
+      sched.schedule(i, double((i * 37) % NUM_VERTICES));
+    }
+    // already scheduled
+    sched.schedule(0, 1e10);
+    TS_ASSERT(!sched.empty());
+    double last = 1e10;
+    lvid_type v;
+    for (size_t i = 0; i < NUM_VERTICES; ++i) {
+      TS_ASSERT_EQUALS(sched.get_next(0, v), sched_status::NEW_TASK);
+      const double priority = double((v * 37) % NUM_VERTICES);
+      TS_ASSERT_LESS_THAN(priority, last);
+      last = priority;
+    }
+    TS_ASSERT_EQUALS(sched.get_next(0, v), sched_status::EMPTY);
+    TS_ASSERT(sched.empty());
+  }
+
+  void test_min_priority(void) {
+    graphlab_options opts;
+    opts.set_ncpus(4);
+    opts.get_scheduler_args().set_option("min_priority", 10.0);
+    priority_scheduler sched(NUM_VERTICES, opts);
+    for (size_t i = 0; i < NUM_VERTICES; ++i) sched.schedule(i, i % 20);
+    std::vector<size_t> count(NUM_VERTICES, 0);
+    lvid_type v;
+    for (size_t i = 0; sched.get_next(i % 4, v) == sched_status::NEW_TASK; ++i) {
+      TS_ASSERT_LESS_THAN_EQUALS(10, v % 20);
+      ++count[v];
+    }
+    for (size_t i = 0; i < NUM_VERTICES; ++i) {
+      TS_ASSERT_EQUALS(count[i], size_t(i % 20 >= 10));
+    }
+    TS_ASSERT(sched.empty());
+  }
+
+  void test_scheduler_fibers(void) {
+    test_scheduler_rounds<priority_scheduler>(graphlab_options(),
+                                              vertex_priority, true);
+  }
+
+  void test_scheduler_threads(void) {
+    test_scheduler_rounds<priority_scheduler>(graphlab_options(),
+                                              vertex_priority, false);
+  }
+};
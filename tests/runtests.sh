@@ -9,16 +9,18 @@ function quit_if_bad_retvalue {
   fi
 }
 
+# test_rpc_prog program expected_output [number of processes, default 2]
 function test_rpc_prog {
+  nprocs=${3:-2}
   echo "Testing $1 ..."
   echo "---------$1-------------" >> $stdoutfname
   echo "---------$1-------------" >> $stderrfname 
-  mpiexec -n 2 -host $localhostname ./$1  >> $stdoutfname 2>> $stderrfname
+  mpiexec -n $nprocs -host $localhostname ./$1  >> $stdoutfname 2>> $stderrfname
   if [ $? -ne 0 ]; then
     echo "FAIL. Program returned with failure"
     exit 1
   fi
-  str="mpiexec -n 2 -host $localhostname ./$1 2> /dev/null | grep \"$2\""
+  str="mpiexec -n $nprocs -host $localhostname ./$1 2> /dev/null | grep \"$2\""
   #echo $str
   e=`eval $str`
   if [ -z "$e" ] ; then
@@ -303,6 +305,9 @@ test_rpc_prog rpc_example4 "1.a = 10\\|10.b = 0\\|string = hello world!"
 test_rpc_prog rpc_example5 "1 + 2.000000 = three"
 test_rpc_prog rpc_example6 "10\\|15\\|hello world\\|10.5\\|10"
 test_rpc_prog rpc_example7 "set from 1\\|set from 1\\|set from 0\\|set from 0\\|set from 1\\|set from 1\\|set from 0\\|set from 0"
+# the collectives fold in the machines past the largest power of 2
+test_rpc_prog dc_collectives_test "Collectives passed on 2 machines"
+test_rpc_prog dc_collectives_test "Collectives passed on 3 machines" 3
 
 echo
 echo "Distributed GraphLab Tests"
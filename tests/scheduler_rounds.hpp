@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_TESTS_SCHEDULER_ROUNDS_HPP
+#define GRAPHLAB_TESTS_SCHEDULER_ROUNDS_HPP
+
+#include <vector>
+#include <boost/bind.hpp>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/fiber_group.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/options/graphlab_options.hpp>
+#include <graphlab/scheduler/ischeduler.hpp>
+
+using namespace graphlab;
+
+const size_t NUM_VERTICES = 1001;
+const size_t ROUNDS = 50;
+
+/// The priority of the t-th scheduling of vertex v
+typedef double (*round_priority_type)(lvid_type v, size_t t);
+
+template <typename SchedulerType>
+struct scheduler_rounds {
+  SchedulerType& sched;
+  round_priority_type priority;
+  std::vector<atomic<size_t> > taken;
+  atomic<size_t> total_taken;
+
+  scheduler_rounds(SchedulerType& sched, round_priority_type priority)
+      : sched(sched), priority(priority), taken(NUM_VERTICES) { }
+
+  // runs every vertex ROUNDS times. Only the worker which ran a vertex
+  // schedules it again, so no scheduling is merged with another.
+  void worker(size_t cpuid, bool in_fiber) {
+    while (total_taken.value < NUM_VERTICES * ROUNDS) {
+      lvid_type v;
+      if (sched.get_next(cpuid, v) == sched_status::NEW_TASK) {
+        total_taken.inc();
+        const size_t t = taken[v].inc();
+        if (t < ROUNDS) sched.schedule(v, priority(v, t));
+      } else if (in_fiber) {
+        fiber_control::yield();
+      } else {
+        sched_yield();
+      }
+    }
+  }
+};
+
+/**
+ * Runs every vertex of a new scheduler ROUNDS times, from 4 threads or
+ * from 4 fibers per fiber worker, and checks that each vertex ran exactly
+ * ROUNDS times. opts carries the scheduler arguments; the number of cpus
+ * is set here.
+ */
+template <typename SchedulerType>
+void test_scheduler_rounds(graphlab_options opts,
+                           round_priority_type priority,
+                           bool in_fibers) {
+  const size_t ncpus =
+      in_fibers ? fiber_control::get_instance().num_workers() : 4;
+  opts.set_ncpus(ncpus);
+  SchedulerType sched(NUM_VERTICES, opts);
+  scheduler_rounds<SchedulerType> rounds(sched, priority);
+  for (size_t i = 0; i < NUM_VERTICES; ++i) sched.schedule(i, priority(i, 0));
+  if (in_fibers) {
+    fiber_group group;
+    for (size_t i = 0; i < 4 * ncpus; ++i) {
+      group.launch(boost::bind(&scheduler_rounds<SchedulerType>::worker,
+                               &rounds, i % ncpus, true),
+                   i % ncpus);
+    }
+    group.join();
+  } else {
+    thread_group thr;
+    for (size_t i = 0; i < ncpus; ++i) {
+      thr.launch(boost::bind(&scheduler_rounds<SchedulerType>::worker,
+                             &rounds, i, false));
+    }
+    thr.join();
+  }
+  for (size_t i = 0; i < NUM_VERTICES; ++i) {
+    TS_ASSERT_EQUALS(rounds.taken[i].value, ROUNDS);
+  }
+  lvid_type v;
+  TS_ASSERT_EQUALS(sched.get_next(0, v), sched_status::EMPTY);
+  TS_ASSERT(sched.empty());
+}
+
+#endif
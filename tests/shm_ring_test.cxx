@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#include <vector>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/rpc/shm_ring.hpp>
+using namespace graphlab;
+using namespace graphlab::dc_impl;
+
+const size_t STREAM_LENGTH = 10000000;
+
+// writes the byte sequence i % 251 in chunks of random length
+void ring_writer(shm_ring* ring) {
+  std::vector<char> buf(1000);
+  unsigned int seed = 1;
+  size_t pos = 0;
+  while (pos < STREAM_LENGTH) {
+    size_t len = std::min<size_t>(rand_r(&seed) % buf.size() + 1,
+                                  STREAM_LENGTH - pos);
+    for (size_t i = 0; i < len; ++i) buf[i] = char((pos + i) % 251);
+    size_t written = 0;
+    while (written < len) {
+      written += ring->write(&buf[written], len - written);
+    }
+    pos += len;
+  }
+}
+
+class ShmRingTestSuite : public CxxTest::TestSuite {
+public:
+  void test_single_thread(void) {
+    std::vector<char> mem(shm_ring::memory_size(16), 0);
+    shm_ring ring;
+    ring.attach(&mem[0], 16);
+    char out[32];
+    TS_ASSERT_EQUALS(ring.read(out, 32), 0);
+    TS_ASSERT_EQUALS(ring.write("abcdefghij", 10), 10);
+    TS_ASSERT_EQUALS(ring.read(out, 4), 4);
+    // wraps around, and stops when full
+    TS_ASSERT_EQUALS(ring.write("klmnopqrstuvwxyz", 16), 10);
+    TS_ASSERT_EQUALS(ring.read_available(), 16);
+    TS_ASSERT_EQUALS(ring.read(out, 32), 16);
+    TS_ASSERT_EQUALS(std::string(out, 16), "efghijklmnopqrst");
+    TS_ASSERT_EQUALS(ring.read_available(), 0);
+  }
+
+  void test_stream(void) {
+    const size_t capacity = 4096;
+    std::vector<char> mem(shm_ring::memory_size(capacity), 0);
+    shm_ring ring;
+    ring.attach(&mem[0], capacity);
+    thread_group thr;
+    thr.launch(boost::bind(ring_writer, &ring));
+    std::vector<char> buf(700);
+    size_t pos = 0;
+    bool ok = true;
+    while (pos < STREAM_LENGTH) {
+      size_t n = ring.read(&buf[0], buf.size());
+      for (size_t i = 0; i < n; ++i) {
+        ok &= (buf[i] == char((pos + i) % 251));
+      }
+      pos += n;
+    }
+    thr.join();
+    TS_ASSERT(ok);
+    TS_ASSERT_EQUALS(pos, STREAM_LENGTH);
+    TS_ASSERT_EQUALS(ring.read_available(), 0);
+  }
+};
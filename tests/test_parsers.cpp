@@ -117,6 +117,129 @@ void test_save_load(graphlab::distributed_control& dc) {
 
 }
 
+/*
+ * Loads the saved graph again with chunks much smaller than the files,
+ * so that most lines straddle or start exactly at a chunk boundary.
+ */
+void test_chunked_load(graphlab::distributed_control& dc) {
+  graphlab::distributed_graph<size_t, size_t> graph(dc);
+  graph.load_format("data/plawtest_tsv", "tsv");
+  graph.finalize();
+
+  graphlab::graphlab_options opts;
+  opts.get_graph_args().set_option("load_chunk_size", 7);
+  graphlab::distributed_graph<size_t, size_t> graph2(dc, opts);
+  graph2.load_format("data/plawtest_tsv", "tsv");
+  graph2.finalize();
+  ASSERT_EQ(graph.num_vertices(), graph2.num_vertices());
+  ASSERT_EQ(graph.num_edges(), graph2.num_edges());
+
+  graphlab::distributed_graph<size_t, size_t> graph3(dc, opts);
+  graph3.load_format("data/test_tsv", "tsv");
+  graph3.finalize();
+  check_structure(graph3);
+}
+
+/*
+ * Loads the saved graph with the restreaming ingress methods, which must
+ * place every edge exactly once.
+ */
+void test_restream_ingress(graphlab::distributed_control& dc) {
+  graphlab::distributed_graph<size_t, size_t> graph(dc);
+  graph.load_format("data/plawtest_tsv", "tsv");
+  graph.finalize();
+
+  const char* methods[] = {"hdrf", "fennel"};
+  for (size_t i = 0; i < 2; ++i) {
+    graphlab::graphlab_options opts;
+    opts.get_graph_args().set_option("ingress", methods[i]);
+    opts.get_graph_args().set_option("restream_passes", 3);
+    graphlab::distributed_graph<size_t, size_t> graph2(dc, opts);
+    graph2.load_format("data/plawtest_tsv", "tsv");
+    graph2.finalize();
+    ASSERT_EQ(graph.num_vertices(), graph2.num_vertices());
+    ASSERT_EQ(graph.num_edges(), graph2.num_edges());
+  }
+}
+
+/*
+ * The first load fills the partition cache, the second one must map it
+ * instead of parsing the input.
+ */
+void test_partition_cache(graphlab::distributed_control& dc) {
+  graphlab::graphlab_options opts;
+  opts.get_graph_args().set_option("partition_cache", "data/plawtest_cache");
+  graphlab::distributed_graph<size_t, size_t> graph(dc, opts);
+  graph.load_format("data/plawtest_tsv", "tsv");
+  graph.finalize();
+
+  graphlab::distributed_graph<size_t, size_t> graph2(dc, opts);
+  graph2.load_format("data/plawtest_tsv", "tsv");
+  ASSERT_TRUE(graph2.is_finalized());
+  graph2.finalize();
+  ASSERT_EQ(graph.num_vertices(), graph2.num_vertices());
+  ASSERT_EQ(graph.num_edges(), graph2.num_edges());
+  ASSERT_EQ(graph.num_replicas(), graph2.num_replicas());
+
+  // a corrupted cache file on machine 0 makes all machines load the
+  // input again, and rewrites the cache
+  dc.full_barrier();
+  if (dc.procid() == 0) {
+    const std::string suffix = "." + graphlab::tostr(dc.procid()) + ".gbin";
+    boost::filesystem::directory_iterator it("data"), end;
+    for (; it != end; ++it) {
+      const std::string name = it->path().filename().string();
+      if (boost::starts_with(name, "plawtest_cache_") &&
+          boost::ends_with(name, suffix)) {
+        // the file opens, but its edge count does not match its sections
+        std::fstream f(it->path().string().c_str(),
+                       std::ios::in | std::ios::out | std::ios::binary);
+        graphlab::mmap_graph_format::header hdr;
+        f.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+        ++hdr.num_local_edges;
+        f.seekp(0);
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+      }
+    }
+  }
+  dc.full_barrier();
+  graphlab::distributed_graph<size_t, size_t> graph3(dc, opts);
+  graph3.load_format("data/plawtest_tsv", "tsv");
+  ASSERT_FALSE(graph3.is_finalized());
+  graph3.finalize();
+  ASSERT_EQ(graph.num_vertices(), graph3.num_vertices());
+  ASSERT_EQ(graph.num_edges(), graph3.num_edges());
+
+  graphlab::distributed_graph<size_t, size_t> graph4(dc, opts);
+  graph4.load_format("data/plawtest_tsv", "tsv");
+  ASSERT_TRUE(graph4.is_finalized());
+  ASSERT_EQ(graph.num_edges(), graph4.num_edges());
+}
+
+/*
+ * With hybrid ingress, a master with few in edges holds all of them.
+ */
+void test_hybrid_ingress(graphlab::distributed_control& dc) {
+  graphlab::distributed_graph<size_t, size_t> graph(dc);
+  graph.load_format("data/plawtest_tsv", "tsv");
+  graph.finalize();
+
+  graphlab::graphlab_options opts;
+  opts.get_graph_args().set_option("ingress", "hybrid");
+  opts.get_graph_args().set_option("hybrid_threshold", 5);
+  graphlab::distributed_graph<size_t, size_t> graph2(dc, opts);
+  graph2.load_format("data/plawtest_tsv", "tsv");
+  graph2.finalize();
+  ASSERT_EQ(graph.num_vertices(), graph2.num_vertices());
+  ASSERT_EQ(graph.num_edges(), graph2.num_edges());
+  for (graphlab::lvid_type lvid = 0; lvid < graph2.num_local_vertices(); ++lvid) {
+    const size_t num_in_edges = graph2.l_get_vertex_record(lvid).num_in_edges;
+    if (graph2.l_is_master(lvid) && num_in_edges <= 5) {
+      ASSERT_EQ(graph2.l_num_in_edges(lvid), num_in_edges);
+    }
+  }
+}
+
 
 int main(int argc, char** argv) {
   graphlab::distributed_control dc;
@@ -125,5 +248,9 @@ int main(int argc, char** argv) {
   test_tsv(dc);
   test_powerlaw(dc);
   test_save_load(dc);
+  test_chunked_load(dc);
+  test_restream_ingress(dc);
+  test_partition_cache(dc);
+  test_hybrid_ingress(dc);
 };
 
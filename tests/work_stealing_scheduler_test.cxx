@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#include <vector>
+#include <boost/bind.hpp>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/util/chase_lev_deque.hpp>
+#include <graphlab/scheduler/work_stealing_scheduler.hpp>
+#include "scheduler_rounds.hpp"
+using namespace graphlab;
+
+const size_t NUM_ITEMS = 1000000;
+
+std::vector<atomic<size_t> > taken;
+atomic<size_t> total_taken;
+
+// pushes NUM_ITEMS ids, popping some of them back
+void deque_owner(chase_lev_deque<size_t>* d) {
+  size_t v;
+  for (size_t i = 0; i < NUM_ITEMS; ++i) {
+    d->push(i);
+    if (i % 3 == 0 && d->pop(v)) {
+      taken[v].inc();
+      total_taken.inc();
+    }
+  }
+  while (total_taken.value < NUM_ITEMS) {
+    if (d->pop(v)) {
+      taken[v].inc();
+      total_taken.inc();
+    }
+  }
+}
+
+void deque_thief(chase_lev_deque<size_t>* d) {
+  size_t v;
+  while (total_taken.value < NUM_ITEMS) {
+    if (d->steal(v)) {
+      taken[v].inc();
+      total_taken.inc();
+    }
+  }
+}
+
+// the work stealing scheduler ignores priorities
+double no_priority(lvid_type v, size_t t) {
+  return 1;
+}
+
+class WorkStealingSchedulerTestSuite : public CxxTest::TestSuite {
+public:
+  void test_deque(void) {
+    chase_lev_deque<size_t> d(4);
+    size_t v = 0;
+    TS_ASSERT(!d.pop(v));
+    TS_ASSERT(!d.steal(v));
+    // grows past the initial capacity
+    for (size_t i = 0; i < 100; ++i) d.push(i);
+    TS_ASSERT_EQUALS(d.size(), 100);
+    TS_ASSERT(d.steal(v));
+    TS_ASSERT_EQUALS(v, 0);
+    TS_ASSERT(d.pop(v));
+    TS_ASSERT_EQUALS(v, 99);
+    TS_ASSERT_EQUALS(d.size(), 98);
+  }
+
+  void test_concurrent_steal(void) {
+    chase_lev_deque<size_t> d;
+    taken.clear();
+    taken.resize(NUM_ITEMS);
+    total_taken.value = 0;
+    thread_group thr;
+    thr.launch(boost::bind(deque_owner, &d));
+    for (size_t i = 0; i < 3; ++i) thr.launch(boost::bind(deque_thief, &d));
+    thr.join();
+    // every element is taken exactly once
+    for (size_t i = 0; i < NUM_ITEMS; ++i) {
+      TS_ASSERT_EQUALS(taken[i].value, 1);
+    }
+    TS_ASSERT(d.empty());
+  }
+
+  void test_scheduler_fibers(void) {
+    test_scheduler_rounds<work_stealing_scheduler>(graphlab_options(),
+                                                   no_priority, true);
+  }
+
+  void test_scheduler_threads(void) {
+    test_scheduler_rounds<work_stealing_scheduler>(graphlab_options(),
+                                                   no_priority, false);
+  }
+};
@@ -87,6 +87,11 @@ struct min_distance_type : graphlab::IS_POD_TYPE {
     dist = std::min(dist, other.dist);
     return *this;
   }
+  // closer vertices first, so that the priority and bucket schedulers
+  // relax the frontier in distance order
+  double priority() const {
+    return -double(dist);
+  }
 };
 
 
@@ -95,7 +100,7 @@ struct min_distance_type : graphlab::IS_POD_TYPE {
  */
 class sssp :
   public graphlab::ivertex_program<graph_type, 
-                                   graphlab::empty,
+                                   min_distance_type,
                                    min_distance_type>,
   public graphlab::IS_POD_TYPE {
   distance_type min_dist;
@@ -117,21 +122,32 @@ public:
   }; // end of gather_edges 
 
 
-  // /** 
-  //  * \brief Collect the distance to the neighbor
-  //  */
-  // min_distance_type gather(icontext_type& context, const vertex_type& vertex, 
-  //                          edge_type& edge) const {
-  //   return min_distance_type(edge.data() + 
-  //                            get_other_vertex(edge, vertex).data());
-  // } // end of gather function
+  /**
+   * \brief When the direction optimizing synchronous engine pulls,
+   * the distance is gathered from the neighbors instead
+   */
+  edge_dir_type pull_edges(icontext_type& context,
+                           const vertex_type& vertex) const {
+    return DIRECTED_SSSP? graphlab::IN_EDGES : graphlab::ALL_EDGES;
+  }; // end of pull_edges
+
+
+  /** 
+   * \brief Collect the distance to the neighbor
+   */
+  min_distance_type gather(icontext_type& context, const vertex_type& vertex, 
+                           edge_type& edge) const {
+    return min_distance_type(edge.data().dist +
+                             get_other_vertex(edge, vertex).data().dist);
+  } // end of gather function
 
 
   /**
    * \brief If the distance is smaller then update
    */
   void apply(icontext_type& context, vertex_type& vertex,
-             const graphlab::empty& empty) {
+             const min_distance_type& total) {
+    min_dist = std::min(min_dist, total.dist);
     changed = false;
     if(vertex.data().dist > min_dist) {
       changed = true;